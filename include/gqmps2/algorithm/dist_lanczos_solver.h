@@ -0,0 +1,536 @@
+// SPDX-License-Identifier: LGPL-3.0-only
+
+/*
+* Author: Rongyang Sun <sun-rongyang@outlook.com>
+* Creation Date: 2020-10-17 09:30
+*
+* Description: GraceQ/MPS2 project. Lanczos solver distributed over local
+*              processes.
+*/
+
+/**
+@file dist_lanczos_solver.h
+@brief A Lanczos solver whose effective Hamiltonian and Krylov bases are
+       distributed over several local processes.
+
+Each environment tensor is split by the quantum number sectors of its MPO bond
+(the 1th index). Process r only holds the blocks of the sectors assigned to it
+by PartitionMPOBond, which is called a slice of the environment. No process
+holds a full environment, neither when the environments are initialized nor
+when they grow during the sweep: the slices of a new environment are summed
+up from the partial contractions of all of the processes and scattered to
+their owners, see DistCtrctLEnv and DistCtrctREnv.
+
+The effective Hamiltonian multiplication of the central update runs in two
+stages. Each process contracts its slice of the left environment with the
+state and the two MPO local tensors, then the results are reduced and scattered
+by the MPO bond of the right environment. At last each process contracts the
+received part with its slice of the right environment. The result is left as
+a partial sum on each process.
+
+The k-th Krylov basis is only held by the process with rank k % size. The
+inner products are reduced over the processes and all of the processes run
+the same tridiagonal solver, so they take the same decisions without extra
+messages. Only the latest basis is broadcast to all of the processes for the
+next multiplication, and only for that multiplication.
+*/
+#ifndef GQMPS2_ALGORITHM_DIST_LANCZOS_SOLVER_H
+#define GQMPS2_ALGORITHM_DIST_LANCZOS_SOLVER_H
+
+
+#include "gqmps2/algorithm/lanczos_solver.h"    // LanczosParams, LanczosRes, eff_ham_mul_state_*
+#include "gqmps2/one_dim_tn/mpo/mpo.h"          // MPO
+#include "gqmps2/local_proc_comm.h"             // LocalProcComm
+#include "gqten/gqten.h"
+
+#include <iostream>
+#include <vector>       // vector
+#include <string>       // string
+#include <algorithm>    // stable_sort, min_element
+
+#ifdef Release
+  #define NDEBUG
+#endif
+#include <assert.h>
+
+
+namespace gqmps2 {
+using namespace gqten;
+
+
+// Helpers
+/**
+Partition a MPO bond into groups of quantum number sectors. The sectors are
+assigned to the least loaded process, the largest sector first. An index and
+its inverse give the same partition, so both sides of a bond agree on it.
+
+@return The actual coordinates of the MPO bond held by each process.
+*/
+template <typename QNT>
+std::vector<std::vector<size_t>> PartitionMPOBond(
+    const Index<QNT> &mpo_bond, const size_t proc_num
+) {
+  std::vector<QNT> sct_qns;
+  std::vector<std::vector<size_t>> sct_coors;
+  for (size_t x = 0; x < mpo_bond.dim(); ++x) {
+    auto qn = mpo_bond.GetQNSctFromActualCoor(x).GetQn();
+    size_t sct_idx = 0;
+    while (sct_idx < sct_qns.size() && sct_qns[sct_idx] != qn) { ++sct_idx; }
+    if (sct_idx == sct_qns.size()) {
+      sct_qns.push_back(qn);
+      sct_coors.push_back({});
+    }
+    sct_coors[sct_idx].push_back(x);
+  }
+  std::vector<size_t> sct_order(sct_coors.size());
+  for (size_t i = 0; i < sct_order.size(); ++i) { sct_order[i] = i; }
+  std::stable_sort(
+      sct_order.begin(), sct_order.end(),
+      [&sct_coors](const size_t a, const size_t b) {
+        return sct_coors[a].size() > sct_coors[b].size();
+      }
+  );
+  std::vector<std::vector<size_t>> proc_coors(proc_num);
+  std::vector<size_t> proc_loads(proc_num, 0);
+  for (auto sct_idx : sct_order) {
+    auto proc = std::min_element(proc_loads.begin(), proc_loads.end()) -
+                proc_loads.begin();
+    proc_loads[proc] += sct_coors[sct_idx].size();
+    proc_coors[proc].insert(
+        proc_coors[proc].end(),
+        sct_coors[sct_idx].begin(), sct_coors[sct_idx].end()
+    );
+  }
+  return proc_coors;
+}
+
+
+/**
+Project an index of a tensor to the given coordinates. The index keeps its
+position and its full dimension, only the blocks of the other coordinates
+are dropped.
+
+@return The projected tensor, or nullptr if no coordinate is given.
+*/
+template <typename TenT>
+TenT *ProjectTenIndex(
+    const TenT &ten, const size_t idx, const std::vector<size_t> &coors
+) {
+  if (coors.empty()) { return nullptr; }
+  auto index = ten.GetIndexes()[idx];
+  TenT proj({InverseIndex(index), index});
+  for (auto x : coors) { proj({x, x}) = 1.0; }
+  TenT temp;
+  Contract(&ten, &proj, {{idx}, {0}}, &temp);
+  auto rank = ten.Rank();
+  if (idx != rank - 1) {
+    std::vector<size_t> order;
+    for (size_t i = 0; i < idx; ++i) { order.push_back(i); }
+    order.push_back(rank - 1);
+    for (size_t i = idx; i < rank - 1; ++i) { order.push_back(i); }
+    temp.Transpose(order);
+  }
+  return new TenT(std::move(temp));
+}
+
+
+/// Position of the right MPO bond of the MPO local tensor on the given site.
+template <typename TenT>
+inline size_t MPORightBondIdx(const MPO<TenT> &, const size_t site) {
+  return (site == 0) ? 1 : 3;
+}
+
+
+/// Position of the left MPO bond of the MPO local tensor on the given site.
+template <typename TenT>
+inline size_t MPOLeftBondIdx(const MPO<TenT> &mpo, const size_t site) {
+  return (site == mpo.size() - 1) ? 1 : 0;
+}
+
+
+/**
+Grow a left environment by one site, following the contraction of the serial
+sweep.
+
+@param plenv The left environment, nullptr if the site is the first one.
+*/
+template <typename TenT>
+TenT *CtrctLEnv(const TenT *plenv, const TenT &mps_ten, const TenT &mpo_ten) {
+  auto mps_ten_dag = Dag(mps_ten);
+  auto res = new TenT;
+  if (plenv == nullptr) {
+    TenT temp;
+    Contract(&mps_ten, &mpo_ten, {{0}, {0}}, &temp);
+    Contract(&temp, &mps_ten_dag, {{2}, {0}}, res);
+  } else {
+    TenT temp1, temp2;
+    Contract(plenv, &mps_ten, {{0}, {0}}, &temp1);
+    Contract(&temp1, &mpo_ten, {{0, 2}, {0, 1}}, &temp2);
+    Contract(&temp2, &mps_ten_dag, {{0 ,2}, {0, 1}}, res);
+  }
+  return res;
+}
+
+
+/**
+Grow a right environment by one site, following the contraction of the serial
+sweep.
+
+@param prenv The right environment, nullptr if the site is the last one.
+*/
+template <typename TenT>
+TenT *CtrctREnv(const TenT *prenv, const TenT &mps_ten, const TenT &mpo_ten) {
+  auto mps_ten_dag = Dag(mps_ten);
+  auto res = new TenT;
+  if (prenv == nullptr) {
+    TenT temp;
+    Contract(&mps_ten, &mpo_ten, {{1}, {0}}, &temp);
+    Contract(&temp, &mps_ten_dag, {{2}, {1}}, res);
+  } else {
+    TenT temp1, temp2;
+    Contract(&mps_ten, prenv, {{2}, {0}}, &temp1);
+    Contract(&temp1, &mpo_ten, {{1, 2}, {1, 3}}, &temp2);
+    Contract(&temp2, &mps_ten_dag, {{3, 1}, {1, 2}}, res);
+  }
+  return res;
+}
+
+
+// Grow a distributed environment. Process r contracts its slice of the old
+// environment with the MPO local tensor projected to the sector group of
+// process s, and the parts are summed up on process s, for each s in turn.
+template <typename TenT>
+TenT *DistCtrctEnv_(
+    const TenT *penv_slice,
+    const TenT &mps_ten,
+    const TenT &mpo_ten,
+    const size_t bond_idx,
+    const bool is_boundary,
+    const bool is_left,
+    LocalProcComm &comm
+) {
+  auto ctrct = is_left ? &CtrctLEnv<TenT> : &CtrctREnv<TenT>;
+  auto proc_coors = PartitionMPOBond(
+                        mpo_ten.GetIndexes()[bond_idx], comm.size()
+                    );
+  if (is_boundary) {
+    auto pmpo_ten = ProjectTenIndex(mpo_ten, bond_idx, proc_coors[comm.rank()]);
+    if (pmpo_ten == nullptr) { return nullptr; }
+    auto res = (*ctrct)(nullptr, mps_ten, *pmpo_ten);
+    delete pmpo_ten;
+    return res;
+  }
+  TenT *pnew_env_slice = nullptr;
+  for (size_t s = 0; s < comm.size(); ++s) {
+    TenT *part = nullptr;
+    if (penv_slice != nullptr) {
+      auto pmpo_ten = ProjectTenIndex(mpo_ten, bond_idx, proc_coors[s]);
+      if (pmpo_ten != nullptr) {
+        part = (*ctrct)(penv_slice, mps_ten, *pmpo_ten);
+        delete pmpo_ten;
+      }
+    }
+    auto psum = ReduceSumTen(comm, part, s);
+    if (s == comm.rank()) { pnew_env_slice = psum; }
+  }
+  return pnew_env_slice;
+}
+
+
+/**
+Grow a distributed left environment to cover the given site. Call it in all
+of the processes.
+
+@param plenv_slice The slice of the left environment held by current process,
+       nullptr if it holds nothing or the site is the first one.
+@param mps_ten The MPS local tensor on the site, known by all of the processes.
+@param mpo The MPO.
+@param site The site index.
+@param comm The communicator.
+
+@return The slice of the new left environment held by current process, or
+        nullptr if no sector is assigned to current process.
+*/
+template <typename TenT>
+TenT *DistCtrctLEnv(
+    const TenT *plenv_slice,
+    const TenT &mps_ten,
+    const MPO<TenT> &mpo,
+    const size_t site,
+    LocalProcComm &comm
+) {
+  return DistCtrctEnv_(
+             plenv_slice, mps_ten, mpo[site], MPORightBondIdx(mpo, site),
+             site == 0, true, comm
+         );
+}
+
+
+/**
+Grow a distributed right environment to cover the given site. Call it in all
+of the processes.
+
+@param prenv_slice The slice of the right environment held by current process,
+       nullptr if it holds nothing or the site is the last one.
+@param mps_ten The MPS local tensor on the site, known by all of the processes.
+@param mpo The MPO.
+@param site The site index.
+@param comm The communicator.
+
+@return The slice of the new right environment held by current process, or
+        nullptr if no sector is assigned to current process.
+*/
+template <typename TenT>
+TenT *DistCtrctREnv(
+    const TenT *prenv_slice,
+    const TenT &mps_ten,
+    const MPO<TenT> &mpo,
+    const size_t site,
+    LocalProcComm &comm
+) {
+  return DistCtrctEnv_(
+             prenv_slice, mps_ten, mpo[site], MPOLeftBondIdx(mpo, site),
+             site == mpo.size() - 1, false, comm
+         );
+}
+
+
+/**
+Distributed effective Hamiltonian multiplication. Call it in all of the
+processes.
+
+@param eff_ham The slices of the environments held by current process (the
+       0th and the 3th elements, nullptr if nothing is held) and the two MPO
+       local tensors.
+@param state The state, known by all of the processes.
+@param where The position of the updated tensors, "cent", "lend" or "rend".
+@param comm The communicator.
+
+@return The part of the result computed by current process, or nullptr. The
+        full result is the sum over all of the processes.
+*/
+template <typename TenT>
+TenT *DistEffHamMulState(
+    const std::vector<TenT *> &eff_ham,
+    TenT *state,
+    const std::string &where,
+    LocalProcComm &comm
+) {
+  if (where == "lend") {
+    if (eff_ham[3] == nullptr) { return nullptr; }
+    return eff_ham_mul_state_lend(eff_ham, state);
+  } else if (where == "rend") {
+    if (eff_ham[0] == nullptr) { return nullptr; }
+    return eff_ham_mul_state_rend(eff_ham, state);
+  }
+  assert(where == "cent");
+  // Stage 1, the left environment slice, the state and the MPO local tensors.
+  TenT *temp = nullptr;
+  if (eff_ham[0] != nullptr) {
+    temp = new TenT;
+    Contract(eff_ham[0], state, {{0}, {0}}, temp);
+    InplaceContract(temp, eff_ham[1], {{0, 2}, {0, 1}});
+    InplaceContract(temp, eff_ham[2], {{4, 1}, {0, 1}});
+  }
+  // Reduce and scatter by the MPO bond of the right environment.
+  auto proc_coors = PartitionMPOBond(eff_ham[2]->GetIndexes()[3], comm.size());
+  TenT *received = nullptr;
+  for (size_t s = 0; s < comm.size(); ++s) {
+    TenT *part = nullptr;
+    if (temp != nullptr) { part = ProjectTenIndex(*temp, 4, proc_coors[s]); }
+    auto psum = ReduceSumTen(comm, part, s);
+    if (s == comm.rank()) { received = psum; }
+  }
+  delete temp;
+  // Stage 2, the right environment slice.
+  if (received == nullptr || eff_ham[3] == nullptr) {
+    delete received;
+    return nullptr;
+  }
+  InplaceContract(received, eff_ham[3], {{4, 1}, {1, 0}});
+  return received;
+}
+
+
+/**
+Linear combination of the Krylov bases owned by current process. The k-th
+basis is owned by the process with rank k % size.
+
+@return The partial result, or nullptr if no related basis is owned.
+*/
+template <typename TenT>
+TenT *PartialLinearCombine(
+    const std::vector<GQTEN_Double> &coefs,
+    const std::vector<TenT *> &bases,
+    const LocalProcComm &comm
+) {
+  std::vector<GQTEN_Double> held_coefs;
+  std::vector<TenT *> held_bases;
+  for (size_t k = 0; k < coefs.size(); ++k) {
+    if (k % comm.size() == comm.rank() && bases[k] != nullptr) {
+      held_coefs.push_back(coefs[k]);
+      held_bases.push_back(bases[k]);
+    }
+  }
+  if (held_bases.empty()) { return nullptr; }
+  auto res = new TenT(held_bases[0]->GetIndexes());
+  LinearCombine(held_bases.size(), held_coefs.data(), held_bases, 0.0, res);
+  return res;
+}
+
+
+// Real part of the inner product <bra|ket>, 0 if ket is nullptr.
+template <typename TenT>
+double PartialInnerProd_(const TenT &bra, const TenT *ket) {
+  if (ket == nullptr) { return 0.0; }
+  std::vector<size_t> axes;
+  for (size_t i = 0; i < bra.Rank(); ++i) { axes.push_back(i); }
+  TenT temp_scalar_ten;
+  auto bra_dag = Dag(bra);
+  Contract(ket, &bra_dag, {axes, axes}, &temp_scalar_ten);
+  return Real(temp_scalar_ten());
+}
+
+
+// Lanczos solver distributed over local processes.
+/**
+The distributed Lanczos solver. Call it in all of the processes.
+
+@param rpeff_ham The effective Hamiltonian held by current process, i.e. the
+       slices of the environments and the two MPO local tensors, see
+       DistEffHamMulState.
+@param pinit_state The initial state held by the master. It will be destroyed
+       by the solver. The workers pass nullptr.
+@param params Parameters of the Lanczos solver.
+@param where The position of the updated tensors, "cent", "lend" or "rend".
+@param comm The communicator.
+
+@return The ground state energy on all of the processes. The ground state is
+        only returned on the master, the workers get a nullptr.
+*/
+template <typename TenT>
+LanczosRes<TenT> DistLanczosSolver(
+    const std::vector<TenT *> &rpeff_ham,
+    TenT *pinit_state,
+    const LanczosParams &params,
+    const std::string &where,
+    LocalProcComm &comm
+) {
+  auto rank = comm.rank();
+  auto proc_num = comm.size();
+  auto owner = [proc_num](const size_t k) { return k % proc_num; };
+  LanczosRes<TenT> lancz_res;
+
+  std::vector<TenT *> bases(params.max_iterations, nullptr);
+  std::vector<GQTEN_Double> a(params.max_iterations, 0.0);
+  std::vector<GQTEN_Double> b(params.max_iterations, 0.0);
+
+  // The current basis, held by all of the processes during its
+  // multiplication.
+  TenT *cur_basis = nullptr;
+  if (rank == 0) {
+    pinit_state->Normalize();
+    cur_basis = pinit_state;
+  }
+  BcastTen(comm, cur_basis, 0);
+  if (rank == owner(0)) { bases[0] = cur_basis; }
+  size_t eff_ham_eff_dim = 1;
+  for (auto &index : cur_basis->GetIndexes()) { eff_ham_eff_dim *= index.dim(); }
+
+  auto release_cur_basis = [&](const size_t k) {
+    if (rank != owner(k)) { delete cur_basis; }
+    cur_basis = nullptr;
+  };
+  auto finish = [&](const std::vector<GQTEN_Double> &coefs) {
+    lancz_res.gs_vec = ReduceSumTen(
+                           comm, PartialLinearCombine(coefs, bases, comm), 0
+                       );
+    for (auto &ptr : bases) { delete ptr; }
+    return lancz_res;
+  };
+
+  auto part_mat_mul_vec_res = DistEffHamMulState(
+                                  rpeff_ham, cur_basis, where, comm
+                              );
+  a[0] = AllReduceSumReal(
+             comm, PartialInnerProd_(*cur_basis, part_mat_mul_vec_res)
+         );
+  size_t m = 0;
+  GQTEN_Double energy0;
+  energy0 = a[0];
+  // Lanczos iterations.
+  while (true) {
+    m += 1;
+    // gamma = H|b_{m-1}> - a_{m-1}|b_{m-1}> - b_{m-2}|b_{m-2}>, summed up on
+    // the owner of the m-th basis.
+    auto gamma = part_mat_mul_vec_res;
+    std::vector<GQTEN_Double> coefs;
+    std::vector<TenT *> held_bases;
+    if (rank == owner(m-1)) {
+      coefs.push_back(-a[m-1]);
+      held_bases.push_back(cur_basis);
+    }
+    if (m > 1 && rank == owner(m-2)) {
+      coefs.push_back(-b[m-2]);
+      held_bases.push_back(bases[m-2]);
+    }
+    if (!held_bases.empty()) {
+      if (gamma == nullptr) {
+        gamma = new TenT(cur_basis->GetIndexes());
+        LinearCombine(coefs, held_bases, 0.0, gamma);
+      } else {
+        LinearCombine(coefs, held_bases, 1.0, gamma);
+      }
+    }
+    release_cur_basis(m-1);
+    gamma = ReduceSumTen(comm, gamma, owner(m));
+    double norm_gamma = 0.0;
+    if (rank == owner(m)) { norm_gamma = gamma->Normalize(); }
+    norm_gamma = BcastReal(comm, norm_gamma, owner(m));
+    GQTEN_Double eigval;
+    GQTEN_Double *eigvec = nullptr;
+    if (norm_gamma == 0.0) {
+      delete gamma;
+      if (m == 1) {
+        coefs = {1.0};
+      } else {
+        TridiagGsSolver(a, b, m, eigval, eigvec, 'V');
+        coefs = std::vector<GQTEN_Double>(eigvec, eigvec + m);
+        delete [] eigvec;
+      }
+      lancz_res.iters = m;
+      lancz_res.gs_eng = energy0;
+      return finish(coefs);
+    }
+
+    b[m-1] = norm_gamma;
+    cur_basis = gamma;
+    BcastTen(comm, cur_basis, owner(m));
+    if (rank == owner(m)) { bases[m] = cur_basis; }
+    part_mat_mul_vec_res = DistEffHamMulState(rpeff_ham, cur_basis, where, comm);
+    a[m] = AllReduceSumReal(
+               comm, PartialInnerProd_(*cur_basis, part_mat_mul_vec_res)
+           );
+    TridiagGsSolver(a, b, m+1, eigval, eigvec, 'N');
+    auto energy0_new = eigval;
+    if (
+        ((energy0 - energy0_new) < params.error) ||
+        (m == eff_ham_eff_dim) ||
+        (m == params.max_iterations - 1)
+    ) {
+      TridiagGsSolver(a, b, m+1, eigval, eigvec, 'V');
+      energy0 = energy0_new;
+      coefs = std::vector<GQTEN_Double>(eigvec, eigvec + m + 1);
+      delete [] eigvec;
+      delete part_mat_mul_vec_res;
+      release_cur_basis(m);
+      lancz_res.iters = m;
+      lancz_res.gs_eng = energy0;
+      return finish(coefs);
+    } else {
+      energy0 = energy0_new;
+    }
+  }
+}
+} /* gqmps2 */
+#endif /* ifndef GQMPS2_ALGORITHM_DIST_LANCZOS_SOLVER_H */
@@ -0,0 +1,53 @@
+// SPDX-License-Identifier: LGPL-3.0-only
+
+/*
+* Author: Rongyang Sun <sun-rongyang@outlook.com>
+* Creation Date: 2020-10-16 10:12
+*
+* Description: GraceQ/MPS2 project. Krylov subspace solver for the action of
+*              the exponential of the effective Hamiltonian.
+*/
+
+/**
+@file expmv_solver.h
+@brief A Krylov subspace solver which calculates exp(tau * H_eff) * v for the
+       effective Hamiltonian in MPS-MPO based algorithms.
+*/
+#ifndef GQMPS2_ALGORITHM_EXPMV_SOLVER_H
+#define GQMPS2_ALGORITHM_EXPMV_SOLVER_H
+
+
+#include <stdlib.h>     // size_t
+
+
+namespace gqmps2 {
+
+
+/**
+Parameters used by the Krylov matrix exponential solver.
+*/
+struct ExpmvParams {
+  /**
+  Setup Krylov matrix exponential solver parameters.
+
+  @param err The tolerated (relative) error of the result vector.
+  @param max_iter The maximal Krylov subspace dimension.
+  */
+  ExpmvParams(double err, size_t max_iter) :
+      error(err), max_iterations(max_iter) {}
+  ExpmvParams(double err) : ExpmvParams(err, 100) {}
+  ExpmvParams(void) : ExpmvParams(1.0E-10, 100) {}
+  ExpmvParams(const ExpmvParams &expmv_params) :
+      ExpmvParams(expmv_params.error, expmv_params.max_iterations) {}
+
+  double error;             ///< The tolerated error.
+  size_t max_iterations;    ///< The maximal Krylov subspace dimension.
+};
+} /* gqmps2 */
+
+
+// Implementation details
+#include "gqmps2/algorithm/expmv_solver_impl.h"
+
+
+#endif /* ifndef GQMPS2_ALGORITHM_EXPMV_SOLVER_H */
@@ -0,0 +1,183 @@
+// SPDX-License-Identifier: LGPL-3.0-only
+/*
+* Author: Rongyang Sun <sun-rongyang@outlook.com>
+* Creation Date: 2020-10-16 10:12
+*
+* Description: GraceQ/MPS2 project. Implementation details for Krylov matrix
+*              exponential solver.
+*/
+#include "gqmps2/algorithm/expmv_solver.h"      // ExpmvParams
+#include "gqmps2/algorithm/lanczos_solver.h"    // eff_ham_mul_state_*, EffHamMulStateSetup
+#include "gqten/gqten.h"
+
+
+#include <iostream>
+#include <vector>     // vector
+#include <cmath>      // exp, abs, sqrt
+#include <complex>    // exp, abs
+#include <cstring>
+
+#include "mkl.h"
+
+
+namespace gqmps2 {
+
+
+using namespace gqten;
+
+
+// Forward declarations.
+template <typename CoefT>
+void TridiagExpSolver(
+    const std::vector<double> &, const std::vector<double> &, const size_t,
+    const CoefT, std::vector<CoefT> &);
+
+
+// Krylov matrix exponential solver.
+template <typename TenT>
+struct ExpmvRes {
+  size_t iters;         ///< Dimension of the Krylov subspace used.
+  double err;           ///< Estimated relative error of the result.
+  TenT *expmv_vec;      ///< exp(tau * H_eff) * v.
+};
+
+
+/**
+Calculate exp(tau * H_eff) * v using the Lanczos process, where H_eff is the
+effective Hamiltonian and v is the initial state. The same effective
+Hamiltonian multiplication kernels as LanczosSolver are used. The Krylov
+subspace is enlarged until the a posteriori error estimate
+beta_m * |e_m^T exp(tau * T_m) e_1| / |exp(tau * T_m) e_1| drops below the
+tolerated error.
+
+@param rpeff_ham The effective Hamiltonian, the same as LanczosSolver.
+@param pinit_state The initial state v. It will be destroyed by the solver.
+@param tau The (real or complex) time step.
+@param params Parameters of the solver.
+@param where The position of the updated tensor(s), "cent", "lend" or "rend".
+*/
+template <typename TenT, typename CoefT>
+ExpmvRes<TenT> ExpmvSolver(
+    const std::vector<TenT *> &rpeff_ham,
+    TenT *pinit_state,
+    const CoefT tau,
+    const ExpmvParams &params,
+    const std::string &where
+) {
+  // Take care that init_state will be destroyed after call the solver
+  size_t eff_ham_eff_dim;
+  EffHamMulStateFunc<TenT> eff_ham_mul_state = nullptr;
+  std::vector<std::vector<size_t>> energy_measu_ctrct_axes;
+  ExpmvRes<TenT> expmv_res;
+
+  // Calculate position dependent parameters.
+  EffHamMulStateSetup(
+      rpeff_ham, where,
+      eff_ham_eff_dim, eff_ham_mul_state, energy_measu_ctrct_axes
+  );
+
+  std::vector<TenT *> bases(params.max_iterations, nullptr);
+  std::vector<GQTEN_Double> a(params.max_iterations, 0.0);
+  std::vector<GQTEN_Double> b(params.max_iterations, 0.0);
+  std::vector<CoefT> coefs;
+
+  // Initialize Krylov iteration.
+  auto init_state_norm = pinit_state->Normalize();
+  bases[0] = pinit_state;
+
+#ifdef GQMPS2_TIMING_MODE
+  Timer mat_vec_timer("mat_vec");
+#endif
+
+  size_t m = 0;
+  while (true) {
+#ifdef GQMPS2_TIMING_MODE
+    mat_vec_timer.Restart();
+#endif
+
+    auto gamma = (*eff_ham_mul_state)(rpeff_ham, bases[m]);
+
+#ifdef GQMPS2_TIMING_MODE
+    mat_vec_timer.PrintElapsed();
+#endif
+
+    TenT temp_scalar_ten;
+    auto base_dag = Dag(*bases[m]);
+    Contract(gamma, &base_dag, energy_measu_ctrct_axes, &temp_scalar_ten);
+    a[m] = Real(temp_scalar_ten());
+    if (m == 0) {
+      LinearCombine({-a[m]}, {bases[m]}, 1.0, gamma);
+    } else {
+      LinearCombine(
+          {-a[m], -b[m-1]},
+          {bases[m], bases[m-1]},
+          1.0,
+          gamma
+      );
+    }
+    auto norm_gamma = gamma->Normalize();
+
+    TridiagExpSolver(a, b, m+1, tau, coefs);
+    double coefs_norm = 0.0;
+    for (auto &coef : coefs) { coefs_norm += std::pow(std::abs(coef), 2.0); }
+    coefs_norm = std::sqrt(coefs_norm);
+    auto err = norm_gamma * std::abs(coefs[m]) / coefs_norm;
+
+    if (
+        (norm_gamma == 0.0) ||
+        (err < params.error) ||
+        (m + 1 == eff_ham_eff_dim) ||
+        (m + 1 == params.max_iterations)
+    ) {
+      delete gamma;
+      for (auto &coef : coefs) { coef *= init_state_norm; }
+      auto res_vec = new TenT(bases[0]->GetIndexes());
+      LinearCombine(m+1, coefs.data(), bases, CoefT(0.0), res_vec);
+      expmv_res.iters = m + 1;
+      expmv_res.err = err;
+      expmv_res.expmv_vec = res_vec;
+      for (auto &ptr : bases) { delete ptr; }
+      return expmv_res;
+    }
+
+    b[m] = norm_gamma;
+    bases[m+1] = gamma;
+    m += 1;
+  }
+}
+
+
+/**
+Calculate exp(tau * T) e_1 for the real symmetric tridiagonal matrix T with
+diagonal a[0:n] and off-diagonal b[0:n-1], using its eigen decomposition.
+*/
+template <typename CoefT>
+void TridiagExpSolver(
+    const std::vector<double> &a, const std::vector<double> &b, const size_t n,
+    const CoefT tau, std::vector<CoefT> &res) {
+  auto d = new double [n];
+  std::memcpy(d, a.data(), n*sizeof(double));
+  auto e = new double [n];
+  if (n > 1) { std::memcpy(e, b.data(), (n-1)*sizeof(double)); }
+  auto z = new double [n*n];
+  auto info = LAPACKE_dstev(
+                  LAPACK_ROW_MAJOR, 'V',
+                  n,
+                  d, e,
+                  z,
+                  n);
+  if (info != 0) {
+    std::cout << "?stev error." << std::endl;
+    exit(1);
+  }
+  // z[i*n + j] is the i-th component of the j-th eigenvector.
+  res.assign(n, CoefT(0.0));
+  for (size_t j = 0; j < n; ++j) {
+    CoefT weight = std::exp(tau * d[j]) * z[j];
+    for (size_t i = 0; i < n; ++i) { res[i] += z[i*n + j] * weight; }
+  }
+  delete [] d;
+  delete [] e;
+  delete [] z;
+}
+} /* gqmps2 */
@@ -37,6 +37,10 @@ void TridiagGsSolver(
     double &, double * &, const char);
 
 
+template <typename TenT>
+using EffHamMulStateFunc = TenT *(*)(const std::vector<TenT *> &, TenT *);
+
+
 // Helpers.
 template <typename TenT>
 inline void InplaceContract(
@@ -61,6 +65,41 @@ inline void LanczosFree(
 }
 
 
+// Select the effective Hamiltonian multiplication kernel by the position of
+// the updated tensor(s). The effective Hilbert space dimension and the
+// contraction axes for the energy measurement are also set.
+template <typename TenT>
+void EffHamMulStateSetup(
+    const std::vector<TenT *> &rpeff_ham,
+    const std::string &where,
+    size_t &eff_ham_eff_dim,
+    EffHamMulStateFunc<TenT> &eff_ham_mul_state,
+    std::vector<std::vector<size_t>> &energy_measu_ctrct_axes
+) {
+  eff_ham_eff_dim = 1;
+  if (where == "cent") {
+    eff_ham_eff_dim *= rpeff_ham[0]->GetIndexes()[0].dim();
+    eff_ham_eff_dim *= rpeff_ham[1]->GetIndexes()[1].dim();
+    eff_ham_eff_dim *= rpeff_ham[2]->GetIndexes()[1].dim();
+    eff_ham_eff_dim *= rpeff_ham[3]->GetIndexes()[0].dim();
+    eff_ham_mul_state = &eff_ham_mul_state_cent;
+    energy_measu_ctrct_axes = {{0, 1, 2, 3}, {0, 1, 2, 3}};
+  } else if (where == "lend") {
+    eff_ham_eff_dim *= rpeff_ham[1]->GetIndexes()[0].dim();
+    eff_ham_eff_dim *= rpeff_ham[2]->GetIndexes()[1].dim();
+    eff_ham_eff_dim *= rpeff_ham[3]->GetIndexes()[0].dim();
+    eff_ham_mul_state = &eff_ham_mul_state_lend;
+    energy_measu_ctrct_axes = {{0, 1, 2}, {0, 1, 2}};
+  } else if (where ==  "rend") {
+    eff_ham_eff_dim *= rpeff_ham[0]->GetIndexes()[0].dim();
+    eff_ham_eff_dim *= rpeff_ham[1]->GetIndexes()[1].dim();
+    eff_ham_eff_dim *= rpeff_ham[2]->GetIndexes()[0].dim();
+    eff_ham_mul_state = &eff_ham_mul_state_rend;
+    energy_measu_ctrct_axes = {{0, 1, 2}, {0, 1, 2}};
+  }
+}
+
+
 inline double Real(const GQTEN_Double d) { return d; }
 
 
@@ -84,32 +123,16 @@ LanczosRes<TenT> LanczosSolver(
     const std::string &where
 ) {
   // Take care that init_state will be destroyed after call the solver
-  size_t eff_ham_eff_dim = 1;
-  TenT *(* eff_ham_mul_state)(const std::vector<TenT *> &, TenT *) = nullptr;
+  size_t eff_ham_eff_dim;
+  EffHamMulStateFunc<TenT> eff_ham_mul_state = nullptr;
   std::vector<std::vector<size_t>> energy_measu_ctrct_axes;
   LanczosRes<TenT> lancz_res;
 
   // Calculate position dependent parameters.
-  if (where == "cent") {
-    eff_ham_eff_dim *= rpeff_ham[0]->GetIndexes()[0].dim();
-    eff_ham_eff_dim *= rpeff_ham[1]->GetIndexes()[1].dim();
-    eff_ham_eff_dim *= rpeff_ham[2]->GetIndexes()[1].dim();
-    eff_ham_eff_dim *= rpeff_ham[3]->GetIndexes()[0].dim();
-    eff_ham_mul_state = &eff_ham_mul_state_cent;
-    energy_measu_ctrct_axes = {{0, 1, 2, 3}, {0, 1, 2, 3}};
-  } else if (where == "lend") {
-    eff_ham_eff_dim *= rpeff_ham[1]->GetIndexes()[0].dim();
-    eff_ham_eff_dim *= rpeff_ham[2]->GetIndexes()[1].dim();
-    eff_ham_eff_dim *= rpeff_ham[3]->GetIndexes()[0].dim();
-    eff_ham_mul_state = &eff_ham_mul_state_lend;
-    energy_measu_ctrct_axes = {{0, 1, 2}, {0, 1, 2}};
-  } else if (where ==  "rend") {
-    eff_ham_eff_dim *= rpeff_ham[0]->GetIndexes()[0].dim();
-    eff_ham_eff_dim *= rpeff_ham[1]->GetIndexes()[1].dim();
-    eff_ham_eff_dim *= rpeff_ham[2]->GetIndexes()[0].dim();
-    eff_ham_mul_state = &eff_ham_mul_state_rend;
-    energy_measu_ctrct_axes = {{0, 1, 2}, {0, 1, 2}};
-  }
+  EffHamMulStateSetup(
+      rpeff_ham, where,
+      eff_ham_eff_dim, eff_ham_mul_state, energy_measu_ctrct_axes
+  );
 
   std::vector<TenT *> bases(params.max_iterations);
   std::vector<GQTEN_Double> a(params.max_iterations, 0.0);
@@ -17,6 +17,7 @@
 
 #include "gqmps2/consts.h"                      // kMpsPath, kRuntimeTempPath
 #include "gqmps2/algorithm/lanczos_solver.h"    // LanczParams
+#include "gqmps2/mock_gqten/ten_decomp.h"       // TruncDecompType
 
 #include <string>     // string
 
@@ -30,13 +31,17 @@ struct SweepParams {
       const size_t dmin, const size_t dmax, const double trunc_err,
       const LanczosParams &lancz_params,
       const std::string mps_path = kMpsPath,
-      const std::string temp_path = kRuntimeTempPath
+      const std::string temp_path = kRuntimeTempPath,
+      const size_t trunc_thread_num = 1,
+      const TruncDecompType trunc_decomp_type = FULL_SVD
   ) :
       sweeps(sweeps),
       Dmin(dmin), Dmax(dmax), trunc_err(trunc_err),
       lancz_params(lancz_params),
       mps_path(mps_path),
-      temp_path(temp_path) {}
+      temp_path(temp_path),
+      trunc_thread_num(trunc_thread_num),
+      trunc_decomp_type(trunc_decomp_type) {}
 
   size_t sweeps;
 
@@ -52,12 +57,25 @@ struct SweepParams {
 
   /// Runtime temporary files directory path
   std::string temp_path;
+
+  /// Number of threads used to decompose the quantum number blocks of the
+  /// two-site wave function in the truncation step. The default single thread
+  /// uses the SVD of GraceQ/tensor directly. The blocks are copied in and out
+  /// of the tensor element by element on one thread, so more threads only pay
+  /// off when the block decompositions dominate that copy.
+  size_t trunc_thread_num;
+
+  /// Backend of the truncation step. RANDOMIZED_SVD and DENSITY_MATRIX_EIG only
+  /// compute the kept singular triplets, which pays off when Dmax is much
+  /// smaller than the full two-site bond dimension.
+  TruncDecompType trunc_decomp_type;
 };
 } /* gqmps2 */
 
 
 // Implementation details
 #include "gqmps2/algorithm/vmps/two_site_update_finite_vmps_impl.h"
+#include "gqmps2/algorithm/vmps/two_site_update_finite_vmps_dist_impl.h"
 
 
 #endif /* ifndef GQMPS2_ALGORITHM_VMPS_TWO_SITE_UPDATE_FINITE_VMPS_H */
@@ -0,0 +1,500 @@
+// SPDX-License-Identifier: LGPL-3.0-only
+/*
+* Author: Rongyang Sun <sun-rongyang@outlook.com>
+* Creation Date: 2020-10-17 09:30
+*
+* Description: GraceQ/MPS2 project. Implementation details for two-site
+*              algorithm distributed over local processes.
+*/
+
+/**
+@file two_site_update_finite_vmps_dist_impl.h
+@brief Implementation details for two-site finite variational MPS algorithm
+       distributed over several local processes.
+
+All of the processes run the same sweep. The master holds the MPS and does the
+truncation; the environments are held as slices by all of the processes and
+the Lanczos solver is distributed, see dist_lanczos_solver.h. The slices of
+each process are dumped to its own files in the runtime temporary directory.
+*/
+#ifndef GQMPS2_ALGORITHM_VMPS_TWO_SITE_UPDATE_FINITE_VMPS_DIST_IMPL_H
+#define GQMPS2_ALGORITHM_VMPS_TWO_SITE_UPDATE_FINITE_VMPS_DIST_IMPL_H
+
+
+#include "gqmps2/algorithm/vmps/two_site_update_finite_vmps.h"    // SweepParams
+#include "gqmps2/algorithm/vmps/two_site_update_finite_vmps_impl.h"   // TwoSiteTruncDecomp, RemoveFile
+#include "gqmps2/algorithm/dist_lanczos_solver.h"                 // DistLanczosSolver, DistCtrctLEnv, DistCtrctREnv
+#include "gqmps2/local_proc_comm.h"                               // LocalProcComm
+#include "gqmps2/one_dim_tn/mpo/mpo.h"                            // MPO
+#include "gqmps2/one_dim_tn/mps/finite_mps/finite_mps.h"          // FiniteMPS
+#include "gqmps2/utilities.h"                                     // IsPathExist, CreatPath
+#include "gqmps2/one_dim_tn/framework/ten_vec.h"                  // TenVec
+#include "gqmps2/consts.h"
+#include "gqten/gqten.h"
+#include "gqten/utility/timer.h"                                  // Timer
+
+#include <iostream>
+#include <iomanip>
+#include <fstream>      // ifstream, ofstream
+#include <iterator>     // istreambuf_iterator
+#include <vector>
+#include <string>
+
+#ifdef Release
+  #define NDEBUG
+#endif
+#include <assert.h>
+
+
+namespace gqmps2 {
+using namespace gqten;
+
+
+// Helpers
+inline std::string GenDistEnvTenName(
+    const std::string &dir, const long blk_len, const std::string temp_path,
+    const size_t rank
+) {
+  return temp_path + "/" +
+         dir + kEnvFileBaseName + std::to_string(blk_len) +
+         ".rank" + std::to_string(rank) +
+         "." + kGQTenFileSuffix;
+}
+
+
+/**
+Dump a slice of an environment. A nullptr slice is dumped as an empty file.
+*/
+template <typename TenT>
+void DumpEnvSlice(const TenT *pslice, const std::string &file) {
+  std::ofstream ofs(file, std::ofstream::binary);
+  ofs << SerializeTen(pslice);
+  ofs.close();
+}
+
+
+/**
+Load a slice of an environment dumped by DumpEnvSlice.
+*/
+template <typename TenT>
+TenT *LoadEnvSlice(const std::string &file) {
+  std::ifstream ifs(file, std::ifstream::binary);
+  std::string msg(
+      (std::istreambuf_iterator<char>(ifs)),
+      std::istreambuf_iterator<char>()
+  );
+  ifs.close();
+  return DeserializeTen<TenT>(msg);
+}
+
+
+/**
+Function to perform two-site update finite vMPS algorithm with several local
+processes. Each process only holds its slices of the environments and its
+share of the Krylov bases, see dist_lanczos_solver.h.
+
+@note Call it in all of the processes of the communicator. The MPS and the MPO
+      must be prepared before the communicator is constructed. The worker
+      processes exit when the sweeps finish, only the master process returns.
+*/
+template <typename TenElemT, typename QNT>
+GQTEN_Double TwoSiteFiniteVMPS(
+    FiniteMPS<TenElemT, QNT> &mps,
+    const MPO<GQTensor<TenElemT, QNT>> &mpo,
+    const SweepParams &sweep_params,
+    LocalProcComm &comm
+) {
+  assert(mps.size() == mpo.size());
+  auto is_master = (comm.rank() == 0);
+  // If the runtime temporary directory does not exit, the master creates it and
+  // all of the processes initialize their slices of the right environments.
+  std::string init_envs;
+  if (is_master) {
+    init_envs = IsPathExist(sweep_params.temp_path) ? "n" : "y";
+    if (init_envs == "y") { CreatPath(sweep_params.temp_path); }
+  }
+  comm.Bcast(init_envs, 0);
+  if (init_envs == "y") { DistInitEnvs(mps, mpo, sweep_params, comm); }
+
+  if (is_master) { std::cout << "\n"; }
+  GQTEN_Double e0;
+  for (size_t sweep = 1; sweep <= sweep_params.sweeps; ++sweep) {
+    if (is_master) { std::cout << "sweep " << sweep << std::endl; }
+    Timer sweep_timer("sweep");
+    e0 = DistTwoSiteFiniteVMPSSweep(mps, mpo, sweep_params, comm);
+    if (is_master) {
+      sweep_timer.PrintElapsed();
+      std::cout << "\n";
+    }
+  }
+  if (is_master) {
+    // The sweeps end with the MPS right canonical from site 1 to the end.
+    DumpMPSCenter(sweep_params.mps_path, 0);
+  }
+  comm.Finalize();
+  return e0;
+}
+
+
+/**
+Initialize the slices of the right environments held by current process.
+Only the master reads the MPS, the local tensors are broadcast one by one.
+*/
+template <typename TenElemT, typename QNT>
+void DistInitEnvs(
+    FiniteMPS<TenElemT, QNT> &mps,
+    const MPO<GQTensor<TenElemT, QNT>> &mpo,
+    const SweepParams &sweep_params,
+    LocalProcComm &comm
+) {
+  using TenT = GQTensor<TenElemT, QNT>;
+  auto N = mps.size();
+  auto rank = comm.rank();
+
+  TenT *prenv_slice = nullptr;
+  for (size_t i = 1; i <= N - 2; ++i) {
+    TenT *pmps_ten = nullptr;
+    if (rank == 0) {
+      mps.LoadTen(N-i, GenMPSTenName(sweep_params.mps_path, N-i));
+      pmps_ten = mps(N-i);
+    }
+    BcastTen(comm, pmps_ten, 0);
+    auto pnew_renv_slice = DistCtrctREnv(
+                               prenv_slice, *pmps_ten, mpo, N-i, comm
+                           );
+    delete prenv_slice;
+    prenv_slice = pnew_renv_slice;
+    DumpEnvSlice(
+        prenv_slice,
+        GenDistEnvTenName("r", i, sweep_params.temp_path, rank)
+    );
+    if (rank == 0) {
+      mps.dealloc(N-i);
+    } else {
+      delete pmps_ten;
+    }
+  }
+  delete prenv_slice;
+  assert(mps.empty());
+}
+
+
+/**
+Function to perform a single distributed two-site finite vMPS sweep.
+
+@note Before the sweep and after the sweep, the MPS is empty.
+*/
+template <typename TenElemT, typename QNT>
+double DistTwoSiteFiniteVMPSSweep(
+    FiniteMPS<TenElemT, QNT> &mps,
+    const MPO<GQTensor<TenElemT, QNT>> &mpo,
+    const SweepParams &sweep_params,
+    LocalProcComm &comm
+) {
+  auto N = mps.size();
+  using TenT = GQTensor<TenElemT, QNT>;
+  TenVec<TenT> lenvs(N - 1);
+  TenVec<TenT> renvs(N - 1);
+  double e0;
+  for (size_t i = 0; i < N - 1; ++i) {
+    e0 = DistTwoSiteFiniteVMPSUpdate(
+        mps, lenvs, renvs, mpo, sweep_params, 'r', i, comm
+    );
+  }
+  for (size_t i = N-1; i > 0; --i) {
+    e0 = DistTwoSiteFiniteVMPSUpdate(
+        mps, lenvs, renvs, mpo, sweep_params, 'l', i, comm
+    );
+  }
+  return e0;
+}
+
+
+/**
+Distributed two-site update. The lenvs and renvs hold the slices of current
+process; they may hold nullptr when no sector is assigned to the process.
+*/
+template <typename TenElemT, typename QNT>
+double DistTwoSiteFiniteVMPSUpdate(
+    FiniteMPS<TenElemT, QNT> &mps,
+    TenVec<GQTensor<TenElemT, QNT>> &lenvs,
+    TenVec<GQTensor<TenElemT, QNT>> &renvs,
+    const MPO<GQTensor<TenElemT, QNT>> &mpo,
+    const SweepParams &sweep_params,
+    const char dir,
+    const size_t target_site,
+    LocalProcComm &comm
+) {
+  Timer update_timer("update");
+  auto is_master = (comm.rank() == 0);
+
+  // Assign some parameters
+  auto N = mps.size();
+  std::vector<std::vector<size_t>> init_state_ctrct_axes, us_ctrct_axes;
+  std::string where;
+  size_t svd_ldims;
+  size_t lsite_idx, rsite_idx;
+  size_t lenv_len, renv_len;
+  switch (dir) {
+    case 'r':
+      lsite_idx = target_site;
+      rsite_idx = target_site + 1;
+      lenv_len = target_site;
+      renv_len = N - (target_site + 2);
+      break;
+    case 'l':
+      lsite_idx = target_site - 1;
+      rsite_idx = target_site;
+      lenv_len = target_site - 1;
+      renv_len = N - target_site - 1;
+      break;
+    default:
+      std::cout << "dir must be 'r' or 'l', but " << dir << std::endl;
+      exit(1);
+  }
+  if (lsite_idx == 0) {
+    where = "lend";
+    init_state_ctrct_axes = {{1}, {0}};
+    svd_ldims = 1;
+    us_ctrct_axes = {{1}, {0}};
+  } else {
+    where = (rsite_idx == N-1) ? "rend" : "cent";
+    init_state_ctrct_axes = {{2}, {0}};
+    svd_ldims = 2;
+    us_ctrct_axes = {{2}, {0}};
+  }
+
+  // Load to-be-used tensors
+  DistLoadRelatedTens(mps, lenvs, renvs, target_site, dir, sweep_params, comm);
+
+  // Lanczos
+  using TenT = GQTensor<TenElemT, QNT>;
+  std::vector<TenT *>eff_ham(4);
+  eff_ham[0] = lenvs(lenv_len);
+  // Safe const casts for MPO local tensors.
+  eff_ham[1] = const_cast<TenT *>(&mpo[lsite_idx]);
+  eff_ham[2] = const_cast<TenT *>(&mpo[rsite_idx]);
+  eff_ham[3] = renvs(renv_len);
+  TenT *init_state = nullptr;
+  if (is_master) {
+    init_state = new TenT;
+    Contract(
+        &mps[lsite_idx], &mps[rsite_idx], init_state_ctrct_axes, init_state
+    );
+  }
+  Timer lancz_timer("Lancz");
+  auto lancz_res = DistLanczosSolver(
+                       eff_ham, init_state,
+                       sweep_params.lancz_params,
+                       where,
+                       comm
+                   );
+  auto lancz_elapsed_time = lancz_timer.Elapsed();
+
+  // SVD, measure entanglement entropy and update MPS local tensors on the
+  // master.
+  GQTEN_Double actual_trunc_err = 0.0;
+  size_t D = 0;
+  double ee = 0.0;
+  if (is_master) {
+    TenT u, vt;
+    using DTenT = GQTensor<GQTEN_Double, QNT>;
+    DTenT s;
+    TwoSiteTruncDecomp(
+        lancz_res.gs_vec, svd_ldims, Div(mps[lsite_idx]), sweep_params,
+        &u, &s, &vt, &actual_trunc_err, &D
+    );
+    delete lancz_res.gs_vec;
+    ee = MeasureEE(s, D);
+
+    TenT the_other_mps_ten;
+    switch (dir) {
+      case 'r':
+        mps[lsite_idx] = std::move(u);
+        Contract(&s, &vt, {{1}, {0}}, &the_other_mps_ten);
+        mps[rsite_idx] = std::move(the_other_mps_ten);
+        break;
+      case 'l':
+        Contract(&u, &s, us_ctrct_axes, &the_other_mps_ten);
+        mps[lsite_idx] = std::move(the_other_mps_ten);
+        mps[rsite_idx] = std::move(vt);
+        break;
+      default:
+        assert(false);
+    }
+  }
+
+  // Update the slices of the environment tensors
+  if (
+      (dir == 'r' && target_site != N-2) ||
+      (dir == 'l' && target_site != 1)
+  ) {
+    TenT *pmps_ten = is_master ? mps(target_site) : nullptr;
+    BcastTen(comm, pmps_ten, 0);
+    if (dir == 'r') {
+      auto pnew_lenv_slice = DistCtrctLEnv(
+                                 lenvs(lenv_len), *pmps_ten, mpo, target_site,
+                                 comm
+                             );
+      lenvs.dealloc(lenv_len + 1);
+      lenvs(lenv_len + 1) = pnew_lenv_slice;
+    } else {
+      auto pnew_renv_slice = DistCtrctREnv(
+                                 renvs(renv_len), *pmps_ten, mpo, target_site,
+                                 comm
+                             );
+      renvs.dealloc(renv_len + 1);
+      renvs(renv_len + 1) = pnew_renv_slice;
+    }
+    if (!is_master) { delete pmps_ten; }
+  }
+
+  // Dump related tensor to HD and remove unused tensor from RAM
+  DistDumpRelatedTens(mps, lenvs, renvs, target_site, dir, sweep_params, comm);
+
+  auto update_elapsed_time = update_timer.Elapsed();
+  if (is_master) {
+    std::cout << "Site " << std::setw(4) << target_site
+              << " E0 = " << std::setw(20) << std::setprecision(kLanczEnergyOutputPrecision) << std::fixed << lancz_res.gs_eng
+              << " TruncErr = " << std::setprecision(2) << std::scientific << actual_trunc_err << std::fixed
+              << " D = " << std::setw(5) << D
+              << " Iter = " << std::setw(3) << lancz_res.iters
+              << " LanczT = " << std::setw(8) << lancz_elapsed_time
+              << " TotT = " << std::setw(8) << update_elapsed_time
+              << " S = " << std::setw(10) << std::setprecision(7) << ee;
+    std::cout << std::scientific << std::endl;
+  }
+  return lancz_res.gs_eng;
+}
+
+
+/**
+Load the tensors used by a distributed update. It follows LoadRelatedTens,
+but only the master loads the MPS local tensors and each process loads its own
+slices of the environments.
+*/
+template <typename TenElemT, typename QNT>
+void DistLoadRelatedTens(
+    FiniteMPS<TenElemT, QNT> &mps,
+    TenVec<GQTensor<TenElemT, QNT>> &lenvs,
+    TenVec<GQTensor<TenElemT, QNT>> &renvs,
+    const size_t target_site,
+    const char dir,
+    const SweepParams &sweep_params,
+    LocalProcComm &comm
+) {
+  using TenT = GQTensor<TenElemT, QNT>;
+  auto N = mps.size();
+  auto rank = comm.rank();
+  auto load_mps_ten = [&](const size_t site) {
+    if (rank == 0) {
+      mps.LoadTen(site, GenMPSTenName(sweep_params.mps_path, site));
+    }
+  };
+  auto load_env_slice = [&](
+      TenVec<TenT> &envs, const std::string &env_dir, const size_t len
+  ) {
+    auto file = GenDistEnvTenName(env_dir, len, sweep_params.temp_path, rank);
+    envs.dealloc(len);
+    envs(len) = LoadEnvSlice<TenT>(file);
+    RemoveFile(file);
+  };
+  switch (dir) {
+    case 'r':
+      if (target_site == 0) {
+        load_mps_ten(target_site);
+        load_mps_ten(target_site + 1);
+        load_env_slice(renvs, "r", N - (target_site + 2));
+      } else if (target_site == N-2) {
+        load_mps_ten(target_site + 1);
+      } else {
+        load_mps_ten(target_site + 1);
+        load_env_slice(renvs, "r", N - (target_site + 2));
+      }
+      break;
+    case 'l':
+      if (target_site == N-1) {
+        // Do nothing
+      } else if (target_site == 1) {
+        load_mps_ten(target_site - 1);
+      } else {
+        load_mps_ten(target_site - 1);
+        load_env_slice(lenvs, "l", (target_site+1) - 2);
+      }
+      break;
+    default:
+      assert(false);
+  }
+}
+
+
+/**
+Dump the tensors of a distributed update. It follows DumpRelatedTens, but only
+the master dumps the MPS local tensors and each process dumps its own slices
+of the environments.
+*/
+template <typename TenElemT, typename QNT>
+void DistDumpRelatedTens(
+    FiniteMPS<TenElemT, QNT> &mps,
+    TenVec<GQTensor<TenElemT, QNT>> &lenvs,
+    TenVec<GQTensor<TenElemT, QNT>> &renvs,
+    const size_t target_site,
+    const char dir,
+    const SweepParams &sweep_params,
+    LocalProcComm &comm
+) {
+  using TenT = GQTensor<TenElemT, QNT>;
+  auto N = mps.size();
+  auto rank = comm.rank();
+  auto dump_mps_ten = [&](const size_t site, const bool release_mem) {
+    if (rank == 0) {
+      mps.DumpTen(
+          site, GenMPSTenName(sweep_params.mps_path, site), release_mem
+      );
+    }
+  };
+  auto dump_env_slice = [&](
+      const TenVec<TenT> &envs, const std::string &env_dir, const size_t len
+  ) {
+    DumpEnvSlice(
+        envs(len),
+        GenDistEnvTenName(env_dir, len, sweep_params.temp_path, rank)
+    );
+  };
+  switch (dir) {
+    case 'r':
+      if (target_site == 0) {
+        renvs.dealloc(N - (target_site+2));
+        dump_mps_ten(target_site, true);
+        dump_env_slice(lenvs, "l", target_site + 1);
+      } else if (target_site == N-2) {
+        dump_mps_ten(target_site, false);
+      } else {
+        lenvs.dealloc(target_site);
+        renvs.dealloc(N - (target_site + 2));
+        dump_mps_ten(target_site, true);
+        dump_env_slice(lenvs, "l", target_site + 1);
+      }
+      break;
+    case 'l':
+      if (target_site == N - 1) {
+        lenvs.dealloc((target_site+1) - 2);
+        dump_mps_ten(target_site, true);
+        dump_env_slice(renvs, "r", N - target_site);
+      } else if (target_site == 1) {
+        renvs.dealloc(N - (target_site+1));
+        dump_mps_ten(target_site, true);
+        dump_mps_ten(target_site - 1, true);
+      } else {
+        lenvs.dealloc((target_site+1) - 2);
+        renvs.dealloc(N - (target_site+1));
+        dump_mps_ten(target_site, true);
+        dump_env_slice(renvs, "r", N - target_site);
+      }
+      break;
+    default:
+      assert(false);
+  }
+}
+} /* gqmps2 */
+#endif /* ifndef GQMPS2_ALGORITHM_VMPS_TWO_SITE_UPDATE_FINITE_VMPS_DIST_IMPL_H */
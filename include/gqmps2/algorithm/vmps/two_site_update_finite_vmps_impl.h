@@ -19,6 +19,7 @@
 #include "gqmps2/one_dim_tn/mps/finite_mps/finite_mps.h"          // FiniteMPS
 #include "gqmps2/utilities.h"                                     // IsPathExist, CreatPath
 #include "gqmps2/one_dim_tn/framework/ten_vec.h"                  // TenVec
+#include "gqmps2/mock_gqten/ten_decomp.h"                         // mock_gqten::TruncatedDecomp
 #include "gqmps2/consts.h"
 #include "gqten/gqten.h"
 #include "gqten/utility/timer.h"                                  // Timer
@@ -69,6 +70,42 @@ inline void RemoveFile(const std::string &file) {
 }
 
 
+// Truncated decomposition of the two-site state with the backend selected by
+// the sweep parameters.
+template <typename TenElemT, typename QNT>
+void TwoSiteTruncDecomp(
+    const GQTensor<TenElemT, QNT> *pstate,
+    const size_t svd_ldims,
+    const QNT &ldiv,
+    const SweepParams &sweep_params,
+    GQTensor<TenElemT, QNT> *pu,
+    GQTensor<GQTEN_Double, QNT> *ps,
+    GQTensor<TenElemT, QNT> *pvt,
+    GQTEN_Double *pactual_trunc_err,
+    size_t *pD
+) {
+  if (
+      sweep_params.trunc_thread_num > 1 ||
+      sweep_params.trunc_decomp_type != FULL_SVD
+  ) {
+    mock_gqten::TruncatedDecomp(
+        pstate,
+        svd_ldims, ldiv,
+        sweep_params.trunc_err, sweep_params.Dmin, sweep_params.Dmax,
+        pu, ps, pvt, pactual_trunc_err, pD,
+        sweep_params.trunc_decomp_type, sweep_params.trunc_thread_num
+    );
+  } else {
+    SVD(
+        pstate,
+        svd_ldims, ldiv,
+        sweep_params.trunc_err, sweep_params.Dmin, sweep_params.Dmax,
+        pu, ps, pvt, pactual_trunc_err, pD
+    );
+  }
+}
+
+
 /**
 Function to perform two-site update finite vMPS algorithm.
 
@@ -97,6 +134,8 @@ GQTEN_Double TwoSiteFiniteVMPS(
     sweep_timer.PrintElapsed();
     std::cout << "\n";
   }
+  // The sweeps end with the MPS right canonical from site 1 to the end.
+  DumpMPSCenter(sweep_params.mps_path, 0);
   return e0;
 }
 
@@ -255,10 +294,8 @@ double TwoSiteFiniteVMPSUpdate(
   DTenT s;
   GQTEN_Double actual_trunc_err;
   size_t D;
-  SVD(
-      lancz_res.gs_vec,
-      svd_ldims, Div(mps[lsite_idx]),
-      sweep_params.trunc_err, sweep_params.Dmin, sweep_params.Dmax,
+  TwoSiteTruncDecomp(
+      lancz_res.gs_vec, svd_ldims, Div(mps[lsite_idx]), sweep_params,
       &u, &s, &vt, &actual_trunc_err, &D
   );
   delete lancz_res.gs_vec;
@@ -0,0 +1,57 @@
+// SPDX-License-Identifier: LGPL-3.0-only
+
+/*
+* Author: Rongyang Sun <sun-rongyang@outlook.com>
+* Creation Date: 2020-10-16 14:05
+*
+* Description: GraceQ/MPS2 project. Two-site update infinite size vMPS (iDMRG).
+*/
+
+/**
+@file two_site_update_infinite_vmps.h
+@brief Two-site update infinite size vMPS (iDMRG).
+*/
+#ifndef GQMPS2_ALGORITHM_VMPS_TWO_SITE_UPDATE_INFINITE_VMPS_H
+#define GQMPS2_ALGORITHM_VMPS_TWO_SITE_UPDATE_INFINITE_VMPS_H
+
+
+#include "gqmps2/algorithm/lanczos_solver.h"    // LanczParams
+
+#include <stdlib.h>     // size_t
+
+
+namespace gqmps2 {
+
+
+struct InfiniteSweepParams {
+  InfiniteSweepParams(
+      const size_t steps,
+      const size_t dmin, const size_t dmax, const double trunc_err,
+      const LanczosParams &lancz_params,
+      const double energy_err = 1.0E-10
+  ) :
+      steps(steps),
+      Dmin(dmin), Dmax(dmax), trunc_err(trunc_err),
+      lancz_params(lancz_params),
+      energy_err(energy_err) {}
+
+  /// The maximal number of unit cell growth steps.
+  size_t steps;
+
+  size_t Dmin;
+  size_t Dmax;
+  double trunc_err;
+
+  LanczosParams lancz_params;
+
+  /// The growth stops when the change of the energy per site is smaller than it.
+  double energy_err;
+};
+} /* gqmps2 */
+
+
+// Implementation details
+#include "gqmps2/algorithm/vmps/two_site_update_infinite_vmps_impl.h"
+
+
+#endif /* ifndef GQMPS2_ALGORITHM_VMPS_TWO_SITE_UPDATE_INFINITE_VMPS_H */
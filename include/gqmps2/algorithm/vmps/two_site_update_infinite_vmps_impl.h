@@ -0,0 +1,287 @@
+// SPDX-License-Identifier: LGPL-3.0-only
+/*
+* Author: Rongyang Sun <sun-rongyang@outlook.com>
+* Creation Date: 2020-10-16 14:05
+*
+* Description: GraceQ/MPS2 project. Implementation details for two-site infinite vMPS.
+*/
+
+/**
+@file two_site_update_infinite_vmps_impl.h
+@brief Implementation details for two-site infinite variational MPS algorithm.
+*/
+#ifndef GQMPS2_ALGORITHM_VMPS_TWO_SITE_UPDATE_INFINITE_VMPS_IMPL_H
+#define GQMPS2_ALGORITHM_VMPS_TWO_SITE_UPDATE_INFINITE_VMPS_IMPL_H
+
+
+#include "gqmps2/algorithm/vmps/two_site_update_infinite_vmps.h"  // InfiniteSweepParams
+#include "gqmps2/algorithm/vmps/two_site_update_finite_vmps.h"    // MeasureEE
+#include "gqmps2/one_dim_tn/mpo/mpo.h"                            // MPO
+#include "gqmps2/one_dim_tn/mps/infinite_mps/infinite_mps.h"      // InfiniteMPS
+#include "gqmps2/consts.h"
+#include "gqten/gqten.h"
+#include "gqten/utility/timer.h"                                  // Timer
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <cmath>      // abs
+
+#ifdef Release
+  #define NDEBUG
+#endif
+#include <assert.h>
+
+
+namespace gqmps2 {
+using namespace gqten;
+
+
+// Helpers
+/**
+Find the boundary states of a bulk MPO tensor W with (lvb, pin, pout, rvb)
+form. The ready state r satisfies W(r, :, :, r) = Id and only transits to
+other states. The final state f satisfies W(f, :, :, f) = Id and can only be
+reached from other states.
+*/
+template <typename TenElemT, typename QNT>
+void FindBulkMPOTenBoundaryStates(
+    const GQTensor<TenElemT, QNT> &mpo_ten,
+    size_t &ready_stat, size_t &final_stat
+) {
+  auto shape = mpo_ten.GetShape();
+  auto vb_dim = shape[0];
+  auto pb_dim = shape[1];
+  std::vector<bool> is_id(vb_dim, true);
+  std::vector<bool> has_out(vb_dim, false);
+  std::vector<bool> has_in(vb_dim, false);
+  for (size_t x = 0; x < vb_dim; ++x) {
+    for (size_t y = 0; y < vb_dim; ++y) {
+      for (size_t a = 0; a < pb_dim; ++a) {
+        for (size_t b = 0; b < pb_dim; ++b) {
+          auto elem = mpo_ten.GetElem({x, a, b, y});
+          if (x == y) {
+            TenElemT id_elem = (a == b) ? 1.0 : 0.0;
+            if (std::abs(elem - id_elem) > kDoubleEpsilon) { is_id[x] = false; }
+          } else if (std::abs(elem) > kDoubleEpsilon) {
+            has_out[x] = true;
+            has_in[y] = true;
+          }
+        }
+      }
+    }
+  }
+  size_t ready_stat_num = 0, final_stat_num = 0;
+  for (size_t x = 0; x < vb_dim; ++x) {
+    if (!is_id[x]) { continue; }
+    if (has_out[x] && !has_in[x]) {
+      ready_stat = x;
+      ready_stat_num++;
+    } else if (has_in[x] && !has_out[x]) {
+      final_stat = x;
+      final_stat_num++;
+    }
+  }
+  if (ready_stat_num != 1 || final_stat_num != 1) {
+    std::cout << "Can not identify the boundary states of the bulk MPO tensor."
+              << std::endl;
+    exit(1);
+  }
+}
+
+
+/**
+Predict the two-site wave function of the next iDMRG step from the current
+step (I. P. McCulloch, arXiv:0804.2509). With the current wave function
+u s vt and the singular values s_prev of the previous step, the prediction
+s vt s_prev^-1 u s rotates the unit cell by one site, which is an accurate
+initial state for the Lanczos solver once the iteration starts to converge.
+
+@return The normalized predicted wave function, or nullptr if the prediction is
+        not available, e.g. the two sites in the unit cell are different.
+*/
+template <typename TenElemT, typename QNT>
+GQTensor<TenElemT, QNT> *PredictInfiniteVMPSState(
+    const GQTensor<TenElemT, QNT> &u,
+    const GQTensor<GQTEN_Double, QNT> &s,
+    const GQTensor<TenElemT, QNT> &vt,
+    const GQTensor<GQTEN_Double, QNT> &s_prev
+) {
+  using TenT = GQTensor<TenElemT, QNT>;
+  if (!(u.GetIndexes()[1] == vt.GetIndexes()[1])) { return nullptr; }
+  // The right bond of vt is the right bond of the previous step and the left
+  // bond of u is the left bond of the previous step.
+  auto s_prev_inv_lvb = InverseIndex(vt.GetIndexes()[2]);
+  auto s_prev_inv_rvb = InverseIndex(u.GetIndexes()[0]);
+  auto s_prev_shape = s_prev.GetShape();
+  if (
+      s_prev_inv_lvb.dim() != s_prev_shape[1] ||
+      s_prev_inv_rvb.dim() != s_prev_shape[0]
+  ) {
+    return nullptr;
+  }
+  TenT s_prev_inv({s_prev_inv_lvb, s_prev_inv_rvb});
+  for (size_t i = 0; i < s_prev_shape[0]; ++i) {
+    auto lambda = s_prev(i, i);
+    if (lambda > kDoubleEpsilon) { s_prev_inv({i, i}) = 1.0 / lambda; }
+  }
+
+  TenT temp1, temp2, temp3;
+  Contract(&s, &vt, {{1}, {0}}, &temp1);
+  Contract(&temp1, &s_prev_inv, {{2}, {0}}, &temp2);
+  Contract(&temp2, &u, {{2}, {0}}, &temp3);
+  auto pstate = new TenT;
+  Contract(&temp3, &s, {{3}, {0}}, pstate);
+  auto norm = pstate->Normalize();
+  if (!(norm > kDoubleEpsilon)) {
+    delete pstate;
+    return nullptr;
+  }
+  return pstate;
+}
+
+
+/**
+Function to perform two-site update infinite vMPS algorithm (iDMRG). Each step
+inserts one two-site unit cell in the middle of the system, optimizes the
+two-site wave function, starting from the prediction of the previous
+step, and absorbs the optimized local tensors into the left
+and the right environments.
+
+@param imps The infinite MPS with a two-site unit cell. It will be set to the
+       unit cell of the final step.
+@param mpo A finite MPO generated for a long enough system, whose bulk tensors
+       are translation invariant.
+@param bulk_site The MPO local tensors mpo[bulk_site] and mpo[bulk_site + 1]
+       are used as the bulk MPO tensors of the unit cell.
+@param cell_div The quantum number divergence added by each unit cell.
+@param sweep_params Parameters of the iDMRG.
+
+@return The ground state energy per site.
+*/
+template <typename TenElemT, typename QNT>
+GQTEN_Double TwoSiteInfiniteVMPS(
+    InfiniteMPS<TenElemT, QNT> &imps,
+    const MPO<GQTensor<TenElemT, QNT>> &mpo,
+    const size_t bulk_site,
+    const QNT &cell_div,
+    const InfiniteSweepParams &sweep_params
+) {
+  assert(imps.GetUnitCellSize() == 2);
+  assert(bulk_site > 0 && bulk_site + 2 < mpo.size());
+  using TenT = GQTensor<TenElemT, QNT>;
+  using DTenT = GQTensor<GQTEN_Double, QNT>;
+  using IndexT = Index<QNT>;
+  using QNSctT = QNSector<QNT>;
+
+  // Safe const casts for MPO local tensors.
+  auto plmpo_ten = const_cast<TenT *>(&mpo[bulk_site]);
+  auto prmpo_ten = const_cast<TenT *>(&mpo[bulk_site + 1]);
+  assert(
+      plmpo_ten->GetIndexes()[0] == InverseIndex(plmpo_ten->GetIndexes()[3])
+  );
+  assert(
+      prmpo_ten->GetIndexes()[0] == InverseIndex(prmpo_ten->GetIndexes()[3])
+  );
+  size_t ready_stat, final_stat, unused_stat;
+  FindBulkMPOTenBoundaryStates(*plmpo_ten, ready_stat, unused_stat);
+  FindBulkMPOTenBoundaryStates(*prmpo_ten, unused_stat, final_stat);
+
+  // Trivial boundary environments.
+  auto qn0 = Div(*plmpo_ten) - Div(*plmpo_ten);
+  auto vb_out = IndexT({QNSctT(qn0, 1)}, GQTenIndexDirType::OUT);
+  auto vb_in = InverseIndex(vb_out);
+  TenT lenv({vb_out, InverseIndex(plmpo_ten->GetIndexes()[0]), vb_in});
+  lenv({0, ready_stat, 0}) = 1.0;
+  TenT renv({vb_in, InverseIndex(prmpo_ten->GetIndexes()[3]), vb_out});
+  renv({0, final_stat, 0}) = 1.0;
+  auto lpb_out = plmpo_ten->GetIndexes()[2];
+  auto rpb_out = prmpo_ten->GetIndexes()[2];
+
+  std::cout << "\n";
+  TenT u, vt;
+  DTenT s;
+  // Singular values of the previous step, trivial before the first step.
+  DTenT s_prev({vb_in, vb_out});
+  s_prev({0, 0}) = 1.0;
+  GQTEN_Double e0 = 0.0, e0_per_site = 0.0;
+  for (size_t step = 1; step <= sweep_params.steps; ++step) {
+    Timer step_timer("step");
+
+    // Lanczos
+    std::vector<TenT *> eff_ham = {&lenv, plmpo_ten, prmpo_ten, &renv};
+    TenT *init_state = nullptr;
+    if (step > 1) { init_state = PredictInfiniteVMPSState(u, s, vt, s_prev); }
+    if (init_state == nullptr) {
+      init_state = new TenT({
+                       InverseIndex(lenv.GetIndexes()[0]),
+                       lpb_out, rpb_out,
+                       InverseIndex(renv.GetIndexes()[0])
+                   });
+      init_state->Random(cell_div);
+    }
+    Timer lancz_timer("Lancz");
+    auto lancz_res = LanczosSolver(
+                         eff_ham, init_state,
+                         sweep_params.lancz_params,
+                         "cent"
+                     );
+    auto lancz_elapsed_time = lancz_timer.Elapsed();
+
+    // SVD and measure entanglement entropy
+    if (step > 1) { s_prev = std::move(s); }
+    u = TenT();
+    vt = TenT();
+    s = DTenT();
+    GQTEN_Double actual_trunc_err;
+    size_t D;
+    SVD(
+        lancz_res.gs_vec,
+        2, cell_div,
+        sweep_params.trunc_err, sweep_params.Dmin, sweep_params.Dmax,
+        &u, &s, &vt, &actual_trunc_err, &D
+    );
+    delete lancz_res.gs_vec;
+    auto ee = MeasureEE(s, D);
+
+    // Grow the environments by one unit cell
+    TenT ltemp1, ltemp2, new_lenv;
+    Contract(&lenv, &u, {{0}, {0}}, &ltemp1);
+    Contract(&ltemp1, plmpo_ten, {{0, 2}, {0, 1}}, &ltemp2);
+    auto u_dag = Dag(u);
+    Contract(&ltemp2, &u_dag, {{0 ,2}, {0, 1}}, &new_lenv);
+    lenv = std::move(new_lenv);
+    TenT rtemp1, rtemp2, new_renv;
+    Contract(&vt, &renv, {{2}, {0}}, &rtemp1);
+    Contract(&rtemp1, prmpo_ten, {{1, 2}, {1, 3}}, &rtemp2);
+    auto vt_dag = Dag(vt);
+    Contract(&rtemp2, &vt_dag, {{3, 1}, {1, 2}}, &new_renv);
+    renv = std::move(new_renv);
+
+    // The system grows two sites per step.
+    auto e0_per_site_new = (lancz_res.gs_eng - e0) / 2.0;
+    auto de0_per_site = std::abs(e0_per_site_new - e0_per_site);
+    e0 = lancz_res.gs_eng;
+    e0_per_site = e0_per_site_new;
+
+    auto step_elapsed_time = step_timer.Elapsed();
+    std::cout << "Step " << std::setw(4) << step
+              << " E0/site = " << std::setw(20) << std::setprecision(kLanczEnergyOutputPrecision) << std::fixed << e0_per_site
+              << " TruncErr = " << std::setprecision(2) << std::scientific << actual_trunc_err << std::fixed
+              << " D = " << std::setw(5) << D
+              << " Iter = " << std::setw(3) << lancz_res.iters
+              << " LanczT = " << std::setw(8) << lancz_elapsed_time
+              << " TotT = " << std::setw(8) << step_elapsed_time
+              << " S = " << std::setw(10) << std::setprecision(7) << ee;
+    std::cout << std::scientific << std::endl;
+
+    if (step > 1 && de0_per_site < sweep_params.energy_err) { break; }
+  }
+
+  imps[0] = std::move(u);
+  imps[1] = std::move(vt);
+  imps.GetCenterBondTen() = std::move(s);
+  return e0_per_site;
+}
+} /* gqmps2 */
+#endif /* ifndef GQMPS2_ALGORITHM_VMPS_TWO_SITE_UPDATE_INFINITE_VMPS_IMPL_H */
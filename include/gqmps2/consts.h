@@ -29,9 +29,14 @@ const std::string kMpsPath = "mps";
 const std::string kRuntimeTempPath = ".temp";
 const std::string kEnvFileBaseName = "env";
 const std::string kMpsTenBaseName = "mps_ten";
+const std::string kMpsCenterFileName = "center";
+const std::string kMpoTenBaseName = "mpo_ten";
+const std::string kIMpsBondTenBaseName = "imps_bond_ten";
 
 const int kLanczEnergyOutputPrecision = 16;
 
+const double kDoubleEpsilon = 1.0E-15;
+
 const std::vector<size_t> kNullUintVec;
 const std::vector<std::vector<size_t>> kNullUintVecVec;
 } /* gqmps2 */ 
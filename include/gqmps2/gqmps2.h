@@ -25,13 +25,17 @@
 #include "gqmps2/case_params_parser.h"                              // CaseParamsParserBasic
 #include "gqmps2/site_vec.h"                                        // SiteVec
 // MPS class and its initializations and measurements
-#include "gqmps2/one_dim_tn/mps_all.h"                              // MPS, ...
+#include "gqmps2/one_dim_tn/mps_all.h"                              // MPS, FiniteMPS, InfiniteMPS, ...
 // MPO and its generator
 #include "gqmps2/one_dim_tn/mpo/mpo.h"                              // MPO
 #include "gqmps2/one_dim_tn/mpo/mpogen/mpogen.h"                    // MPOGenerator
+#include "gqmps2/one_dim_tn/mpo/mpo_compress.h"                     // CompressMPO
+#include "gqmps2/one_dim_tn/mpo/mpo_analysis.h"                     // AnalyzeMPO
 // Algorithms
 #include "gqmps2/algorithm/lanczos_solver.h"                        // LanczosParams
+#include "gqmps2/algorithm/expmv_solver.h"                          // ExpmvParams, ExpmvSolver
 #include "gqmps2/algorithm/vmps/two_site_update_finite_vmps.h"      // TwoSiteFiniteVMPS, SweepParams
+#include "gqmps2/algorithm/vmps/two_site_update_infinite_vmps.h"    // TwoSiteInfiniteVMPS, InfiniteSweepParams
 
 
 #endif /* ifndef GQMPS2_GQMPS2_H */
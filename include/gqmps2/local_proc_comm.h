@@ -0,0 +1,364 @@
+// SPDX-License-Identifier: LGPL-3.0-only
+
+/*
+* Author: Rongyang Sun <sun-rongyang@outlook.com>
+* Creation Date: 2020-10-17 09:30
+*
+* Description: GraceQ/MPS2 project. A MPI-style communicator over local
+*              processes.
+*/
+
+/**
+@file local_proc_comm.h
+@brief A MPI-style communicator which launches and connects several local
+       processes on one machine.
+*/
+#ifndef GQMPS2_LOCAL_PROC_COMM_H
+#define GQMPS2_LOCAL_PROC_COMM_H
+
+
+#include "gqten/gqten.h"
+#include "mkl.h"        // mkl_set_num_threads
+
+#include <iostream>
+#include <sstream>      // ostringstream, istringstream
+#include <string>       // string
+#include <vector>       // vector
+#include <cstdint>      // uint64_t
+#include <cerrno>       // errno, EINTR
+#include <cstdio>       // fflush, perror
+#include <cstring>      // memcpy
+
+#include <unistd.h>     // fork, read, write, close, _exit
+#include <sys/types.h>  // pid_t
+#include <sys/socket.h> // socketpair
+#include <sys/wait.h>   // waitpid
+#include <dirent.h>     // opendir, readdir, closedir
+
+#ifdef Release
+  #define NDEBUG
+#endif
+#include <assert.h>
+
+
+namespace gqmps2 {
+using namespace gqten;
+
+
+/**
+A MPI-style communicator over local processes. The constructor forks size-1
+worker processes. Each pair of the processes is connected by a stream socket,
+so that any process can exchange messages with any other one. All of the
+processes run on the same machine, but each of them has its own address space.
+*/
+class LocalProcComm {
+public:
+  /**
+  Launch size-1 worker processes. The constructor returns in all of the
+  processes, use rank() to distinguish them.
+
+  @param size The number of processes including the master process.
+
+  @note Construct it at the beginning of the program, before the MKL/OpenMP
+        threads are started. fork() only copies the calling thread, so a
+        thread pool started before is not usable in the workers. Each worker
+        runs the math library with one thread.
+  */
+  LocalProcComm(const size_t size) :
+      rank_(0), size_(size), fds_(size, -1), finalized_(false) {
+    assert(size >= 1);
+    auto thread_num = CountThreads_();
+    if (size > 1 && thread_num > 1) {
+      std::cout << "LocalProcComm: warning, the process already runs "
+                << thread_num << " threads before forking the workers. "
+                << "Construct the communicator before the MKL/OpenMP threads "
+                << "are started." << std::endl;
+    }
+    std::cout.flush();
+    std::fflush(stdout);
+    // pair_fds[p][q] is the socket end used by process p to talk to process q.
+    std::vector<std::vector<int>> pair_fds(size, std::vector<int>(size, -1));
+    for (size_t p = 0; p < size; ++p) {
+      for (size_t q = p + 1; q < size; ++q) {
+        int sv[2];
+        if (socketpair(AF_UNIX, SOCK_STREAM, 0, sv) != 0) {
+          perror("socketpair");
+          exit(1);
+        }
+        pair_fds[p][q] = sv[0];
+        pair_fds[q][p] = sv[1];
+      }
+    }
+    for (size_t r = 1; r < size; ++r) {
+      auto pid = fork();
+      if (pid < 0) {
+        perror("fork");
+        exit(1);
+      } else if (pid == 0) {
+        rank_ = r;
+        KeepFds_(pair_fds, r);
+        pids_.clear();
+        mkl_set_num_threads(1);
+        return;
+      } else {
+        pids_.push_back(pid);
+      }
+    }
+    KeepFds_(pair_fds, 0);
+  }
+
+  LocalProcComm(const LocalProcComm &) = delete;
+  LocalProcComm &operator=(const LocalProcComm &) = delete;
+
+  ~LocalProcComm(void) { if (rank_ == 0) { Finalize(); } }
+
+  /// Rank of current process.
+  size_t rank(void) const { return rank_; }
+
+  /// The number of processes.
+  size_t size(void) const { return size_; }
+
+  /**
+  Send a message.
+
+  @param msg The message.
+  @param dest Rank of the destination process.
+  */
+  void Send(const std::string &msg, const size_t dest) {
+    auto fd = GetFd_(dest);
+    uint64_t len = msg.size();
+    Write_(fd, reinterpret_cast<const char *>(&len), sizeof(len));
+    Write_(fd, msg.data(), len);
+  }
+
+  /**
+  Receive a message.
+
+  @param src Rank of the source process.
+  */
+  std::string Recv(const size_t src) {
+    auto fd = GetFd_(src);
+    uint64_t len;
+    Read_(fd, reinterpret_cast<char *>(&len), sizeof(len));
+    std::string msg(len, '\0');
+    Read_(fd, &msg[0], len);
+    return msg;
+  }
+
+  /**
+  Broadcast a message from the root process to all of the other processes.
+
+  @param msg The message. It will be overwritten by the received message on
+         the non-root processes.
+  @param root Rank of the root process.
+  */
+  void Bcast(std::string &msg, const size_t root = 0) {
+    if (rank_ == root) {
+      for (size_t r = 0; r < size_; ++r) {
+        if (r != root) { Send(msg, r); }
+      }
+    } else {
+      msg = Recv(root);
+    }
+  }
+
+  /**
+  Finalize the communicator. The master waits for all of the workers, a
+  worker exits.
+  */
+  void Finalize(void) {
+    if (finalized_) { return; }
+    for (size_t r = 0; r < size_; ++r) {
+      if (r != rank_) { close(fds_[r]); }
+    }
+    finalized_ = true;
+    if (rank_ == 0) {
+      for (auto pid : pids_) { waitpid(pid, nullptr, 0); }
+    } else {
+      std::cout.flush();
+      std::fflush(stdout);
+      _exit(0);
+    }
+  }
+
+private:
+  size_t rank_;
+  size_t size_;
+  std::vector<int> fds_;
+  std::vector<pid_t> pids_;
+  bool finalized_;
+
+  // Keep the socket ends of process r and close all of the others.
+  void KeepFds_(const std::vector<std::vector<int>> &pair_fds, const size_t r) {
+    for (size_t p = 0; p < size_; ++p) {
+      for (size_t q = 0; q < size_; ++q) {
+        if (p != r && pair_fds[p][q] != -1) { close(pair_fds[p][q]); }
+      }
+    }
+    fds_ = pair_fds[r];
+  }
+
+  int GetFd_(const size_t peer) const {
+    assert(peer < size_ && peer != rank_);
+    return fds_[peer];
+  }
+
+  // The number of threads of current process, 0 if it is unknown.
+  static size_t CountThreads_(void) {
+    auto dir = opendir("/proc/self/task");
+    if (dir == nullptr) { return 0; }
+    size_t thread_num = 0;
+    while (auto entry = readdir(dir)) {
+      if (entry->d_name[0] != '.') { thread_num++; }
+    }
+    closedir(dir);
+    return thread_num;
+  }
+
+  static void Write_(const int fd, const char *buf, size_t len) {
+    while (len > 0) {
+      auto n = write(fd, buf, len);
+      if (n < 0) {
+        if (errno == EINTR) { continue; }
+        perror("LocalProcComm write");
+        exit(1);
+      }
+      buf += n;
+      len -= n;
+    }
+  }
+
+  static void Read_(const int fd, char *buf, size_t len) {
+    while (len > 0) {
+      auto n = read(fd, buf, len);
+      if (n < 0) {
+        if (errno == EINTR) { continue; }
+        perror("LocalProcComm read");
+        exit(1);
+      } else if (n == 0) {
+        std::cout << "LocalProcComm: connection closed." << std::endl;
+        exit(1);
+      }
+      buf += n;
+      len -= n;
+    }
+  }
+};
+
+
+// Helpers for tensor communication.
+/**
+Serialize a tensor to a message. A nullptr is serialized to an empty message.
+*/
+template <typename TenT>
+inline std::string SerializeTen(const TenT *pten) {
+  if (pten == nullptr) { return std::string(); }
+  std::ostringstream oss(std::ostringstream::binary);
+  oss << *pten;
+  return oss.str();
+}
+
+
+/**
+Deserialize a tensor from a message. An empty message is deserialized to a
+nullptr.
+*/
+template <typename TenT>
+inline TenT *DeserializeTen(const std::string &msg) {
+  if (msg.empty()) { return nullptr; }
+  std::istringstream iss(msg, std::istringstream::binary);
+  auto pten = new TenT;
+  iss >> *pten;
+  return pten;
+}
+
+
+template <typename TenT>
+inline void SendTen(LocalProcComm &comm, const TenT *pten, const size_t dest) {
+  comm.Send(SerializeTen(pten), dest);
+}
+
+
+template <typename TenT>
+inline TenT *RecvTen(LocalProcComm &comm, const size_t src) {
+  return DeserializeTen<TenT>(comm.Recv(src));
+}
+
+
+/**
+Broadcast a tensor from the root process to all of the other processes.
+
+@param pten The tensor held by the root process. On the other processes, it
+       is set to a newly allocated copy, or nullptr if the root holds nullptr.
+@param root Rank of the root process.
+*/
+template <typename TenT>
+void BcastTen(LocalProcComm &comm, TenT * &pten, const size_t root = 0) {
+  auto msg = (comm.rank() == root) ? SerializeTen(pten) : std::string();
+  comm.Bcast(msg, root);
+  if (comm.rank() != root) { pten = DeserializeTen<TenT>(msg); }
+}
+
+
+/**
+Sum the tensors held by all of the processes. The result is returned on the
+root process, the other processes return nullptr. A process which holds a
+nullptr contributes nothing.
+
+@param pten The tensor held by current process. The ownership is taken.
+@param root Rank of the root process.
+*/
+template <typename TenT>
+TenT *ReduceSumTen(LocalProcComm &comm, TenT *pten, const size_t root = 0) {
+  if (comm.rank() != root) {
+    SendTen(comm, pten, root);
+    delete pten;
+    return nullptr;
+  }
+  for (size_t r = 0; r < comm.size(); ++r) {
+    if (r == root) { continue; }
+    auto prten = RecvTen<TenT>(comm, r);
+    if (prten == nullptr) { continue; }
+    if (pten == nullptr) {
+      pten = prten;
+    } else {
+      *pten += *prten;
+      delete prten;
+    }
+  }
+  return pten;
+}
+
+
+/**
+Broadcast a real number from the root process to all of the other processes.
+*/
+inline double BcastReal(LocalProcComm &comm, double x, const size_t root = 0) {
+  std::string msg(reinterpret_cast<const char *>(&x), sizeof(x));
+  comm.Bcast(msg, root);
+  std::memcpy(&x, msg.data(), sizeof(x));
+  return x;
+}
+
+
+/**
+Sum a real number over all of the processes. The sum is accumulated on the
+master in the rank order and then broadcast, so all of the processes get the
+same bits.
+*/
+inline double AllReduceSumReal(LocalProcComm &comm, const double x) {
+  double sum = x;
+  if (comm.rank() != 0) {
+    comm.Send(std::string(reinterpret_cast<const char *>(&x), sizeof(x)), 0);
+  } else {
+    for (size_t r = 1; r < comm.size(); ++r) {
+      double y;
+      auto msg = comm.Recv(r);
+      std::memcpy(&y, msg.data(), sizeof(y));
+      sum += y;
+    }
+  }
+  return BcastReal(comm, sum, 0);
+}
+} /* gqmps2 */
+#endif /* ifndef GQMPS2_LOCAL_PROC_COMM_H */
@@ -0,0 +1,1196 @@
+// SPDX-License-Identifier: LGPL-3.0-only
+/*
+* Author: Rongyang Sun <sun-rongyang@outlook.com>
+* Creation Date: 2020-10-20 14:32
+*
+* Description: GraceQ/MPS2 project. Quantum number block parallel tensor
+*              decomposition, including the truncated decomposition backends
+*              which only compute the kept singular triplets and the QR/LQ
+*              decompositions.
+*/
+
+/**
+@file ten_decomp.h
+@brief Quantum number block parallel tensor decomposition.
+*/
+#ifndef GQMPS2_MOCK_GQTEN_TEN_DECOMP_H
+#define GQMPS2_MOCK_GQTEN_TEN_DECOMP_H
+
+
+#include "gqmps2/consts.h"    // kDoubleEpsilon
+#include "gqten/gqten.h"
+
+#include <vector>       // vector
+#include <string>       // string
+#include <algorithm>    // sort, min
+#include <functional>   // function
+#include <unordered_map>  // unordered_map
+#include <thread>       // thread
+#include <atomic>       // atomic
+#include <iostream>     // cout, endl
+#include <cstdlib>      // exit
+#include <cmath>        // sqrt, ceil
+#include <random>       // mt19937, normal_distribution
+#include <assert.h>     // assert
+
+#include "mkl.h"      // LAPACKE_dgesdd, LAPACKE_zgesdd, cblas_dgemm, cblas_zgemm, ...
+
+
+namespace gqmps2 {
+using namespace gqten;
+
+
+/// Backend of the truncated decomposition.
+enum TruncDecompType {
+  FULL_SVD,             ///< Full SVD of each quantum number block.
+  RANDOMIZED_SVD,       ///< Randomized range finder SVD, only the leading triplets.
+  DENSITY_MATRIX_EIG    ///< Leading eigenpairs of the reduced density matrix.
+};
+
+
+/// Oversampling size of the randomized range finder.
+const size_t kRandSVDOversampling = 10;
+
+/// Number of power iterations of the randomized range finder.
+const size_t kRandSVDPowerIters = 2;
+
+
+/// The features in this namespace will be natively supported by GraceQ/tensor.
+namespace mock_gqten {
+
+
+/**
+Run func(0), func(1), ..., func(n-1) on at most thread_num threads.
+
+@param n Number of jobs.
+@param thread_num Maximal number of threads.
+@param func Job function. Different jobs must not write the same data.
+*/
+inline void ParallelFor(
+    const size_t n,
+    const size_t thread_num,
+    const std::function<void(const size_t)> &func
+) {
+  auto worker_num = std::min(n, thread_num);
+  if (worker_num <= 1) {
+    for (size_t i = 0; i < n; ++i) { func(i); }
+    return;
+  }
+  std::atomic<size_t> next_job(0);
+  std::vector<std::thread> workers;
+  workers.reserve(worker_num);
+  for (size_t w = 0; w < worker_num; ++w) {
+    workers.emplace_back(
+        [&next_job, n, &func]() {
+          for (size_t i = next_job++; i < n; i = next_job++) { func(i); }
+        }
+    );
+  }
+  for (auto &worker : workers) { worker.join(); }
+}
+
+
+/**
+A nonzero quantum number block of the matrix representation of a tensor. The
+first ldims indexes of the tensor are combined as the row and the others are
+combined as the column.
+*/
+template <typename TenElemT, typename QNT>
+struct QNBlockMat {
+  QNT lflow;                    ///< Quantum number flow of the row indexes.
+  std::vector<size_t> rows;     ///< Combined row coordinates of the block.
+  std::vector<size_t> cols;     ///< Combined column coordinates of the block.
+  std::vector<TenElemT> data;   ///< Row major dense data of the block.
+};
+
+
+/**
+Dense singular value decomposition of a quantum number block, M = U S Vt. The
+truncated backends only compute the leading k singular triplets; the weight of
+the block which is not captured by them is recorded as the residual weight.
+*/
+template <typename TenElemT>
+struct DenseSVDRes {
+  std::vector<TenElemT> u;      ///< Row major (m, k) matrix.
+  std::vector<double> s;        ///< k singular values in descending order.
+  std::vector<TenElemT> vt;     ///< Row major (k, n) matrix.
+  double residual_weight = 0.0; ///< Squared norm not captured by the k triplets.
+};
+
+
+/**
+Dense two-factor decomposition of a quantum number block, M = A B, without
+truncation. For the QR decomposition A is Q and B is R; for the LQ
+decomposition A is L and B is Q.
+*/
+template <typename TenElemT>
+struct DenseFactorRes {
+  std::vector<TenElemT> a;      ///< Row major (m, k) matrix, k = min(m, n).
+  std::vector<TenElemT> b;      ///< Row major (k, n) matrix.
+};
+
+
+// Helpers
+/**
+Coordinates of all the combined coordinates of the given shape, in a row major
+(combined_dim, rank) table. The table is built once per decomposition and
+shared by the extraction and the assembly of the blocks, so that no coordinate
+vector is allocated per element.
+*/
+inline std::vector<size_t> GenCombinedCoorsTable(
+    const std::vector<size_t> &shape
+) {
+  auto rank = shape.size();
+  size_t combined_dim = 1;
+  for (auto dim : shape) { combined_dim *= dim; }
+  std::vector<size_t> table(combined_dim * rank);
+  std::vector<size_t> coors(rank, 0);
+  for (size_t combined_coor = 0; combined_coor < combined_dim; ++combined_coor) {
+    std::copy(coors.begin(), coors.end(), table.begin() + combined_coor * rank);
+    for (size_t i = rank; i > 0; --i) {
+      if (++coors[i-1] < shape[i-1]) { break; }
+      coors[i-1] = 0;
+    }
+  }
+  return table;
+}
+
+
+// Group the combined coordinates of indexes [begin, end) by their quantum
+// number flow, outgoing indexes count positively and ingoing ones negatively.
+// The flow is evaluated once per combination of the quantum number sectors and
+// looked up by its hash. The groups are ordered by their first combined
+// coordinate and each group is in ascending order.
+template <typename QNT>
+void GroupCombinedCoorsByQNFlow_(
+    const std::vector<Index<QNT>> &indexes,
+    const size_t begin, const size_t end,
+    const QNT &zero_qn,
+    std::vector<size_t> &shape,
+    std::vector<QNT> &flows,
+    std::vector<std::vector<size_t>> &groups
+) {
+  auto rank = end - begin;
+  std::vector<std::vector<QNT>> signed_qns(rank);
+  std::vector<std::vector<size_t>> sct_offsets(rank), sct_dims(rank);
+  for (size_t i = 0; i < rank; ++i) {
+    auto &index = indexes[begin + i];
+    shape.push_back(index.dim());
+    size_t offset = 0;
+    for (size_t j = 0; j < index.GetQNSctNum(); ++j) {
+      auto qnsct = index.GetQNSct(j);
+      auto qn = qnsct.GetQn();
+      if (index.GetDir() == GQTenIndexDirType::OUT) {
+        signed_qns[i].push_back(qn);
+      } else {
+        signed_qns[i].push_back(zero_qn - qn);
+      }
+      sct_offsets[i].push_back(offset);
+      sct_dims[i].push_back(qnsct.dim());
+      offset += qnsct.dim();
+    }
+  }
+  std::vector<size_t> strides(rank, 1);
+  for (size_t i = rank; i > 1; --i) { strides[i-2] = strides[i-1] * shape[i-1]; }
+
+  // Sector combinations in lexicographic order visit the flows in the order of
+  // their first combined coordinates.
+  std::unordered_map<size_t, std::vector<size_t>> hash_groups;
+  std::vector<size_t> sct_coors(rank, 0), coors(rank, 0);
+  bool has_sct = true;
+  for (size_t i = 0; i < rank; ++i) {
+    if (signed_qns[i].empty()) { has_sct = false; }
+  }
+  while (has_sct) {
+    QNT flow = zero_qn;
+    for (size_t i = 0; i < rank; ++i) { flow += signed_qns[i][sct_coors[i]]; }
+    auto &candidates = hash_groups[flow.Hash()];
+    size_t g = flows.size();
+    for (auto candidate : candidates) {
+      if (flows[candidate] == flow) {
+        g = candidate;
+        break;
+      }
+    }
+    if (g == flows.size()) {
+      candidates.push_back(g);
+      flows.push_back(flow);
+      groups.push_back({});
+    }
+    // All the combined coordinates of the sector combination.
+    for (size_t i = 0; i < rank; ++i) { coors[i] = 0; }
+    while (true) {
+      size_t combined_coor = 0;
+      for (size_t i = 0; i < rank; ++i) {
+        combined_coor += (sct_offsets[i][sct_coors[i]] + coors[i]) * strides[i];
+      }
+      groups[g].push_back(combined_coor);
+      size_t i = rank;
+      for (; i > 0; --i) {
+        if (++coors[i-1] < sct_dims[i-1][sct_coors[i-1]]) { break; }
+        coors[i-1] = 0;
+      }
+      if (i == 0) { break; }
+    }
+    size_t i = rank;
+    for (; i > 0; --i) {
+      if (++sct_coors[i-1] < signed_qns[i-1].size()) { break; }
+      sct_coors[i-1] = 0;
+    }
+    if (i == 0) { break; }
+  }
+  for (auto &group : groups) { std::sort(group.begin(), group.end()); }
+}
+
+
+/**
+Extract the nonzero quantum number blocks of the matrix representation of a
+tensor.
+
+@param t The tensor.
+@param ldims Number of indexes combined as the row.
+@param lshape Output shape of the row indexes.
+@param rshape Output shape of the column indexes.
+*/
+template <typename TenElemT, typename QNT>
+std::vector<QNBlockMat<TenElemT, QNT>> ExtractQNBlockMats(
+    const GQTensor<TenElemT, QNT> &t,
+    const size_t ldims,
+    std::vector<size_t> &lshape,
+    std::vector<size_t> &rshape
+) {
+  auto div = Div(t);
+  auto zero_qn = div - div;
+  auto indexes = t.GetIndexes();
+  auto rank = indexes.size();
+  auto rdims = rank - ldims;
+  std::vector<QNT> lflows, rflows;
+  std::vector<std::vector<size_t>> lgroups, rgroups;
+  GroupCombinedCoorsByQNFlow_(
+      indexes, 0, ldims, zero_qn, lshape, lflows, lgroups
+  );
+  GroupCombinedCoorsByQNFlow_(
+      indexes, ldims, rank, zero_qn, rshape, rflows, rgroups
+  );
+  auto lcoors_table = GenCombinedCoorsTable(lshape);
+  auto rcoors_table = GenCombinedCoorsTable(rshape);
+
+  std::vector<QNBlockMat<TenElemT, QNT>> blocks;
+  std::vector<size_t> coors(rank);
+  for (size_t lg = 0; lg < lflows.size(); ++lg) {
+    for (size_t rg = 0; rg < rflows.size(); ++rg) {
+      if (lflows[lg] + rflows[rg] != div) { continue; }
+      QNBlockMat<TenElemT, QNT> block;
+      block.lflow = lflows[lg];
+      block.rows = lgroups[lg];
+      block.cols = rgroups[rg];
+      block.data.reserve(block.rows.size() * block.cols.size());
+      for (auto row : block.rows) {
+        auto lcoors = lcoors_table.begin() + row * ldims;
+        std::copy(lcoors, lcoors + ldims, coors.begin());
+        for (auto col : block.cols) {
+          auto rcoors = rcoors_table.begin() + col * rdims;
+          std::copy(rcoors, rcoors + rdims, coors.begin() + ldims);
+          block.data.push_back(t.GetElem(coors));
+        }
+      }
+      blocks.push_back(std::move(block));
+    }
+  }
+  return blocks;
+}
+
+
+inline lapack_int DenseSVD_(
+    const size_t m, const size_t n,
+    GQTEN_Double *a, double *s, GQTEN_Double *u, GQTEN_Double *vt
+) {
+  auto k = std::min(m, n);
+  return LAPACKE_dgesdd(LAPACK_ROW_MAJOR, 'S', m, n, a, n, s, u, k, vt, n);
+}
+
+
+inline lapack_int DenseSVD_(
+    const size_t m, const size_t n,
+    GQTEN_Complex *a, double *s, GQTEN_Complex *u, GQTEN_Complex *vt
+) {
+  auto k = std::min(m, n);
+  return LAPACKE_zgesdd(LAPACK_ROW_MAJOR, 'S', m, n, a, n, s, u, k, vt, n);
+}
+
+
+/**
+Full singular value decomposition of a dense quantum number block.
+*/
+template <typename TenElemT, typename QNT>
+DenseSVDRes<TenElemT> BlockSVD(QNBlockMat<TenElemT, QNT> &block) {
+  auto m = block.rows.size();
+  auto n = block.cols.size();
+  auto k = std::min(m, n);
+  DenseSVDRes<TenElemT> res;
+  res.u.resize(m * k);
+  res.s.resize(k);
+  res.vt.resize(k * n);
+  auto info = DenseSVD_(
+                  m, n,
+                  block.data.data(), res.s.data(), res.u.data(), res.vt.data()
+              );
+  if (info != 0) {
+    std::cout << "Block SVD failed with info = " << info << std::endl;
+    exit(1);
+  }
+  return res;
+}
+
+
+inline double AbsSquare_(const GQTEN_Double x) { return x * x; }
+
+
+inline double AbsSquare_(const GQTEN_Complex z) { return std::norm(z); }
+
+
+inline GQTEN_Double Conj_(const GQTEN_Double x) { return x; }
+
+
+inline GQTEN_Complex Conj_(const GQTEN_Complex z) { return std::conj(z); }
+
+
+inline void RandNormal_(std::mt19937 &gen, GQTEN_Double &x) {
+  std::normal_distribution<double> dist(0.0, 1.0);
+  x = dist(gen);
+}
+
+
+inline void RandNormal_(std::mt19937 &gen, GQTEN_Complex &z) {
+  std::normal_distribution<double> dist(0.0, 1.0);
+  auto re = dist(gen);
+  auto im = dist(gen);
+  z = GQTEN_Complex(re, im);
+}
+
+
+// Row major C(m, n) = op(A) op(B), op is identity or conjugate transpose.
+inline void DenseGemm_(
+    const CBLAS_TRANSPOSE transa, const CBLAS_TRANSPOSE transb,
+    const size_t m, const size_t n, const size_t k,
+    const GQTEN_Double *a, const size_t lda,
+    const GQTEN_Double *b, const size_t ldb,
+    GQTEN_Double *c
+) {
+  cblas_dgemm(
+      CblasRowMajor, transa, transb, m, n, k,
+      1.0, a, lda, b, ldb, 0.0, c, n
+  );
+}
+
+
+inline void DenseGemm_(
+    const CBLAS_TRANSPOSE transa, const CBLAS_TRANSPOSE transb,
+    const size_t m, const size_t n, const size_t k,
+    const GQTEN_Complex *a, const size_t lda,
+    const GQTEN_Complex *b, const size_t ldb,
+    GQTEN_Complex *c
+) {
+  GQTEN_Complex alpha(1.0, 0.0), beta(0.0, 0.0);
+  cblas_zgemm(
+      CblasRowMajor, transa, transb, m, n, k,
+      &alpha, a, lda, b, ldb, &beta, c, n
+  );
+}
+
+
+// Householder QR of the row major (m, n) matrix a, see LAPACK ?geqrf.
+inline lapack_int DenseGeqrf_(
+    const size_t m, const size_t n, GQTEN_Double *a, GQTEN_Double *tau
+) {
+  return LAPACKE_dgeqrf(LAPACK_ROW_MAJOR, m, n, a, n, tau);
+}
+
+
+inline lapack_int DenseGeqrf_(
+    const size_t m, const size_t n, GQTEN_Complex *a, GQTEN_Complex *tau
+) {
+  return LAPACKE_zgeqrf(LAPACK_ROW_MAJOR, m, n, a, n, tau);
+}
+
+
+// Form the row major (m, k) Q from the reflectors of DenseGeqrf_ stored in a.
+inline lapack_int DenseOrgqr_(
+    const size_t m, const size_t k, GQTEN_Double *a, const GQTEN_Double *tau
+) {
+  return LAPACKE_dorgqr(LAPACK_ROW_MAJOR, m, k, k, a, k, tau);
+}
+
+
+inline lapack_int DenseOrgqr_(
+    const size_t m, const size_t k, GQTEN_Complex *a, const GQTEN_Complex *tau
+) {
+  return LAPACKE_zungqr(LAPACK_ROW_MAJOR, m, k, k, a, k, tau);
+}
+
+
+// Replace the row major (m, k) matrix a (m >= k) by the Q of its QR decomposition.
+template <typename TenElemT>
+lapack_int DenseQ_(const size_t m, const size_t k, TenElemT *a) {
+  std::vector<TenElemT> tau(k);
+  auto info = DenseGeqrf_(m, k, a, tau.data());
+  if (info != 0) { return info; }
+  return DenseOrgqr_(m, k, a, tau.data());
+}
+
+
+// The largest k eigenpairs of the row major (n, n) Hermitian matrix a in
+// ascending order. The eigenvectors are the columns of the row major (n, k) z.
+// k must be positive, ?syevr rejects the empty index range il > iu.
+inline lapack_int DenseLargestEigs_(
+    const size_t n, const size_t k,
+    GQTEN_Double *a, double *w, GQTEN_Double *z
+) {
+  lapack_int found;
+  std::vector<lapack_int> isuppz(2 * k);
+  return LAPACKE_dsyevr(
+             LAPACK_ROW_MAJOR, 'V', 'I', 'U', n, a, n,
+             0.0, 0.0, n - k + 1, n, 0.0, &found, w, z, k, isuppz.data()
+         );
+}
+
+
+inline lapack_int DenseLargestEigs_(
+    const size_t n, const size_t k,
+    GQTEN_Complex *a, double *w, GQTEN_Complex *z
+) {
+  lapack_int found;
+  std::vector<lapack_int> isuppz(2 * k);
+  return LAPACKE_zheevr(
+             LAPACK_ROW_MAJOR, 'V', 'I', 'U', n, a, n,
+             0.0, 0.0, n - k + 1, n, 0.0, &found, w, z, k, isuppz.data()
+         );
+}
+
+
+inline void CheckLapackInfo_(const lapack_int info, const std::string &where) {
+  if (info != 0) {
+    std::cout << where << " failed with info = " << info << std::endl;
+    exit(1);
+  }
+}
+
+
+template <typename TenElemT>
+double SquaredNorm_(const std::vector<TenElemT> &data) {
+  double norm2 = 0.0;
+  for (auto &elem : data) { norm2 += AbsSquare_(elem); }
+  return norm2;
+}
+
+
+inline double CapturedWeightResidual_(
+    const double norm2,
+    const std::vector<double> &s
+) {
+  double captured_weight = 0.0;
+  for (auto sv : s) { captured_weight += sv * sv; }
+  return std::max(norm2 - captured_weight, 0.0);
+}
+
+
+/**
+Randomized range finder SVD of a dense quantum number block which only
+computes the leading rank singular triplets. The range of the block is sampled
+by rank + kRandSVDOversampling Gaussian vectors refined by kRandSVDPowerIters
+power iterations; the block is then projected onto the range and decomposed
+exactly. Small blocks fall back to the full SVD.
+
+@param block The quantum number block.
+@param rank Number of wanted singular triplets.
+@param seed Seed of the random Gaussian vectors.
+*/
+template <typename TenElemT, typename QNT>
+DenseSVDRes<TenElemT> BlockRandomizedSVD(
+    QNBlockMat<TenElemT, QNT> &block,
+    const size_t rank,
+    const unsigned seed
+) {
+  auto m = block.rows.size();
+  auto n = block.cols.size();
+  auto l = rank + kRandSVDOversampling;
+  if (l >= std::min(m, n)) { return BlockSVD(block); }
+  auto a = block.data.data();
+  auto norm2 = SquaredNorm_(block.data);
+
+  // Sample the range: Y = (A A^dag)^q A Omega.
+  std::mt19937 gen(seed);
+  std::vector<TenElemT> omega(n * l);
+  for (auto &elem : omega) { RandNormal_(gen, elem); }
+  std::vector<TenElemT> y(m * l), z(n * l);
+  DenseGemm_(CblasNoTrans, CblasNoTrans, m, l, n, a, n, omega.data(), l, y.data());
+  for (size_t q = 0; q < kRandSVDPowerIters; ++q) {
+    CheckLapackInfo_(DenseQ_(m, l, y.data()), "Randomized SVD QR");
+    DenseGemm_(CblasConjTrans, CblasNoTrans, n, l, m, a, n, y.data(), l, z.data());
+    CheckLapackInfo_(DenseQ_(n, l, z.data()), "Randomized SVD QR");
+    DenseGemm_(CblasNoTrans, CblasNoTrans, m, l, n, a, n, z.data(), l, y.data());
+  }
+  CheckLapackInfo_(DenseQ_(m, l, y.data()), "Randomized SVD QR");
+
+  // B = Q^dag A and its exact SVD B = Ub S Vt, then U = Q Ub.
+  std::vector<TenElemT> b(l * n);
+  DenseGemm_(CblasConjTrans, CblasNoTrans, l, n, m, y.data(), l, a, n, b.data());
+  std::vector<TenElemT> ub(l * l), vt(l * n);
+  std::vector<double> s(l);
+  CheckLapackInfo_(
+      DenseSVD_(l, n, b.data(), s.data(), ub.data(), vt.data()),
+      "Randomized SVD projected block SVD"
+  );
+  std::vector<TenElemT> u(m * l);
+  DenseGemm_(CblasNoTrans, CblasNoTrans, m, l, l, y.data(), l, ub.data(), l, u.data());
+
+  DenseSVDRes<TenElemT> res;
+  res.s.assign(s.begin(), s.begin() + rank);
+  res.u.resize(m * rank);
+  for (size_t i = 0; i < m; ++i) {
+    for (size_t j = 0; j < rank; ++j) { res.u[i * rank + j] = u[i * l + j]; }
+  }
+  res.vt.assign(vt.begin(), vt.begin() + rank * n);
+  res.residual_weight = CapturedWeightResidual_(norm2, res.s);
+  return res;
+}
+
+
+/**
+Decompose a dense quantum number block by the leading rank eigenpairs of its
+reduced density matrix on the smaller side, M M^dag or M^dag M. The singular
+vectors on the other side follow from the projection of the block. Singular
+values below sqrt(machine epsilon) times the largest one lose relative
+accuracy, which does not affect the kept states of a normal truncation.
+
+Forming the density matrix is a full GEMM of O(m n min(m, n)) operations,
+which is the same order as the full SVD of the block. This backend only pays
+off when rank is much smaller than min(m, n), where the partial
+eigendecomposition is much cheaper than the full SVD.
+
+@param block The quantum number block.
+@param rank Number of wanted singular triplets.
+*/
+template <typename TenElemT, typename QNT>
+DenseSVDRes<TenElemT> BlockDensityMatrixEig(
+    QNBlockMat<TenElemT, QNT> &block,
+    const size_t rank
+) {
+  auto m = block.rows.size();
+  auto n = block.cols.size();
+  auto a = block.data.data();
+  auto norm2 = SquaredNorm_(block.data);
+  auto left = (m <= n);
+  auto dm_dim = left ? m : n;
+  auto k = std::min(rank, dm_dim);
+  DenseSVDRes<TenElemT> res;
+  if (k == 0) {
+    res.residual_weight = norm2;
+    return res;
+  }
+
+  std::vector<TenElemT> dm(dm_dim * dm_dim);
+  if (left) {
+    DenseGemm_(CblasNoTrans, CblasConjTrans, m, m, n, a, n, a, n, dm.data());
+  } else {
+    DenseGemm_(CblasConjTrans, CblasNoTrans, n, n, m, a, n, a, n, dm.data());
+  }
+  std::vector<double> w(dm_dim);
+  std::vector<TenElemT> evecs(dm_dim * k);
+  CheckLapackInfo_(
+      DenseLargestEigs_(dm_dim, k, dm.data(), w.data(), evecs.data()),
+      "Density matrix eigendecomposition"
+  );
+
+  // Reorder to the descending order.
+  res.s.resize(k);
+  std::vector<TenElemT> vecs(dm_dim * k);
+  for (size_t j = 0; j < k; ++j) {
+    res.s[j] = std::sqrt(std::max(w[k - 1 - j], 0.0));
+    for (size_t i = 0; i < dm_dim; ++i) {
+      vecs[i * k + j] = evecs[i * k + (k - 1 - j)];
+    }
+  }
+  auto sv_cut = res.s[0] * kDoubleEpsilon;
+
+  if (left) {
+    // U from the eigenvectors, Vt = S^-1 U^dag A.
+    res.u = std::move(vecs);
+    res.vt.resize(k * n);
+    DenseGemm_(CblasConjTrans, CblasNoTrans, k, n, m, res.u.data(), k, a, n, res.vt.data());
+    for (size_t j = 0; j < k; ++j) {
+      auto inv_s = (res.s[j] > sv_cut) ? 1.0 / res.s[j] : 0.0;
+      for (size_t c = 0; c < n; ++c) { res.vt[j * n + c] *= inv_s; }
+    }
+  } else {
+    // Vt from the eigenvectors, U = A V S^-1.
+    res.vt.resize(k * n);
+    for (size_t j = 0; j < k; ++j) {
+      for (size_t c = 0; c < n; ++c) { res.vt[j * n + c] = Conj_(vecs[c * k + j]); }
+    }
+    res.u.resize(m * k);
+    DenseGemm_(CblasNoTrans, CblasNoTrans, m, k, n, a, n, vecs.data(), k, res.u.data());
+    for (size_t j = 0; j < k; ++j) {
+      auto inv_s = (res.s[j] > sv_cut) ? 1.0 / res.s[j] : 0.0;
+      for (size_t r = 0; r < m; ++r) { res.u[r * k + j] *= inv_s; }
+    }
+  }
+  res.residual_weight = CapturedWeightResidual_(norm2, res.s);
+  return res;
+}
+
+
+/**
+Merge the singular values of all blocks and determine how many of them are
+kept in each block. The semantics follows the truncated SVD of GraceQ/tensor:
+keep the minimal number (but not less than Dmin) of the largest singular values
+whose discarded weight is not larger than trunc_err, and never keep more than
+Dmax of them.
+
+@param svs Singular values of each block, in descending order.
+@param residual_weight Weight which is not captured by the given singular
+       values, it is always discarded.
+@param trunc_err Target truncation error.
+@param Dmin Minimal kept dimension.
+@param Dmax Maximal kept dimension.
+@param pactual_trunc_err Output actual truncation error.
+@param pD Output actual kept dimension.
+
+@return Number of kept singular values of each block.
+*/
+inline std::vector<size_t> MergeTruncateSingularValues(
+    const std::vector<std::vector<double>> &svs,
+    const double residual_weight,
+    const double trunc_err,
+    const size_t Dmin,
+    const size_t Dmax,
+    double *pactual_trunc_err,
+    size_t *pD
+) {
+  std::vector<std::pair<double, size_t>> all_svs;
+  double total_weight = residual_weight;
+  for (size_t b = 0; b < svs.size(); ++b) {
+    for (auto sv : svs[b]) {
+      all_svs.push_back(std::make_pair(sv, b));
+      total_weight += sv * sv;
+    }
+  }
+  std::stable_sort(
+      all_svs.begin(), all_svs.end(),
+      [](const std::pair<double, size_t> &a, const std::pair<double, size_t> &b) {
+        return a.first > b.first;
+      }
+  );
+
+  auto total_dim = all_svs.size();
+  auto D = std::min(Dmin, total_dim);
+  double discarded_weight = residual_weight;
+  for (size_t i = D; i < total_dim; ++i) {
+    discarded_weight += all_svs[i].first * all_svs[i].first;
+  }
+  auto D_upper = std::min(std::max(Dmax, D), total_dim);
+  while (D < D_upper && discarded_weight > trunc_err * total_weight) {
+    discarded_weight -= all_svs[D].first * all_svs[D].first;
+    ++D;
+  }
+
+  std::vector<size_t> kept_dims(svs.size(), 0);
+  for (size_t i = 0; i < D; ++i) { kept_dims[all_svs[i].second]++; }
+  *pactual_trunc_err = (total_weight > 0.0) ?
+                       std::max(discarded_weight, 0.0) / total_weight : 0.0;
+  *pD = D;
+  return kept_dims;
+}
+
+
+// Write the first bond_dims[b] columns of the row major (m, ld) factor as[b]
+// and the first bond_dims[b] rows of the row major (k, n) factor bs[b] of each
+// block to the tensors A and B, whose new bond coordinates of the block start
+// at bond_offsets[b].
+template <typename TenElemT, typename QNT>
+void AssembleBlockFactors_(
+    const std::vector<QNBlockMat<TenElemT, QNT>> &blocks,
+    const std::vector<const std::vector<TenElemT> *> &as,
+    const std::vector<size_t> &a_lds,
+    const std::vector<const std::vector<TenElemT> *> &bs,
+    const std::vector<size_t> &bond_offsets,
+    const std::vector<size_t> &bond_dims,
+    const std::vector<size_t> &lshape,
+    const std::vector<size_t> &rshape,
+    GQTensor<TenElemT, QNT> *pa,
+    GQTensor<TenElemT, QNT> *pb
+) {
+  auto ldims = lshape.size();
+  auto rdims = rshape.size();
+  auto lcoors_table = GenCombinedCoorsTable(lshape);
+  auto rcoors_table = GenCombinedCoorsTable(rshape);
+  std::vector<size_t> acoors(ldims + 1), bcoors(rdims + 1);
+  for (size_t b = 0; b < blocks.size(); ++b) {
+    auto k = bond_dims[b];
+    if (k == 0) { continue; }
+    auto &block = blocks[b];
+    auto &a = *as[b];
+    auto &bmat = *bs[b];
+    auto lda = a_lds[b];
+    auto n = block.cols.size();
+    for (size_t r = 0; r < block.rows.size(); ++r) {
+      auto lcoors = lcoors_table.begin() + block.rows[r] * ldims;
+      std::copy(lcoors, lcoors + ldims, acoors.begin());
+      for (size_t j = 0; j < k; ++j) {
+        acoors[ldims] = bond_offsets[b] + j;
+        (*pa)(acoors) = a[r * lda + j];
+      }
+    }
+    for (size_t c = 0; c < n; ++c) {
+      auto rcoors = rcoors_table.begin() + block.cols[c] * rdims;
+      std::copy(rcoors, rcoors + rdims, bcoors.begin() + 1);
+      for (size_t j = 0; j < k; ++j) {
+        bcoors[0] = bond_offsets[b] + j;
+        (*pb)(bcoors) = bmat[j * n + c];
+      }
+    }
+  }
+}
+
+
+/**
+Assemble the truncated U, S and Vt tensors from the decomposed blocks. The new
+bond of U goes out with one quantum number sector per block with kept singular
+values.
+*/
+template <typename TenElemT, typename QNT>
+void AssembleBlockSVDRes(
+    const GQTensor<TenElemT, QNT> &t,
+    const size_t ldims,
+    const QNT &lqndiv,
+    const std::vector<QNBlockMat<TenElemT, QNT>> &blocks,
+    const std::vector<DenseSVDRes<TenElemT>> &block_svd_res,
+    const std::vector<size_t> &kept_dims,
+    const std::vector<size_t> &lshape,
+    const std::vector<size_t> &rshape,
+    GQTensor<TenElemT, QNT> *pu,
+    GQTensor<GQTEN_Double, QNT> *ps,
+    GQTensor<TenElemT, QNT> *pvt
+) {
+  using IndexT = Index<QNT>;
+  std::vector<QNSector<QNT>> bond_scts;
+  std::vector<size_t> bond_offsets(blocks.size(), 0);
+  size_t bond_dim = 0;
+  for (size_t b = 0; b < blocks.size(); ++b) {
+    bond_offsets[b] = bond_dim;
+    if (kept_dims[b] == 0) { continue; }
+    bond_scts.push_back(QNSector<QNT>(lqndiv - blocks[b].lflow, kept_dims[b]));
+    bond_dim += kept_dims[b];
+  }
+  auto bond_out = IndexT(bond_scts, GQTenIndexDirType::OUT);
+  auto bond_in = InverseIndex(bond_out);
+
+  auto indexes = t.GetIndexes();
+  std::vector<IndexT> u_indexes(indexes.begin(), indexes.begin() + ldims);
+  u_indexes.push_back(bond_out);
+  std::vector<IndexT> vt_indexes = {bond_in};
+  vt_indexes.insert(vt_indexes.end(), indexes.begin() + ldims, indexes.end());
+  *pu = GQTensor<TenElemT, QNT>(u_indexes);
+  *ps = GQTensor<GQTEN_Double, QNT>({bond_in, bond_out});
+  *pvt = GQTensor<TenElemT, QNT>(vt_indexes);
+
+  for (size_t b = 0; b < blocks.size(); ++b) {
+    for (size_t j = 0; j < kept_dims[b]; ++j) {
+      auto bond_coor = bond_offsets[b] + j;
+      (*ps)({bond_coor, bond_coor}) = block_svd_res[b].s[j];
+    }
+  }
+  std::vector<const std::vector<TenElemT> *> us, vts;
+  std::vector<size_t> u_lds;
+  for (auto &res : block_svd_res) {
+    us.push_back(&res.u);
+    vts.push_back(&res.vt);
+    u_lds.push_back(res.s.size());
+  }
+  AssembleBlockFactors_(
+      blocks, us, u_lds, vts, bond_offsets, kept_dims,
+      lshape, rshape, pu, pvt
+  );
+}
+
+
+/**
+QR decomposition of the row major (m, n) matrix a, which is destroyed.
+*/
+template <typename TenElemT>
+DenseFactorRes<TenElemT> DenseQR_(
+    const size_t m, const size_t n, TenElemT *a
+) {
+  auto k = std::min(m, n);
+  std::vector<TenElemT> tau(k);
+  CheckLapackInfo_(DenseGeqrf_(m, n, a, tau.data()), "Block QR");
+  DenseFactorRes<TenElemT> res;
+  res.b.assign(k * n, TenElemT(0));
+  for (size_t i = 0; i < k; ++i) {
+    for (size_t j = i; j < n; ++j) { res.b[i * n + j] = a[i * n + j]; }
+  }
+  res.a.resize(m * k);
+  for (size_t i = 0; i < m; ++i) {
+    for (size_t j = 0; j < k; ++j) { res.a[i * k + j] = a[i * n + j]; }
+  }
+  CheckLapackInfo_(DenseOrgqr_(m, k, res.a.data(), tau.data()), "Block QR");
+  return res;
+}
+
+
+/**
+QR decomposition of a dense quantum number block, M = Q R.
+*/
+template <typename TenElemT, typename QNT>
+DenseFactorRes<TenElemT> BlockQR(QNBlockMat<TenElemT, QNT> &block) {
+  return DenseQR_(block.rows.size(), block.cols.size(), block.data.data());
+}
+
+
+/**
+LQ decomposition of a dense quantum number block, M = L Q. It is obtained from
+the QR decomposition of the adjoint, \f$M^{\dagger} = Q' R'\f$, so that
+\f$L = R'^{\dagger}\f$ and \f$Q = Q'^{\dagger}\f$.
+*/
+template <typename TenElemT, typename QNT>
+DenseFactorRes<TenElemT> BlockLQ(QNBlockMat<TenElemT, QNT> &block) {
+  auto m = block.rows.size();
+  auto n = block.cols.size();
+  auto k = std::min(m, n);
+  std::vector<TenElemT> adj(n * m);
+  for (size_t i = 0; i < m; ++i) {
+    for (size_t j = 0; j < n; ++j) {
+      adj[j * m + i] = Conj_(block.data[i * n + j]);
+    }
+  }
+  auto adj_res = DenseQR_(n, m, adj.data());
+  DenseFactorRes<TenElemT> res;
+  res.a.resize(m * k);
+  for (size_t i = 0; i < m; ++i) {
+    for (size_t j = 0; j < k; ++j) { res.a[i * k + j] = Conj_(adj_res.b[j * m + i]); }
+  }
+  res.b.resize(k * n);
+  for (size_t j = 0; j < k; ++j) {
+    for (size_t c = 0; c < n; ++c) { res.b[j * n + c] = Conj_(adj_res.a[c * k + j]); }
+  }
+  return res;
+}
+
+
+/**
+Decompose the quantum number blocks of the matrix representation of a tensor
+into two factors in parallel and assemble them to the tensors A and B,
+T = A B. The new bond of A goes out with one quantum number sector of dimension
+min(m, n) per block.
+*/
+template <typename TenElemT, typename QNT>
+void BlockFactorize_(
+    const GQTensor<TenElemT, QNT> *pt,
+    const size_t ldims,
+    const QNT &lqndiv,
+    const std::function<
+        DenseFactorRes<TenElemT>(QNBlockMat<TenElemT, QNT> &)
+    > &block_decomp,
+    GQTensor<TenElemT, QNT> *pa,
+    GQTensor<TenElemT, QNT> *pb,
+    const size_t thread_num
+) {
+  using IndexT = Index<QNT>;
+  std::vector<size_t> lshape, rshape;
+  auto blocks = ExtractQNBlockMats(*pt, ldims, lshape, rshape);
+  std::vector<DenseFactorRes<TenElemT>> block_res(blocks.size());
+  ParallelFor(
+      blocks.size(), thread_num,
+      [&blocks, &block_res, &block_decomp](const size_t b) {
+        block_res[b] = block_decomp(blocks[b]);
+      }
+  );
+
+  std::vector<QNSector<QNT>> bond_scts;
+  std::vector<size_t> bond_offsets(blocks.size(), 0);
+  size_t bond_dim = 0;
+  for (size_t b = 0; b < blocks.size(); ++b) {
+    auto k = std::min(blocks[b].rows.size(), blocks[b].cols.size());
+    bond_offsets[b] = bond_dim;
+    bond_scts.push_back(QNSector<QNT>(lqndiv - blocks[b].lflow, k));
+    bond_dim += k;
+  }
+  auto bond_out = IndexT(bond_scts, GQTenIndexDirType::OUT);
+  auto bond_in = InverseIndex(bond_out);
+
+  auto indexes = pt->GetIndexes();
+  std::vector<IndexT> a_indexes(indexes.begin(), indexes.begin() + ldims);
+  a_indexes.push_back(bond_out);
+  std::vector<IndexT> b_indexes = {bond_in};
+  b_indexes.insert(b_indexes.end(), indexes.begin() + ldims, indexes.end());
+  *pa = GQTensor<TenElemT, QNT>(a_indexes);
+  *pb = GQTensor<TenElemT, QNT>(b_indexes);
+
+  std::vector<const std::vector<TenElemT> *> as, bs;
+  std::vector<size_t> bond_dims;
+  for (size_t b = 0; b < blocks.size(); ++b) {
+    as.push_back(&block_res[b].a);
+    bs.push_back(&block_res[b].b);
+    bond_dims.push_back(std::min(blocks[b].rows.size(), blocks[b].cols.size()));
+  }
+  AssembleBlockFactors_(
+      blocks, as, bond_dims, bs, bond_offsets, bond_dims,
+      lshape, rshape, pa, pb
+  );
+}
+
+
+/**
+QR decomposition T = Q R which decomposes the quantum number blocks of the
+matrix representation of the tensor in parallel. Q has orthonormal columns and
+is left canonical.
+
+@note The MPS canonicalization still uses the native SVD. The blocks are
+      copied in and out element by element (ExtractQNBlockMats,
+      AssembleBlockFactors_), so the cheaper factorization does not pay off
+      until GraceQ/tensor gives access to its blocks.
+
+@param pt To-be decomposed tensor.
+@param ldims Number of indexes combined as the row.
+@param lqndiv Quantum number divergence of Q.
+@param pq Output Q tensor, the first ldims indexes of T and the new bond.
+@param pr Output R tensor, the new bond and the other indexes of T.
+@param thread_num Number of threads used to decompose the blocks.
+*/
+template <typename TenElemT, typename QNT>
+void QR(
+    const GQTensor<TenElemT, QNT> *pt,
+    const size_t ldims,
+    const QNT &lqndiv,
+    GQTensor<TenElemT, QNT> *pq,
+    GQTensor<TenElemT, QNT> *pr,
+    const size_t thread_num = 1
+) {
+  BlockFactorize_<TenElemT, QNT>(
+      pt, ldims, lqndiv, BlockQR<TenElemT, QNT>, pq, pr, thread_num
+  );
+}
+
+
+/**
+LQ decomposition T = L Q which decomposes the quantum number blocks of the
+matrix representation of the tensor in parallel. Q has orthonormal rows and is
+right canonical.
+
+@param pt To-be decomposed tensor.
+@param ldims Number of indexes combined as the row.
+@param lqndiv Quantum number divergence of L.
+@param pl Output L tensor, the first ldims indexes of T and the new bond.
+@param pq Output Q tensor, the new bond and the other indexes of T.
+@param thread_num Number of threads used to decompose the blocks.
+*/
+template <typename TenElemT, typename QNT>
+void LQ(
+    const GQTensor<TenElemT, QNT> *pt,
+    const size_t ldims,
+    const QNT &lqndiv,
+    GQTensor<TenElemT, QNT> *pl,
+    GQTensor<TenElemT, QNT> *pq,
+    const size_t thread_num = 1
+) {
+  BlockFactorize_<TenElemT, QNT>(
+      pt, ldims, lqndiv, BlockLQ<TenElemT, QNT>, pl, pq, thread_num
+  );
+}
+
+
+// Initial rank budgets of the blocks. A block never contributes more than
+// max(Dmax, Dmin) states; the budget of each block is this cap weighted by the
+// share of the block in the squared norm of the tensor.
+template <typename TenElemT, typename QNT>
+std::vector<size_t> InitRankBudgets_(
+    const std::vector<QNBlockMat<TenElemT, QNT>> &blocks,
+    const size_t cap
+) {
+  std::vector<double> weights(blocks.size());
+  double total_weight = 0.0;
+  for (size_t b = 0; b < blocks.size(); ++b) {
+    weights[b] = SquaredNorm_(blocks[b].data);
+    total_weight += weights[b];
+  }
+  std::vector<size_t> ranks(blocks.size());
+  for (size_t b = 0; b < blocks.size(); ++b) {
+    auto full_rank = std::min(blocks[b].rows.size(), blocks[b].cols.size());
+    auto rank = (total_weight > 0.0) ?
+                static_cast<size_t>(std::ceil(cap * weights[b] / total_weight)) :
+                size_t(1);
+    ranks[b] = std::min(std::max(rank, size_t(1)), std::min(full_rank, cap));
+  }
+  return ranks;
+}
+
+
+/**
+Decompose the quantum number blocks in parallel and determine how many
+singular triplets of each block are kept. The arguments and the truncation
+semantics are the same as the SVD of GraceQ/tensor.
+
+The RANDOMIZED_SVD and DENSITY_MATRIX_EIG backends only compute a rank budget
+of leading singular triplets per block, initialized from the share of the
+block in the squared norm of the tensor. A block whose computed triplets are
+all kept by the global merge may hide kept states, so its budget is doubled
+and the block is decomposed again until the merge settles. The result then
+keeps the same states as the full SVD; the weight which is not captured is
+counted into the actual truncation error.
+
+@param blocks The quantum number blocks.
+@param decomp_type Backend of the decomposition of each block.
+@param thread_num Number of threads used to decompose the blocks.
+
+@return Number of kept singular triplets of each block.
+*/
+template <typename TenElemT, typename QNT>
+std::vector<size_t> TruncatedDecompQNBlocks(
+    std::vector<QNBlockMat<TenElemT, QNT>> &blocks,
+    const GQTEN_Double trunc_err,
+    const size_t Dmin,
+    const size_t Dmax,
+    std::vector<DenseSVDRes<TenElemT>> &block_svd_res,
+    GQTEN_Double *pactual_trunc_err,
+    size_t *pD,
+    const TruncDecompType decomp_type,
+    const size_t thread_num
+) {
+  block_svd_res.resize(blocks.size());
+  auto cap = std::max(Dmax, Dmin);
+  auto ranks = InitRankBudgets_(blocks, cap);
+  std::vector<size_t> jobs(blocks.size());
+  for (size_t b = 0; b < blocks.size(); ++b) { jobs[b] = b; }
+  std::vector<size_t> kept_dims;
+  while (!jobs.empty()) {
+    // Decompose the largest blocks first for a better load balance.
+    std::sort(
+        jobs.begin(), jobs.end(),
+        [&blocks](const size_t a, const size_t b) {
+          return blocks[a].data.size() > blocks[b].data.size();
+        }
+    );
+    ParallelFor(
+        jobs.size(), thread_num,
+        [&blocks, &block_svd_res, &jobs, &ranks, decomp_type](const size_t i) {
+          auto b = jobs[i];
+          switch (decomp_type) {
+            case FULL_SVD:
+              block_svd_res[b] = BlockSVD(blocks[b]);
+              break;
+            case RANDOMIZED_SVD:
+              block_svd_res[b] = BlockRandomizedSVD(blocks[b], ranks[b], b);
+              break;
+            case DENSITY_MATRIX_EIG:
+              block_svd_res[b] = BlockDensityMatrixEig(blocks[b], ranks[b]);
+              break;
+            default:
+              assert(false);
+          }
+        }
+    );
+
+    std::vector<std::vector<double>> svs;
+    svs.reserve(blocks.size());
+    double residual_weight = 0.0;
+    for (auto &res : block_svd_res) {
+      svs.push_back(res.s);
+      residual_weight += res.residual_weight;
+    }
+    kept_dims = MergeTruncateSingularValues(
+                    svs, residual_weight,
+                    trunc_err, Dmin, Dmax,
+                    pactual_trunc_err, pD
+                );
+
+    // Grow the budgets of the saturated blocks.
+    jobs.clear();
+    for (size_t b = 0; b < blocks.size(); ++b) {
+      auto computed = block_svd_res[b].s.size();
+      auto max_rank = std::min(
+                          std::min(blocks[b].rows.size(), blocks[b].cols.size()),
+                          cap
+                      );
+      if (kept_dims[b] == computed && computed < max_rank) {
+        ranks[b] = std::min(std::max(2 * computed, size_t(1)), max_rank);
+        jobs.push_back(b);
+      }
+    }
+  }
+  return kept_dims;
+}
+
+
+/**
+Truncated decomposition T = U S Vt which decomposes the quantum number blocks
+of the matrix representation of the tensor in parallel. The arguments and the
+truncation semantics are the same as the SVD of GraceQ/tensor. See
+TruncatedDecompQNBlocks for the rank budgets of the RANDOMIZED_SVD and
+DENSITY_MATRIX_EIG backends.
+
+@param decomp_type Backend of the decomposition of each block.
+@param thread_num Number of threads used to decompose the blocks.
+*/
+template <typename TenElemT, typename QNT>
+void TruncatedDecomp(
+    const GQTensor<TenElemT, QNT> *pt,
+    const size_t ldims,
+    const QNT &lqndiv,
+    const GQTEN_Double trunc_err,
+    const size_t Dmin,
+    const size_t Dmax,
+    GQTensor<TenElemT, QNT> *pu,
+    GQTensor<GQTEN_Double, QNT> *ps,
+    GQTensor<TenElemT, QNT> *pvt,
+    GQTEN_Double *pactual_trunc_err,
+    size_t *pD,
+    const TruncDecompType decomp_type,
+    const size_t thread_num
+) {
+  std::vector<size_t> lshape, rshape;
+  auto blocks = ExtractQNBlockMats(*pt, ldims, lshape, rshape);
+  std::vector<DenseSVDRes<TenElemT>> block_svd_res;
+  auto kept_dims = TruncatedDecompQNBlocks(
+                       blocks, trunc_err, Dmin, Dmax,
+                       block_svd_res, pactual_trunc_err, pD,
+                       decomp_type, thread_num
+                   );
+  AssembleBlockSVDRes(
+      *pt, ldims, lqndiv,
+      blocks, block_svd_res, kept_dims, lshape, rshape,
+      pu, ps, pvt
+  );
+}
+
+
+/**
+Truncated singular value decomposition which decomposes the quantum number
+blocks of the matrix representation of the tensor in parallel. The arguments
+and the truncation semantics are the same as the SVD of GraceQ/tensor.
+
+@param thread_num Number of threads used to decompose the blocks.
+*/
+template <typename TenElemT, typename QNT>
+void SVD(
+    const GQTensor<TenElemT, QNT> *pt,
+    const size_t ldims,
+    const QNT &lqndiv,
+    const GQTEN_Double trunc_err,
+    const size_t Dmin,
+    const size_t Dmax,
+    GQTensor<TenElemT, QNT> *pu,
+    GQTensor<GQTEN_Double, QNT> *ps,
+    GQTensor<TenElemT, QNT> *pvt,
+    GQTEN_Double *pactual_trunc_err,
+    size_t *pD,
+    const size_t thread_num
+) {
+  TruncatedDecomp(
+      pt, ldims, lqndiv, trunc_err, Dmin, Dmax,
+      pu, ps, pvt, pactual_trunc_err, pD,
+      FULL_SVD, thread_num
+  );
+}
+} /* mock_gqten */
+} /* gqmps2 */
+#endif /* ifndef GQMPS2_MOCK_GQTEN_TEN_DECOMP_H */
@@ -16,6 +16,9 @@
 
 
 #include "gqmps2/one_dim_tn/framework/ten_vec.h"    // TenVec
+#include "gqmps2/consts.h"                          // kMpoTenBaseName
+
+#include <string>     // string, to_string
 
 
 namespace gqmps2 {
@@ -23,5 +26,12 @@ using namespace gqten;
 
 template <typename LocalTenT>
 using MPO = TenVec<LocalTenT>;
+
+
+// Helpers
+inline std::string GenMPOTenName(const std::string &mpo_path, const size_t idx) {
+  return mpo_path + "/" +
+         kMpoTenBaseName + std::to_string(idx) + "." + kGQTenFileSuffix;
+}
 } /* gqmps2 */
 #endif /* ifndef GQMPS2_ONE_DIM_TN_MPO_MPO_H */
@@ -0,0 +1,191 @@
+// SPDX-License-Identifier: LGPL-3.0-only
+
+/*
+* Author: Rongyang Sun <sun-rongyang@outlook.com>
+* Creation Date: 2020-10-29 09:47
+*
+* Description: GraceQ/MPS2 project. Bond dimension, sparsity and cost analysis
+*              of the matrix product operator.
+*/
+
+/**
+@file mpo_analysis.h
+@brief Bond dimension, sparsity and cost analysis of the matrix product operator.
+*/
+#ifndef GQMPS2_ONE_DIM_TN_MPO_MPO_ANALYSIS_H
+#define GQMPS2_ONE_DIM_TN_MPO_MPO_ANALYSIS_H
+
+
+#include "gqmps2/one_dim_tn/mpo/mpo.h"                  // MPO
+#include "gqmps2/mock_gqten/ten_decomp.h"               // mock_gqten::ExtractQNBlockMats
+#include "gqten/gqten.h"
+
+#include <iostream>     // cout, endl
+#include <iomanip>      // setw, setprecision
+#include <vector>       // vector
+#include <algorithm>    // min
+#include <assert.h>     // assert
+
+
+namespace gqmps2 {
+using namespace gqten;
+
+
+/// Analysis of the MPO tensor on a site.
+struct MPOSiteReport {
+  size_t lvb_dim;                       ///< Left virtual bond dimension.
+  size_t rvb_dim;                       ///< Right virtual bond dimension.
+  size_t phys_dim;                      ///< Physical dimension.
+  std::vector<size_t> rvb_qnsct_dims;   ///< Dimensions of the quantum number sectors of the right virtual bond.
+  size_t elem_num;                      ///< Number of all the elements.
+  size_t qnblk_elem_num;                ///< Number of the elements in the quantum number blocks.
+  size_t nonzero_elem_num;              ///< Number of the nonzero elements.
+  GQTEN_Double matvec_flops;            ///< Estimated FLOPs of applying the two-site effective Hamiltonian on this site and the next one, 0 on the last site.
+
+  /// Fraction of the elements allowed by the quantum number conservation.
+  GQTEN_Double BlkDensity(void) const {
+    return GQTEN_Double(qnblk_elem_num) / elem_num;
+  }
+
+  /// Fraction of the nonzero elements.
+  GQTEN_Double ElemDensity(void) const {
+    return GQTEN_Double(nonzero_elem_num) / elem_num;
+  }
+};
+
+using MPOReport = std::vector<MPOSiteReport>;
+
+
+/**
+Analyze a MPO before the simulation. For each site, the virtual bond dimensions,
+the quantum number sectors of the right virtual bond, the block and element
+densities and the estimated cost of the matrix-vector multiplication of the
+two-site effective Hamiltonian used by the two-site update vMPS are reported.
+
+The cost model follows the contraction order of eff_ham_mul_state_cent: the
+left environment, the MPO tensors of the two sites and the right environment
+are contracted with the two-site state in turn,
+\f$2 [D_l^2 D_r d_1 d_2 w_l + D_l D_r d_1^2 d_2 w_l w_m \rho_1
++ D_l D_r d_1 d_2^2 w_m w_r \rho_2 + D_l D_r^2 d_1 d_2 w_r]\f$, where
+\f$w_l\f$, \f$w_m\f$ and \f$w_r\f$ are the MPO bond dimensions and
+\f$\rho_1\f$, \f$\rho_2\f$ are the block densities of the MPO tensors, i.e.
+\f$O(D^2 d^2 w (D + d w))\f$. The MPS bond dimensions are D capped by the
+dimension of the Hilbert space on each side of the bond. The quantum number
+blocks of the MPS are ignored, so the cost is an upper bound.
+
+@param mpo The MPO, e.g. generated by MPOGenerator.
+@param D The bond dimension of the MPS.
+
+@return The report of each site.
+*/
+template <typename TenElemT, typename QNT>
+MPOReport AnalyzeMPO(
+    const MPO<GQTensor<TenElemT, QNT>> &mpo,
+    const size_t D
+) {
+  auto N = mpo.size();
+  assert(N >= 2);
+  MPOReport report(N);
+
+  // MPS bond dimensions, bond i is on the left of the site i.
+  std::vector<GQTEN_Double> phys_dims(N);
+  for (size_t i = 0; i < N; ++i) {
+    auto pb_axe = (i == 0 || i == N - 1) ? 0 : 1;
+    phys_dims[i] = mpo[i].GetIndexes()[pb_axe].dim();
+  }
+  std::vector<GQTEN_Double> left_dims(N + 1, 1), right_dims(N + 1, 1);
+  for (size_t i = 0; i < N; ++i) {
+    left_dims[i+1] = std::min(GQTEN_Double(D), left_dims[i] * phys_dims[i]);
+  }
+  for (size_t i = N; i > 0; --i) {
+    right_dims[i-1] = std::min(GQTEN_Double(D), right_dims[i] * phys_dims[i-1]);
+  }
+
+  for (size_t i = 0; i < N; ++i) {
+    auto &site_report = report[i];
+    const auto &indexes = mpo[i].GetIndexes();
+    if (i == 0) {
+      site_report.lvb_dim = 1;
+      site_report.rvb_dim = indexes[1].dim();
+    } else if (i == N - 1) {
+      site_report.lvb_dim = indexes[1].dim();
+      site_report.rvb_dim = 1;
+    } else {
+      site_report.lvb_dim = indexes[0].dim();
+      site_report.rvb_dim = indexes[3].dim();
+    }
+    site_report.phys_dim = phys_dims[i];
+    if (i != N - 1) {
+      auto &rvb = (i == 0) ? indexes[1] : indexes[3];
+      for (size_t j = 0; j < rvb.GetQNSctNum(); ++j) {
+        site_report.rvb_qnsct_dims.push_back(rvb.GetQNSct(j).dim());
+      }
+    }
+
+    site_report.elem_num = 1;
+    for (auto &index : indexes) { site_report.elem_num *= index.dim(); }
+    site_report.qnblk_elem_num = 0;
+    site_report.nonzero_elem_num = 0;
+    std::vector<size_t> lshape, rshape;
+    auto blocks = mock_gqten::ExtractQNBlockMats(mpo[i], 1, lshape, rshape);
+    for (auto &block : blocks) {
+      site_report.qnblk_elem_num += block.data.size();
+      for (auto elem : block.data) {
+        if (elem != TenElemT(0)) { site_report.nonzero_elem_num++; }
+      }
+    }
+
+  }
+
+  for (size_t i = 0; i < N; ++i) {
+    if (i == N - 1) {
+      report[i].matvec_flops = 0;
+      continue;
+    }
+    auto &site_report1 = report[i];
+    auto &site_report2 = report[i+1];
+    GQTEN_Double dl = left_dims[i], dr = right_dims[i+2];
+    GQTEN_Double d1 = site_report1.phys_dim, d2 = site_report2.phys_dim;
+    GQTEN_Double wl = site_report1.lvb_dim;
+    GQTEN_Double wm = site_report1.rvb_dim;
+    GQTEN_Double wr = site_report2.rvb_dim;
+    site_report1.matvec_flops = 2 * (
+        dl * dl * dr * d1 * d2 * wl +
+        dl * dr * d1 * d1 * d2 * wl * wm * site_report1.BlkDensity() +
+        dl * dr * d1 * d2 * d2 * wm * wr * site_report2.BlkDensity() +
+        dl * dr * dr * d1 * d2 * wr
+    );
+  }
+  return report;
+}
+
+
+/// Print the MPO report as a table.
+inline void PrintMPOReport(const MPOReport &report) {
+  std::cout << std::setw(6) << "site"
+            << std::setw(6) << "lvb"
+            << std::setw(6) << "rvb"
+            << std::setw(6) << "d"
+            << std::setw(8) << "#QNSct"
+            << std::setw(12) << "BlkDensity"
+            << std::setw(12) << "ElemDensity"
+            << std::setw(12) << "MatVecFLOPs" << std::endl;
+  GQTEN_Double total_flops = 0;
+  for (size_t i = 0; i < report.size(); ++i) {
+    auto &site_report = report[i];
+    std::cout << std::setw(6) << i
+              << std::setw(6) << site_report.lvb_dim
+              << std::setw(6) << site_report.rvb_dim
+              << std::setw(6) << site_report.phys_dim
+              << std::setw(8) << site_report.rvb_qnsct_dims.size()
+              << std::fixed << std::setprecision(4)
+              << std::setw(12) << site_report.BlkDensity()
+              << std::setw(12) << site_report.ElemDensity()
+              << std::scientific << std::setprecision(2)
+              << std::setw(12) << site_report.matvec_flops << std::endl;
+    total_flops += site_report.matvec_flops;
+  }
+  std::cout << "Total two-site MatVec FLOPs of all the bonds = " << total_flops << std::endl;
+}
+} /* gqmps2 */
+#endif /* ifndef GQMPS2_ONE_DIM_TN_MPO_MPO_ANALYSIS_H */
@@ -0,0 +1,131 @@
+// SPDX-License-Identifier: LGPL-3.0-only
+
+/*
+* Author: Rongyang Sun <sun-rongyang@outlook.com>
+* Creation Date: 2020-10-27 15:21
+*
+* Description: GraceQ/MPS2 project. Numerical compression of the matrix product
+*              operator.
+*/
+
+/**
+@file mpo_compress.h
+@brief Numerical compression of the matrix product operator.
+*/
+#ifndef GQMPS2_ONE_DIM_TN_MPO_MPO_COMPRESS_H
+#define GQMPS2_ONE_DIM_TN_MPO_MPO_COMPRESS_H
+
+
+#include "gqmps2/one_dim_tn/mpo/mpo.h"                  // MPO
+#include "gqmps2/mock_gqten/ten_decomp.h"               // mock_gqten::QR
+#include "gqten/gqten.h"
+
+#include <iostream>     // cout, endl
+#include <iomanip>      // setw, setprecision
+#include <vector>       // vector
+#include <cmath>        // log, exp
+#include <assert.h>     // assert
+
+
+namespace gqmps2 {
+using namespace gqten;
+
+
+/**
+Compress a MPO numerically. The MPO is first made left canonical by QR
+decompositions from the left end to the right end, then the virtual bonds are
+truncated by quantum number preserving SVDs from the right end to the left end.
+The singular values of each step are the Schmidt values of the operator on the
+bond, so the truncation is optimal in the Frobenius norm. It is an optional
+stage after MPOGenerator::Gen, which only removes the exact symbolic linear
+dependencies; the MPO with fitted or exponentially decaying couplings can be
+compressed much further.
+
+@param mpo The MPO generated by MPOGenerator, it is compressed in place.
+@param trunc_err The target truncation error of each bond.
+@param Dmin The minimal bond dimension.
+@param Dmax The maximal bond dimension.
+
+@return The discarded weight, the sum of the truncation errors of all the bonds.
+
+@note The Frobenius norm of a MPO grows exponentially with the number of sites,
+      e.g. \f$2^{N/2}\f$ of the identity on spin-1/2 sites, and overflows when it
+      is piled up in one tensor. So the R of each QR decomposition is normalized
+      and the logarithm of its norm is accumulated; the compressed MPO is scaled
+      back by spreading the norm evenly over the sites. The norm of the MPO is
+      kept.
+*/
+template <typename TenElemT, typename QNT>
+GQTEN_Double CompressMPO(
+    MPO<GQTensor<TenElemT, QNT>> &mpo,
+    const GQTEN_Double trunc_err,
+    const size_t Dmin,
+    const size_t Dmax
+) {
+  using LocalTenT = GQTensor<TenElemT, QNT>;
+  auto N = mpo.size();
+  assert(N >= 2);
+
+  // Uniform legs order (lvb, pb_in, pb_out, rvb), the head tensor has no lvb and
+  // the tail tensor has no rvb.
+  mpo[0].Transpose({0, 2, 1});
+  mpo[N-1].Transpose({1, 0, 2});
+
+  GQTEN_Double log_norm = 0;
+  for (size_t i = 0; i < N - 1; ++i) {
+    size_t ldims = (i == 0) ? 2 : 3;
+    auto pq = new LocalTenT;
+    LocalTenT r;
+    mock_gqten::QR(mpo(i), ldims, Div(mpo[i]), pq, &r);
+    auto r_norm = r.Get2Norm();
+    assert(r_norm > 0);
+    r *= TenElemT(1.0 / r_norm);
+    log_norm += std::log(r_norm);
+    delete mpo(i);
+    mpo(i) = pq;
+
+    auto pnext_ten = new LocalTenT;
+    Contract(&r, mpo(i + 1), {{1}, {0}}, pnext_ten);
+    delete mpo(i + 1);
+    mpo(i + 1) = pnext_ten;
+  }
+
+  GQTEN_Double discarded_weight = 0;
+  GQTEN_Double actual_trunc_err;
+  size_t D;
+  for (size_t i = N - 1; i > 0; --i) {
+    auto qndiv = Div(mpo[i]);
+    LocalTenT u;
+    GQTensor<GQTEN_Double, QNT> s;
+    auto pvt = new LocalTenT;
+    SVD(
+        mpo(i),
+        1, qndiv - qndiv, trunc_err, Dmin, Dmax,
+        &u, &s, pvt, &actual_trunc_err, &D
+    );
+    std::cout << "Compress MPO bond " << std::setw(4) << i - 1
+              << " TruncErr = " << std::setprecision(2) << std::scientific << actual_trunc_err << std::fixed
+              << " D = " << std::setw(5) << D;
+    std::cout << std::scientific << std::endl;
+    discarded_weight += actual_trunc_err;
+    delete mpo(i);
+    mpo(i) = pvt;
+
+    LocalTenT temp_ten;
+    Contract(&u, &s, {{1}, {0}}, &temp_ten);
+    auto pprev_ten = new LocalTenT;
+    size_t prev_rvb_axe = (i - 1 == 0) ? 2 : 3;
+    Contract(mpo(i - 1), &temp_ten, {{prev_rvb_axe}, {0}}, pprev_ten);
+    delete mpo(i - 1);
+    mpo(i - 1) = pprev_ten;
+  }
+
+  mpo[0].Transpose({0, 2, 1});
+  mpo[N-1].Transpose({1, 0, 2});
+
+  auto site_scale = TenElemT(std::exp(log_norm / N));
+  for (size_t i = 0; i < N; ++i) { mpo[i] *= site_scale; }
+  return discarded_weight;
+}
+} /* gqmps2 */
+#endif /* ifndef GQMPS2_ONE_DIM_TN_MPO_MPO_COMPRESS_H */
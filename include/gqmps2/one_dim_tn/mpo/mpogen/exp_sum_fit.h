@@ -0,0 +1,188 @@
+// SPDX-License-Identifier: LGPL-3.0-only
+/*
+* Author: Rongyang Sun <sun-rongyang@outlook.com>
+* Creation Date: 2020-10-28 10:12
+*
+* Description: GraceQ/MPS2 project. Fit a long-range coupling to a sum of
+*              exponentials.
+*/
+
+/**
+@file exp_sum_fit.h
+@brief Fit a long-range coupling to a sum of exponentials.
+*/
+#ifndef GQMPS2_ONE_DIM_TN_MPO_MPOGEN_EXP_SUM_FIT_H
+#define GQMPS2_ONE_DIM_TN_MPO_MPOGEN_EXP_SUM_FIT_H
+
+
+#include "gqmps2/mock_gqten/ten_decomp.h"    // DenseSVD_, Conj_
+#include "gqten/gqten.h"                     // GQTEN_Double
+
+#include <vector>       // vector
+#include <algorithm>    // min, max
+#include <cmath>        // sqrt, abs
+#include <iostream>     // cout, endl
+#include <cstdlib>      // exit
+#include <assert.h>     // assert
+
+
+namespace gqmps2 {
+using namespace gqten;
+
+
+/**
+A coupling \f$V(r) \approx c^{T} M^{r-1} b\f$ fitted by K exponentials. The
+eigenvalues of the transfer matrix \f$M\f$ are the decay factors, they are not
+diagonalized so that a real coupling is fitted in real arithmetic even if the
+decay factors are complex.
+
+@tparam TenElemT Type of the coupling, real or complex.
+*/
+template <typename TenElemT>
+struct ExpSumFitRes {
+  size_t K;                   ///< Number of the exponentials.
+  std::vector<TenElemT> b;    ///< Input weights, (K).
+  std::vector<TenElemT> m;    ///< Row major transfer matrix, (K, K).
+  std::vector<TenElemT> c;    ///< Output weights, (K).
+  GQTEN_Double max_err;       ///< Maximal absolute error on the fitted distances.
+
+  /// Evaluate the fitted coupling of all the distances from 1 to L.
+  std::vector<TenElemT> Eval(const size_t L) const {
+    std::vector<TenElemT> vals(L, TenElemT(0));
+    std::vector<TenElemT> vec = b, next_vec(K);
+    for (size_t r = 1; r <= L; ++r) {
+      for (size_t a = 0; a < K; ++a) { vals[r-1] += c[a] * vec[a]; }
+      for (size_t a = 0; a < K; ++a) {
+        next_vec[a] = 0;
+        for (size_t bb = 0; bb < K; ++bb) { next_vec[a] += m[a*K + bb] * vec[bb]; }
+      }
+      vec.swap(next_vec);
+    }
+    return vals;
+  }
+};
+
+
+/**
+Fit the coupling \f$V(1), V(2), \cdots, V(L)\f$ to a sum of exponentials. The
+Hankel matrix \f$H_{pq} = V(p + q + 1)\f$ is decomposed by SVD and truncated to
+the K largest singular values, the realization
+\f$H = O C\f$, \f$O = U S^{1/2}\f$, \f$C = S^{1/2} V^{\dagger}\f$ gives the
+output weights from the first row of \f$O\f$, the input weights from the first
+column of \f$C\f$ and the transfer matrix from the least square solution of the
+shift invariance of \f$O\f$.
+
+@param vals The couplings on the distances from 1 to L.
+@param tol The singular values smaller than tol times the largest one are
+       dropped.
+@param max_K The maximal number of the exponentials.
+
+@note A warning is printed if the fit misses the tolerance, e.g. a power law
+      coupling with a too small max_K.
+*/
+template <typename TenElemT>
+ExpSumFitRes<TenElemT> FitExpSum(
+    const std::vector<TenElemT> &vals,
+    const GQTEN_Double tol,
+    const size_t max_K
+) {
+  auto L = vals.size();
+  assert(L > 0);
+  assert(max_K > 0);
+  ExpSumFitRes<TenElemT> res;
+  res.K = 0;
+  res.max_err = 0;
+
+  // Hankel matrix, (P, Q) with P + Q - 1 = L.
+  size_t P = L / 2 + 1;
+  size_t Q = L + 1 - P;
+  size_t k = std::min(P, Q);
+  std::vector<TenElemT> h(P * Q), u(P * k), vt(k * Q);
+  std::vector<GQTEN_Double> s(k);
+  for (size_t p = 0; p < P; ++p) {
+    for (size_t q = 0; q < Q; ++q) { h[p*Q + q] = vals[p + q]; }
+  }
+  auto info = mock_gqten::DenseSVD_(P, Q, h.data(), s.data(), u.data(), vt.data());
+  if (info != 0) {
+    std::cout << "Exponential sum fitting failed with info = " << info << std::endl;
+    exit(1);
+  }
+  if (s[0] == 0) { return res; }    // Zero coupling.
+  // At most P - 1 exponentials, so that the shift invariance is determined.
+  auto K_bound = std::min(k, max_K);
+  if (P > 1) { K_bound = std::min(K_bound, P - 1); }
+  size_t K = 0;
+  while (K < K_bound && s[K] > tol * s[0]) { K++; }
+  res.K = K;
+
+  // O = U S^{1/2}, (P, K).
+  std::vector<TenElemT> o(P * K);
+  for (size_t p = 0; p < P; ++p) {
+    for (size_t a = 0; a < K; ++a) { o[p*K + a] = u[p*k + a] * std::sqrt(s[a]); }
+  }
+  res.c.assign(o.begin(), o.begin() + K);
+  res.b.resize(K);
+  for (size_t a = 0; a < K; ++a) { res.b[a] = std::sqrt(s[a]) * vt[a*Q]; }
+
+  // Least square solution of O[0:P-1] M = O[1:P] through the pseudo inverse.
+  res.m.assign(K * K, TenElemT(0));
+  size_t R = P - 1;
+  if (R > 0) {
+    size_t k2 = std::min(R, K);
+    std::vector<TenElemT> o_up(o.begin(), o.begin() + R * K), u2(R * k2), vt2(k2 * K);
+    std::vector<GQTEN_Double> s2(k2);
+    info = mock_gqten::DenseSVD_(R, K, o_up.data(), s2.data(), u2.data(), vt2.data());
+    if (info != 0) {
+      std::cout << "Exponential sum fitting failed with info = " << info << std::endl;
+      exit(1);
+    }
+    // M = Vt2^dag S2^-1 U2^dag O[1:P].
+    std::vector<TenElemT> w(k2 * K, TenElemT(0));   // S2^-1 U2^dag O[1:P]
+    for (size_t l = 0; l < k2; ++l) {
+      if (s2[l] <= tol * s2[0]) { continue; }
+      for (size_t a = 0; a < K; ++a) {
+        for (size_t p = 0; p < R; ++p) {
+          w[l*K + a] += mock_gqten::Conj_(u2[p*k2 + l]) * o[(p+1)*K + a];
+        }
+        w[l*K + a] /= s2[l];
+      }
+    }
+    for (size_t a = 0; a < K; ++a) {
+      for (size_t bb = 0; bb < K; ++bb) {
+        for (size_t l = 0; l < k2; ++l) {
+          res.m[a*K + bb] += mock_gqten::Conj_(vt2[l*K + a]) * w[l*K + bb];
+        }
+      }
+    }
+  }
+
+  // The realization gives V(r) = c M^{r-1} b with c as a row vector, which is
+  // c^T M^{r-1} b, see ExpSumFitRes.
+  auto fitted_vals = res.Eval(L);
+  GQTEN_Double max_val = 0;
+  for (size_t r = 0; r < L; ++r) {
+    res.max_err = std::max(res.max_err, GQTEN_Double(std::abs(fitted_vals[r] - vals[r])));
+    max_val = std::max(max_val, GQTEN_Double(std::abs(vals[r])));
+  }
+
+  // The coupling can not be compressed, use the exact shift register
+  // realization with L states if it is allowed.
+  if (res.max_err > tol * max_val && L <= max_K) {
+    res.K = L;
+    res.b.assign(L, TenElemT(0));
+    res.b[0] = 1;
+    res.m.assign(L * L, TenElemT(0));
+    for (size_t a = 0; a + 1 < L; ++a) { res.m[(a+1)*L + a] = 1; }
+    res.c = vals;
+    res.max_err = 0;
+  }
+  if (res.max_err > tol * max_val) {
+    std::cout << "FitExpSum: warning, the maximal error " << res.max_err
+              << " of the fitted coupling exceeds the tolerance "
+              << tol * max_val << " with K = " << res.K
+              << " (max_K = " << max_K << ")." << std::endl;
+  }
+  return res;
+}
+} /* gqmps2 */
+#endif /* ifndef GQMPS2_ONE_DIM_TN_MPO_MPOGEN_EXP_SUM_FIT_H */
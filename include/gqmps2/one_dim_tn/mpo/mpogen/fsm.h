@@ -12,6 +12,11 @@
 #include "gqmps2/one_dim_tn/mpo/mpogen/symb_alg/coef_op_alg.h"
 
 #include <vector>
+#include <complex>          // complex
+#include <functional>       // hash
+#include <unordered_map>    // unordered_multimap
+#include <algorithm>        // max, min
+#include <utility>          // move
 
 #include <assert.h>
 
@@ -51,6 +56,31 @@ struct FSMPath {
 using FSMPathVec = std::vector<FSMPath>;
 
 
+// A path stored only on its nontrivial span. The identity operators before the
+// head and behind the tail are implied by the ready and final states, so the
+// memory scales with the number of the nontrivial operators.
+struct FSMCompactPath {
+  size_t head_site_idx;
+  OpReprVec ntrvl_ops;                ///< Operators from the head to the tail.
+  std::vector<long> mid_stat_idxs;    ///< Middle states on the FSM sites from head+1 to tail.
+};
+
+using FSMCompactPathVec = std::vector<FSMCompactPath>;
+
+
+// A transition between two states of neighbouring FSM sites on a physical site.
+// The transitions share their middle states, so a long-range term with O(N^2)
+// paths can be described by O(N) transitions.
+struct FSMEdge {
+  size_t phys_site_idx;
+  long row_stat_idx;
+  long col_stat_idx;
+  OpRepr op_repr;
+};
+
+using FSMEdgeVec = std::vector<FSMEdge>;
+
+
 class FSM {
 public:
   FSM(const size_t phys_site_num) :
@@ -59,6 +89,8 @@ public:
       mid_stat_nums_(phys_site_num+1, 0),
       has_readys_(phys_site_num+1, false),
       has_finals_(phys_site_num+1, false),
+      ready_chain_len_(0),
+      final_chain_begin_(phys_site_num),
       id_op_labels_(phys_site_num, kIdOpLabel) {
     assert(fsm_site_num_ == phys_site_num_ + 1); 
   }
@@ -71,7 +103,17 @@ public:
 
   void AddPath(const size_t, const size_t, const OpReprVec &);
 
-  FSMPathVec GetFSMPaths(void) const { return fsm_paths_; }
+  long AddMidStat(const size_t);
+
+  void AddEdge(const size_t, const long, const long, const OpRepr &);
+
+  FSMPathVec GetFSMPaths(void) const;
+
+  const FSMCompactPathVec &GetFSMCompactPaths(void) const {
+    return fsm_compact_paths_;
+  }
+
+  FSMEdgeVec GetFSMEdges(void) const { return fsm_edges_; }
 
   SparOpReprMatVec GenMatRepr(void) const;
 
@@ -86,16 +128,25 @@ private:
   std::vector<long> CalcFinalStatDimIdxs_(const std::vector<size_t> &) const;
 
   void CastFSMPathToMatRepr_(
-      const FSMPath &,
+      const FSMCompactPath &,
       const std::vector<long> &,
       SparOpReprMatVec &) const;
 
+  size_t CalcMatReprIdx_(
+      const size_t, const long, const std::vector<long> &) const;
+
+  void AddOpToMatRepr_(
+      SparOpReprMat &, const size_t, const size_t, const OpRepr &) const;
+
   size_t phys_site_num_;
   size_t fsm_site_num_;
   std::vector<size_t> mid_stat_nums_;
   std::vector<bool> has_readys_;
   std::vector<bool> has_finals_;
-  FSMPathVec fsm_paths_;
+  FSMCompactPathVec fsm_compact_paths_;
+  size_t ready_chain_len_;      ///< Ready to ready on the sites [0, ready_chain_len_).
+  size_t final_chain_begin_;    ///< Final to final on the sites [final_chain_begin_, N).
+  FSMEdgeVec fsm_edges_;
 
   std::vector<OpLabel> id_op_labels_;
 };
@@ -112,39 +163,79 @@ void FSM::AddPath(
   assert(
       head_ntrvl_site_idx + ntrvl_ops.size() +
       (phys_site_num_ - tail_ntrvl_site_idx - 1) == phys_site_num_);
-  FSMPath fsm_path(phys_site_num_, fsm_site_num_);
-  // Set operator representations.
-  for (size_t i = 0; i < phys_site_num_; ++i) {
-    if (i < head_ntrvl_site_idx) {
-      fsm_path.op_reprs[i] = OpRepr(id_op_labels_[i]);
-    } else if (i > tail_ntrvl_site_idx) {
-      fsm_path.op_reprs[i] = OpRepr(id_op_labels_[i]);
-    } else {
-      fsm_path.op_reprs[i] = ntrvl_ops[i-head_ntrvl_site_idx];
-    }
+  FSMCompactPath fsm_path;
+  fsm_path.head_site_idx = head_ntrvl_site_idx;
+  fsm_path.ntrvl_ops = ntrvl_ops;
+  // Ready states before the head and final states behind the tail.
+  for (size_t i = 0; i <= head_ntrvl_site_idx; ++i) { has_readys_[i] = true; }
+  for (size_t i = tail_ntrvl_site_idx + 1; i < fsm_site_num_; ++i) {
+    has_finals_[i] = true;
   }
-  // Set FSM nodes.
-  fsm_path.fsm_nodes[0].fsm_site_idx = 0;
-  fsm_path.fsm_nodes[0].fsm_stat_idx = kFSMReadyStatIdx;
-  has_readys_[0] = true;
-  for (size_t i = 0; i < phys_site_num_; ++i) {
-    size_t tgt_fsm_site_idx = i + 1;
-    if (i < head_ntrvl_site_idx) {
-      fsm_path.fsm_nodes[tgt_fsm_site_idx].fsm_site_idx = tgt_fsm_site_idx;
-      fsm_path.fsm_nodes[tgt_fsm_site_idx].fsm_stat_idx = kFSMReadyStatIdx;
-      has_readys_[tgt_fsm_site_idx] = true;
-    } else if (i >= tail_ntrvl_site_idx) {
-      fsm_path.fsm_nodes[tgt_fsm_site_idx].fsm_site_idx = tgt_fsm_site_idx;
-      fsm_path.fsm_nodes[tgt_fsm_site_idx].fsm_stat_idx = kFSMFinalStatIdx;
-      has_finals_[tgt_fsm_site_idx] = true;
-    } else {
-      fsm_path.fsm_nodes[tgt_fsm_site_idx].fsm_site_idx = tgt_fsm_site_idx;
-      mid_stat_nums_[tgt_fsm_site_idx]++;
-      fsm_path.fsm_nodes[tgt_fsm_site_idx].fsm_stat_idx = 
-          mid_stat_nums_[tgt_fsm_site_idx];
+  ready_chain_len_ = std::max(ready_chain_len_, head_ntrvl_site_idx);
+  final_chain_begin_ = std::min(final_chain_begin_, tail_ntrvl_site_idx + 1);
+  // Middle states inside the span.
+  for (size_t i = head_ntrvl_site_idx + 1; i <= tail_ntrvl_site_idx; ++i) {
+    mid_stat_nums_[i]++;
+    fsm_path.mid_stat_idxs.push_back(mid_stat_nums_[i]);
+  }
+  fsm_compact_paths_.push_back(std::move(fsm_path));
+}
+
+
+// Expand the compact paths to the paths on all the sites.
+FSMPathVec FSM::GetFSMPaths(void) const {
+  FSMPathVec fsm_paths;
+  for (auto &compact_path : fsm_compact_paths_) {
+    FSMPath fsm_path(phys_site_num_, fsm_site_num_);
+    auto head = compact_path.head_site_idx;
+    auto tail = head + compact_path.ntrvl_ops.size() - 1;
+    for (size_t i = 0; i < fsm_site_num_; ++i) {
+      fsm_path.fsm_nodes[i].fsm_site_idx = i;
+      if (i <= head) {
+        fsm_path.fsm_nodes[i].fsm_stat_idx = kFSMReadyStatIdx;
+      } else if (i > tail) {
+        fsm_path.fsm_nodes[i].fsm_stat_idx = kFSMFinalStatIdx;
+      } else {
+        fsm_path.fsm_nodes[i].fsm_stat_idx =
+            compact_path.mid_stat_idxs[i - head - 1];
+      }
     }
+    for (size_t i = 0; i < phys_site_num_; ++i) {
+      if (i < head || i > tail) {
+        fsm_path.op_reprs[i] = OpRepr(id_op_labels_[i]);
+      } else {
+        fsm_path.op_reprs[i] = compact_path.ntrvl_ops[i - head];
+      }
+    }
+    fsm_paths.push_back(fsm_path);
   }
-  fsm_paths_.push_back(fsm_path);
+  return fsm_paths;
+}
+
+
+// Add a new middle state on the FSM site and return its state index.
+long FSM::AddMidStat(const size_t fsm_site_idx) {
+  assert(fsm_site_idx < fsm_site_num_);
+  mid_stat_nums_[fsm_site_idx]++;
+  return mid_stat_nums_[fsm_site_idx];
+}
+
+
+// Add a transition from a state of the FSM site phys_site_idx to a state of the
+// FSM site phys_site_idx + 1. The states are ready, final or the middle states
+// given by AddMidStat.
+void FSM::AddEdge(
+    const size_t phys_site_idx,
+    const long row_stat_idx, const long col_stat_idx,
+    const OpRepr &op_repr) {
+  assert(phys_site_idx < phys_site_num_);
+  assert(row_stat_idx <= long(mid_stat_nums_[phys_site_idx]));
+  assert(col_stat_idx <= long(mid_stat_nums_[phys_site_idx+1]));
+  if (row_stat_idx == kFSMReadyStatIdx) { has_readys_[phys_site_idx] = true; }
+  if (row_stat_idx == kFSMFinalStatIdx) { has_finals_[phys_site_idx] = true; }
+  if (col_stat_idx == kFSMReadyStatIdx) { has_readys_[phys_site_idx+1] = true; }
+  if (col_stat_idx == kFSMFinalStatIdx) { has_finals_[phys_site_idx+1] = true; }
+  fsm_edges_.push_back({phys_site_idx, row_stat_idx, col_stat_idx, op_repr});
 }
 
 
@@ -157,9 +248,32 @@ SparOpReprMatVec FSM::GenMatRepr(void) const {
     auto mat_cols = fsm_site_dims[i+1];
     fsm_mat_repr.push_back(SparOpReprMat(mat_rows, mat_cols));
   }
-  for (auto &fsm_path : fsm_paths_) {
+  // The identity operators shared by all the paths.
+  for (size_t i = 0; i < ready_chain_len_; ++i) {
+    AddOpToMatRepr_(
+        fsm_mat_repr[i],
+        CalcMatReprIdx_(i, kFSMReadyStatIdx, final_stat_dim_idxs),
+        CalcMatReprIdx_(i+1, kFSMReadyStatIdx, final_stat_dim_idxs),
+        OpRepr(id_op_labels_[i]));
+  }
+  for (size_t i = final_chain_begin_; i < phys_site_num_; ++i) {
+    AddOpToMatRepr_(
+        fsm_mat_repr[i],
+        CalcMatReprIdx_(i, kFSMFinalStatIdx, final_stat_dim_idxs),
+        CalcMatReprIdx_(i+1, kFSMFinalStatIdx, final_stat_dim_idxs),
+        OpRepr(id_op_labels_[i]));
+  }
+  for (auto &fsm_path : fsm_compact_paths_) {
     CastFSMPathToMatRepr_(fsm_path, final_stat_dim_idxs, fsm_mat_repr);
   }
+  for (auto &fsm_edge : fsm_edges_) {
+    auto i = fsm_edge.phys_site_idx;
+    AddOpToMatRepr_(
+        fsm_mat_repr[i],
+        CalcMatReprIdx_(i, fsm_edge.row_stat_idx, final_stat_dim_idxs),
+        CalcMatReprIdx_(i+1, fsm_edge.col_stat_idx, final_stat_dim_idxs),
+        fsm_edge.op_repr);
+  }
   return fsm_mat_repr;
 }
 
@@ -192,39 +306,54 @@ std::vector<long> FSM::CalcFinalStatDimIdxs_(
 }
 
 
+// Cast the nontrivial span of a path, the identity operators outside the span
+// are cast once for all the paths.
 void FSM::CastFSMPathToMatRepr_(
-    const FSMPath &fsm_path,
+    const FSMCompactPath &fsm_path,
     const std::vector<long> &final_stat_dim_idxs,
     SparOpReprMatVec &fsm_mat_repr) const {
-  for (size_t i = 0; i < phys_site_num_; ++i) {
-    auto tgt_row_fsm_node = fsm_path.fsm_nodes[i];
-    auto tgt_col_fsm_node = fsm_path.fsm_nodes[i+1];
-    auto tgt_op = fsm_path.op_reprs[i];
-
-    size_t tgt_row_idx, tgt_col_idx;
-    if (tgt_row_fsm_node.fsm_stat_idx == kFSMFinalStatIdx) {
-      tgt_row_idx = final_stat_dim_idxs[i];
-    } else if ((!has_readys_[i]) && (!has_finals_[i])) {
-      tgt_row_idx = tgt_row_fsm_node.fsm_stat_idx - 1;
-    } else {
-      tgt_row_idx = tgt_row_fsm_node.fsm_stat_idx;
-    }
-    if (tgt_col_fsm_node.fsm_stat_idx == kFSMFinalStatIdx) {
-      tgt_col_idx = final_stat_dim_idxs[i+1];
-    } else if ((!has_readys_[i+1]) && (!has_finals_[i+1])) {
-      tgt_col_idx = tgt_col_fsm_node.fsm_stat_idx - 1;
-    } else {
-      tgt_col_idx = tgt_col_fsm_node.fsm_stat_idx;
-    }
+  auto head = fsm_path.head_site_idx;
+  auto span = fsm_path.ntrvl_ops.size();
+  for (size_t k = 0; k < span; ++k) {
+    auto i = head + k;
+    auto row_stat_idx = (k == 0) ?
+                        kFSMReadyStatIdx : fsm_path.mid_stat_idxs[k-1];
+    auto col_stat_idx = (k == span - 1) ?
+                        kFSMFinalStatIdx : fsm_path.mid_stat_idxs[k];
+    AddOpToMatRepr_(
+        fsm_mat_repr[i],
+        CalcMatReprIdx_(i, row_stat_idx, final_stat_dim_idxs),
+        CalcMatReprIdx_(i+1, col_stat_idx, final_stat_dim_idxs),
+        fsm_path.ntrvl_ops[k]);
+  }
+}
 
-    if (fsm_mat_repr[i](tgt_row_idx, tgt_col_idx) == kNullOpRepr) {
-      fsm_mat_repr[i].SetElem(tgt_row_idx, tgt_col_idx, tgt_op);
-    } else if (fsm_mat_repr[i](tgt_row_idx, tgt_col_idx) != tgt_op) {
-      auto new_op = fsm_mat_repr[i](tgt_row_idx, tgt_col_idx) + tgt_op;
-      fsm_mat_repr[i].SetElem(tgt_row_idx, tgt_col_idx, new_op);
-    } else {
-      // Do nothing
-    }
+
+size_t FSM::CalcMatReprIdx_(
+    const size_t fsm_site_idx, const long fsm_stat_idx,
+    const std::vector<long> &final_stat_dim_idxs) const {
+  if (fsm_stat_idx == kFSMFinalStatIdx) {
+    return final_stat_dim_idxs[fsm_site_idx];
+  } else if ((!has_readys_[fsm_site_idx]) && (!has_finals_[fsm_site_idx])) {
+    return fsm_stat_idx - 1;
+  } else {
+    return fsm_stat_idx;
+  }
+}
+
+
+void FSM::AddOpToMatRepr_(
+    SparOpReprMat &mat_repr,
+    const size_t tgt_row_idx, const size_t tgt_col_idx,
+    const OpRepr &tgt_op) const {
+  auto &op = mat_repr(tgt_row_idx, tgt_col_idx);
+  if (op == kNullOpRepr) {
+    mat_repr.SetElem(tgt_row_idx, tgt_col_idx, tgt_op);
+  } else if (op != tgt_op) {
+    auto new_op = op + tgt_op;
+    mat_repr.SetElem(tgt_row_idx, tgt_col_idx, new_op);
+  } else {
+    // Do nothing
   }
 }
 
@@ -247,35 +376,52 @@ void FSM::ReplaceIdOpLabels(std::vector<OpLabel> &new_id_op_labels) {
 }
 
 
+// Default content hash of the objects interned by LabelConvertor.
 template <typename ConvObjT>
+struct LabelConvObjHash {
+  size_t operator()(const ConvObjT &obj) const {
+    return std::hash<ConvObjT>()(obj);
+  }
+};
+
+
+template <typename T>
+struct LabelConvObjHash<std::complex<T>> {
+  size_t operator()(const std::complex<T> &z) const {
+    size_t seed = std::hash<T>()(z.real());
+    HashCombine(seed, std::hash<T>()(z.imag()));
+    return seed;
+  }
+};
+
+
+// Intern the objects as labels. The labels are bucketed by the content hash of
+// the objects, so a conversion costs O(1) equality checks on average. HashT
+// must give the same hash for the objects which are equal.
+template <typename ConvObjT, typename HashT = LabelConvObjHash<ConvObjT>>
 class LabelConvertor {
 public:
   LabelConvertor(void) = default;
 
-  LabelConvertor(const ConvObjT &id) : conv_obj_hub_({id}) {}
-
-  LabelConvertor<ConvObjT> &operator=(const LabelConvertor<ConvObjT> &rhs) {
-    conv_obj_hub_ = rhs.conv_obj_hub_;
-    return *this;
-  }
+  LabelConvertor(const ConvObjT &id) { Convert(id); }
 
   using ConvObjVec = std::vector<ConvObjT>;
 
   size_t Convert(const ConvObjT &conv_obj) {
-    auto poss_it = std::find(
-                       conv_obj_hub_.cbegin(), conv_obj_hub_.cend(), conv_obj);
-    if (poss_it == conv_obj_hub_.cend()) {
-      conv_obj_hub_.push_back(conv_obj);
-      size_t label = conv_obj_hub_.size() - 1;
-      return label;
-    } else {
-      size_t label = poss_it - conv_obj_hub_.cbegin();
-      return label;
+    auto hash = HashT()(conv_obj);
+    auto range = label_hash_map_.equal_range(hash);
+    for (auto it = range.first; it != range.second; ++it) {
+      if (conv_obj_hub_[it->second] == conv_obj) { return it->second; }
     }
+    conv_obj_hub_.push_back(conv_obj);
+    size_t label = conv_obj_hub_.size() - 1;
+    label_hash_map_.emplace(hash, label);
+    return label;
   }
 
-  ConvObjVec GetLabelObjMapping(void) { return conv_obj_hub_; }
+  ConvObjVec GetLabelObjMapping(void) const { return conv_obj_hub_; }
 private:
   ConvObjVec conv_obj_hub_;
+  std::unordered_multimap<size_t, size_t> label_hash_map_;   ///< Content hash to labels.
 };
 #endif /* ifndef GQMPS2_ONE_DIM_TN_MPO_MPOGEN_FSM */
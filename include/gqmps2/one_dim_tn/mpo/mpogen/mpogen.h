@@ -20,13 +20,115 @@
 #include "gqmps2/one_dim_tn/mpo/mpo.h"    // MPO
 #include "gqmps2/one_dim_tn/mpo/mpogen/fsm.h"
 #include "gqmps2/one_dim_tn/mpo/mpogen/symb_alg/coef_op_alg.h"
+#include "gqmps2/one_dim_tn/mpo/mpogen/exp_sum_fit.h"   // FitExpSum
+#include "gqmps2/mock_gqten/ten_decomp.h"               // mock_gqten::ParallelFor
+#include "gqmps2/utilities.h"                           // IsPathExist, CreatPath
 #include "gqten/gqten.h"
 
+#include <cmath>          // round
+#include <functional>     // hash, function
+#include <unordered_map>  // unordered_map
+#include <string>         // string
+#include <sstream>        // ostringstream
+#include <iomanip>        // hex, setw, setfill
+#include <cstdint>        // uint64_t
+
 
 namespace gqmps2 {
 using namespace gqten;
 
 
+/// Grid of the rounded tensor elements used by the content hash.
+const double kOpHashGrid = 1048576.0;
+
+/**
+Version of the MPO generated by MPOGenerator::Gen and of its tensor files. It is
+mixed into MPOGenerator::Fingerprint, so bump it when the generation algorithm or
+the file format changes and the MPOs cached by MPOGenerator::GenWithCache become
+stale.
+*/
+const uint64_t kMPOGenVersion = 1;
+
+
+/**
+Content hash of a local operator for the operator label convertor. The elements
+are rounded to a grid which is much coarser than the tolerance of the tensor
+comparison, so the operators which are equal get the same hash. An element
+lying on the rounding boundary only leads to an extra label.
+*/
+template <typename TenElemT, typename QNT>
+struct GQTensorContentHash {
+  size_t operator()(const GQTensor<TenElemT, QNT> &t) const {
+    size_t seed = 0;
+    if (t.IsDefault()) { return seed; }
+    auto shape = t.GetShape();
+    for (auto dim : shape) { HashCombine(seed, dim); }
+    for (auto &coors : GenAllCoors(shape)) {
+      HashElem_(seed, t.GetElem(coors));
+    }
+    return seed;
+  }
+
+private:
+  static void HashElem_(size_t &seed, const GQTEN_Double x) {
+    // Adding 0.0 turns -0.0 into 0.0.
+    HashCombine(seed, std::hash<double>()(std::round(x * kOpHashGrid) + 0.0));
+  }
+
+  static void HashElem_(size_t &seed, const GQTEN_Complex z) {
+    HashElem_(seed, z.real());
+    HashElem_(seed, z.imag());
+  }
+};
+
+
+/**
+64-bit FNV-1a hash of a byte stream. Unlike std::hash, the result is fixed by
+the bytes, so it can be used as a fingerprint between different runs.
+*/
+class FNV1aHasher {
+public:
+  FNV1aHasher(void) : hash_(kOffsetBasis_) {}
+
+  void Update(const void *data, const size_t size) {
+    auto bytes = static_cast<const unsigned char *>(data);
+    for (size_t i = 0; i < size; ++i) {
+      hash_ ^= bytes[i];
+      hash_ *= kPrime_;
+    }
+  }
+
+  void Update(const std::string &str) { Update(str.data(), str.size()); }
+
+  template <typename T>
+  void UpdateValue(const T &val) { Update(&val, sizeof(T)); }
+
+  /// Hash as a fixed width hexadecimal string.
+  std::string HexDigest(void) const {
+    std::ostringstream oss;
+    oss << std::hex << std::setw(16) << std::setfill('0') << hash_;
+    return oss.str();
+  }
+
+private:
+  static const uint64_t kOffsetBasis_ = 14695981039346656037ULL;
+  static const uint64_t kPrime_ = 1099511628211ULL;
+  uint64_t hash_;
+};
+
+
+/// A nonzero element of a local operator.
+template <typename TenElemT>
+struct LocalOpElem {
+  size_t bpb_coor;
+  size_t tpb_coor;
+  TenElemT elem;
+};
+
+template <typename TenElemT>
+using LocalOpElemVec = std::vector<LocalOpElem<TenElemT>>;
+
+
 /**
 A generic MPO generator. A matrix-product operator (MPO) generator which can
 generate an efficient MPO for a quantum many-body system with any type of n-body
@@ -46,6 +148,12 @@ public:
   using GQTensorT = GQTensor<TenElemT, QNT>;
   using GQTensorVec = std::vector<GQTensorT>;
   using PGQTensorVec = std::vector<GQTensorT *>;
+  using OpLabelConvertorT = LabelConvertor<
+                                GQTensorT, GQTensorContentHash<TenElemT, QNT>
+                            >;
+  using LocalOpElemsCache = std::unordered_map<
+                                OpRepr, LocalOpElemVec<TenElemT>
+                            >;
 
   MPOGenerator(const SiteVec<TenElemT, QNT> &, const QNT &);
 
@@ -75,9 +183,25 @@ public:
     const std::vector<size_t> &inst_op_idxs = kNullUintVec
   );
 
+  GQTEN_Double AddLongRangeTerm(
+      const std::function<TenElemT(const size_t)> &,
+      const GQTensorT &,
+      const GQTensorT &,
+      const GQTensorT &inst_op = GQTensorT(),
+      const GQTEN_Double fit_tol = 1.0E-10,
+      const size_t max_exp_num = 20
+  );
+
   FSM GetFSM(void) { return fsm_; }
 
-  MPO<GQTensorT> Gen(void);
+  MPO<GQTensorT> Gen(const size_t thread_num = 1);
+
+  MPO<GQTensorT> GenWithCache(
+      const std::string &cache_path,
+      const size_t thread_num = 1
+  );
+
+  std::string Fingerprint(void) const;
 
 private:
   size_t N_;
@@ -88,7 +212,7 @@ private:
   std::vector<GQTensorT> id_op_vector_;
   FSM fsm_;
   LabelConvertor<TenElemT> coef_label_convertor_;
-  LabelConvertor<GQTensorT> op_label_convertor_;
+  OpLabelConvertorT op_label_convertor_;
 
   std::vector<size_t> SortSparOpReprMatColsByQN_(
       SparOpReprMat &, IndexT &, const GQTensorVec &
@@ -99,24 +223,26 @@ private:
     const GQTensorVec &, const IndexT &
   );
 
+  static LocalOpElemVec<TenElemT> GenLocalOpElems_(const GQTensorT &);
+
   GQTensorT HeadMpoTenRepr2MpoTen_(
       const SparOpReprMat &,
       const IndexT &,
-      const TenElemVec &, const GQTensorVec &
+      const LocalOpElemsCache &
   );
 
   GQTensorT TailMpoTenRepr2MpoTen_(
       const SparOpReprMat &,
       const IndexT &,
-      const TenElemVec &, const GQTensorVec &
+      const LocalOpElemsCache &
   );
 
   GQTensorT CentMpoTenRepr2MpoTen_(
       const SparOpReprMat &,
       const IndexT &,
       const IndexT &,
-      const TenElemVec &,
-      const GQTensorVec &, const size_t
+      const LocalOpElemsCache &,
+      const size_t
   );
 };
 } /* gqmps2 */
@@ -14,6 +14,8 @@
 #include <iomanip>
 #include <algorithm>    // is_sorted
 #include <map>
+#include <cstdio>       // rename, remove
+#include <unistd.h>     // getpid
 
 #include <assert.h>     // assert
 
@@ -27,14 +29,15 @@ using namespace gqten;
 
 
 // Forward declarations.
-template <typename TenT>
-void AddOpToHeadMpoTen(TenT *, const TenT &, const size_t);
+template <typename TenT, typename TenElemT>
+void AddOpToHeadMpoTen(TenT *, const LocalOpElemVec<TenElemT> &, const size_t);
 
-template <typename TenT>
-void AddOpToTailMpoTen(TenT *, const TenT &, const size_t);
+template <typename TenT, typename TenElemT>
+void AddOpToTailMpoTen(TenT *, const LocalOpElemVec<TenElemT> &, const size_t);
 
-template <typename TenT>
-void AddOpToCentMpoTen(TenT *, const TenT &, const size_t, const size_t);
+template <typename TenT, typename TenElemT>
+void AddOpToCentMpoTen(
+    TenT *, const LocalOpElemVec<TenElemT> &, const size_t, const size_t);
 
 
 /**
@@ -62,7 +65,7 @@ MPOGenerator<TenElemT, QNT>::MPOGenerator(
     pb_in_vector_.emplace_back(InverseIndex(site_vec.sites[i]));
   }
   id_op_vector_ = site_vec.id_ops;
-  op_label_convertor_ = LabelConvertor<GQTensorT>(id_op_vector_[0]);
+  op_label_convertor_ = OpLabelConvertorT(id_op_vector_[0]);
   std::vector<OpLabel> id_op_label_vector;
   for(auto iter = id_op_vector_.begin(); iter< id_op_vector_.end();iter++){
     id_op_label_vector.push_back(op_label_convertor_.Convert(*iter));
@@ -243,48 +246,290 @@ void MPOGenerator<TenElemT, QNT>::AddTerm(
 }
 
 
+/**
+Add a long-range two-body term
+\f$\sum_{i<j} V(j-i) A_{i} O_{i+1} \cdots O_{j-1} B_{j}\f$ on all the site
+pairs. The coupling is fitted to a sum of K exponentials,
+\f$V(r) \approx c^{T} M^{r-1} b\f$, and the term is added to the FSM as
+transitions among K shared middle states on each FSM site, so the bond dimension
+grows by K instead of the number of the site pairs.
+
+The fitted weights are carried by the scaled local operators with trivial
+coefficients, since the symbolic compression can not handle a chain of
+nontrivial coefficients.
+
+@param coupling The coupling \f$V(r)\f$ on the distance r.
+@param op1 The first physical operator \f$A\f$.
+@param op2 The second physical operator \f$B\f$.
+@param inst_op The insertion operator \f$O\f$, the identity operator if it is
+       not given.
+@param fit_tol The relative tolerance of the exponential sum fitting.
+@param max_exp_num The maximal number of the exponentials.
+
+@return The maximal absolute error of the fitted coupling. FitExpSum warns if
+        it misses fit_tol with max_exp_num exponentials.
+
+@since version 0.2.0
+*/
+template <typename TenElemT, typename QNT>
+GQTEN_Double MPOGenerator<TenElemT, QNT>::AddLongRangeTerm(
+    const std::function<TenElemT(const size_t)> &coupling,
+    const GQTensorT &op1,
+    const GQTensorT &op2,
+    const GQTensorT &inst_op,
+    const GQTEN_Double fit_tol,
+    const size_t max_exp_num
+) {
+  assert(N_ >= 2);
+  std::vector<TenElemT> vals;
+  for (size_t r = 1; r < N_; ++r) { vals.push_back(coupling(r)); }
+  auto fit_res = FitExpSum(vals, fit_tol, max_exp_num);
+  auto K = fit_res.K;
+  if (K == 0) { return fit_res.max_err; }   // Zero coupling, do nothing.
+
+  // Middle states of the term on the FSM sites 1 to N-1.
+  std::vector<std::vector<long>> mid_stat_idxs(N_);
+  for (size_t i = 1; i < N_; ++i) {
+    for (size_t a = 0; a < K; ++a) {
+      mid_stat_idxs[i].push_back(fsm_.AddMidStat(i));
+    }
+  }
+
+  auto weighted_op_repr = [this](const TenElemT weight, const GQTensorT &op) {
+    return OpRepr(op_label_convertor_.Convert(weight * op));
+  };
+  for (size_t i = 0; i < N_; ++i) {
+    auto id_op_repr = OpRepr(op_label_convertor_.Convert(id_op_vector_[i]));
+    // Ready to ready before the first physical operator.
+    if (i + 2 < N_) {
+      fsm_.AddEdge(i, kFSMReadyStatIdx, kFSMReadyStatIdx, id_op_repr);
+    }
+    // Final to final behind the second physical operator.
+    if (i >= 2) {
+      fsm_.AddEdge(i, kFSMFinalStatIdx, kFSMFinalStatIdx, id_op_repr);
+    }
+    for (size_t a = 0; a < K; ++a) {
+      // The first physical operator, ready to middle.
+      if (i + 1 < N_ && fit_res.b[a] != TenElemT(0)) {
+        fsm_.AddEdge(
+            i, kFSMReadyStatIdx, mid_stat_idxs[i+1][a],
+            weighted_op_repr(fit_res.b[a], op1)
+        );
+      }
+      // The second physical operator, middle to final.
+      if (i >= 1 && fit_res.c[a] != TenElemT(0)) {
+        fsm_.AddEdge(
+            i, mid_stat_idxs[i][a], kFSMFinalStatIdx,
+            weighted_op_repr(fit_res.c[a], op2)
+        );
+      }
+      // The insertion operators, middle to middle.
+      if (i >= 1 && i + 1 < N_) {
+        auto &inst_op_i = (inst_op == GQTensorT()) ? id_op_vector_[i] : inst_op;
+        for (size_t bb = 0; bb < K; ++bb) {
+          auto m_ab = fit_res.m[a*K + bb];
+          if (m_ab == TenElemT(0)) { continue; }
+          fsm_.AddEdge(
+              i, mid_stat_idxs[i][bb], mid_stat_idxs[i+1][a],
+              weighted_op_repr(m_ab, inst_op_i)
+          );
+        }
+      }
+    }
+  }
+  return fit_res.max_err;
+}
+
+
+/**
+Generate the MPO. The index structures of all the sites are determined first
+from the left end to the right end, since the right virtual bond of a site
+decides the left virtual bond of the next one. Then each distinct operator
+representation is realized only once and the MPO tensors of the sites are filled
+independently.
+
+@param thread_num Number of threads used to fill the MPO tensors.
+
+@since version 0.2.0
+*/
 template <typename TenElemT, typename QNT>
 MPO<typename MPOGenerator<TenElemT, QNT>::GQTensorT>
-MPOGenerator<TenElemT, QNT>::Gen(void) {
+MPOGenerator<TenElemT, QNT>::Gen(const size_t thread_num) {
   auto fsm_comp_mat_repr = fsm_.GenCompressedMatRepr();
   auto label_coef_mapping = coef_label_convertor_.GetLabelObjMapping();
   auto label_op_mapping = op_label_convertor_.GetLabelObjMapping();
-  
-  // Print MPO tensors virtual bond dimension.
-  for (auto &mpo_ten_repr : fsm_comp_mat_repr) {
-    std::cout << std::setw(3) << mpo_ten_repr.cols << std::endl;
-  }
 
-  MPO<GQTensorT> mpo(N_);
+  // Serial phase, the virtual bonds of each site.
+  std::vector<IndexT> rvbs(N_);
   IndexT trans_vb({QNSctT(zero_div_, 1)}, OUT);
   std::vector<size_t> transposed_idxs;
   for (size_t i = 0; i < N_; ++i) {
-    if (i == 0) {
-      transposed_idxs = SortSparOpReprMatColsByQN_(
-                            fsm_comp_mat_repr[i], trans_vb, label_op_mapping);
-      mpo[i] = HeadMpoTenRepr2MpoTen_(
-                   fsm_comp_mat_repr[i], trans_vb,
-                   label_coef_mapping, label_op_mapping);
-    } else if (i == N_-1) {
+    if (i != 0) {
       fsm_comp_mat_repr[i].TransposeRows(transposed_idxs);
-      auto lvb = InverseIndex(trans_vb);
-      mpo[i] = TailMpoTenRepr2MpoTen_(
-                   fsm_comp_mat_repr[i], lvb,
-                   label_coef_mapping, label_op_mapping);
-    } else {
-      fsm_comp_mat_repr[i].TransposeRows(transposed_idxs);
-      auto lvb = InverseIndex(trans_vb);
+    }
+    if (i == 0 || i != N_-1) {
       transposed_idxs = SortSparOpReprMatColsByQN_(
                             fsm_comp_mat_repr[i], trans_vb, label_op_mapping);
-      mpo[i] = CentMpoTenRepr2MpoTen_(
-                   fsm_comp_mat_repr[i], lvb, trans_vb,
-                   label_coef_mapping, label_op_mapping, i);
     }
+    rvbs[i] = trans_vb;
   }
+
+  // Serial phase, realize each distinct operator representation once.
+  LocalOpElemsCache op_elems_cache;
+  for (auto &op_repr_mat : fsm_comp_mat_repr) {
+    for (auto &elem : op_repr_mat.data) {
+      if (op_elems_cache.find(elem) != op_elems_cache.end()) { continue; }
+      auto op = elem.Realize(label_coef_mapping, label_op_mapping);
+      op_elems_cache[elem] = GenLocalOpElems_(op);
+    }
+  }
+
+  // Parallel phase, fill the MPO tensors.
+  MPO<GQTensorT> mpo(N_);
+  mock_gqten::ParallelFor(
+      N_, thread_num,
+      [this, &mpo, &fsm_comp_mat_repr, &rvbs, &op_elems_cache](const size_t i) {
+        if (i == 0) {
+          mpo[i] = HeadMpoTenRepr2MpoTen_(
+                       fsm_comp_mat_repr[i], rvbs[i], op_elems_cache);
+        } else if (i == N_-1) {
+          auto lvb = InverseIndex(rvbs[i-1]);
+          mpo[i] = TailMpoTenRepr2MpoTen_(
+                       fsm_comp_mat_repr[i], lvb, op_elems_cache);
+        } else {
+          auto lvb = InverseIndex(rvbs[i-1]);
+          mpo[i] = CentMpoTenRepr2MpoTen_(
+                       fsm_comp_mat_repr[i], lvb, rvbs[i], op_elems_cache, i);
+        }
+      }
+  );
   return mpo;
 }
 
 
+/**
+Generate the MPO with a cache on the disk. The MPO is loaded from the cache if
+a MPOGenerator with the same fingerprint has dumped it, otherwise it is
+generated and dumped to the cache. The MPO tensors of each fingerprint are
+stored in a subdirectory named by the fingerprint, which is first written to
+a temporary directory and then renamed, so a partially dumped MPO is never
+loaded.
+
+@param cache_path The cache directory, it is created if it does not exist.
+@param thread_num Number of threads used to fill the MPO tensors.
+
+@since version 0.2.0
+*/
+template <typename TenElemT, typename QNT>
+MPO<typename MPOGenerator<TenElemT, QNT>::GQTensorT>
+MPOGenerator<TenElemT, QNT>::GenWithCache(
+    const std::string &cache_path,
+    const size_t thread_num
+) {
+  auto mpo_path = cache_path + "/" + Fingerprint();
+  if (IsPathExist(mpo_path)) {
+    std::cout << "Load MPO from " << mpo_path << std::endl;
+    MPO<GQTensorT> mpo(N_);
+    for (size_t i = 0; i < N_; ++i) {
+      mpo.LoadTen(i, GenMPOTenName(mpo_path, i));
+    }
+    return mpo;
+  }
+
+  auto mpo = Gen(thread_num);
+  if (!IsPathExist(cache_path)) { CreatPath(cache_path); }
+  auto temp_path = mpo_path + ".tmp" + std::to_string(getpid());
+  CreatPath(temp_path);
+  for (size_t i = 0; i < N_; ++i) {
+    mpo.DumpTen(i, GenMPOTenName(temp_path, i));
+  }
+  // Another job may have dumped the same MPO in the meantime.
+  if (std::rename(temp_path.c_str(), mpo_path.c_str()) != 0) {
+    for (size_t i = 0; i < N_; ++i) {
+      std::remove(GenMPOTenName(temp_path, i).c_str());
+    }
+    std::remove(temp_path.c_str());
+  }
+  return mpo;
+}
+
+
+/**
+Fingerprint of the Hamiltonian held by the generator. It covers the sites, the
+divergence of the MPO, the coefficients and operators of the labels and the
+FSM built from the added terms, so two generators have the same fingerprint if
+the terms are added in the same way. The generator version kMPOGenVersion is
+mixed in, so the cached MPOs of an older generator are not reused.
+
+@return The 64-bit FNV-1a hash as a hexadecimal string.
+
+@since version 0.2.0
+*/
+template <typename TenElemT, typename QNT>
+std::string MPOGenerator<TenElemT, QNT>::Fingerprint(void) const {
+  FNV1aHasher hasher;
+  hasher.UpdateValue(kMPOGenVersion);
+  hasher.UpdateValue(N_);
+  // Sites and divergence through the serialized empty tensors.
+  std::ostringstream oss;
+  for (size_t i = 0; i < N_; ++i) {
+    oss << GQTensorT({pb_in_vector_[i], pb_out_vector_[i]});
+  }
+  oss << GQTensorT({IndexT({QNSctT(zero_div_, 1)}, OUT)});
+  for (auto &op : op_label_convertor_.GetLabelObjMapping()) { oss << op; }
+  hasher.Update(oss.str());
+  for (auto &coef : coef_label_convertor_.GetLabelObjMapping()) {
+    hasher.UpdateValue(coef);
+  }
+
+  auto update_op_repr = [&hasher](const OpRepr &op_repr) {
+    auto op_labels = op_repr.GetOpLabelList();
+    auto coef_reprs = op_repr.GetCoefReprList();
+    hasher.UpdateValue(op_labels.size());
+    for (size_t i = 0; i < op_labels.size(); ++i) {
+      hasher.UpdateValue(op_labels[i]);
+      auto coef_labels = coef_reprs[i].GetCoefLabelList();
+      hasher.UpdateValue(coef_labels.size());
+      for (auto coef_label : coef_labels) { hasher.UpdateValue(coef_label); }
+    }
+  };
+  auto &fsm_paths = fsm_.GetFSMCompactPaths();
+  hasher.UpdateValue(fsm_paths.size());
+  for (auto &fsm_path : fsm_paths) {
+    hasher.UpdateValue(fsm_path.head_site_idx);
+    hasher.UpdateValue(fsm_path.ntrvl_ops.size());
+    for (auto &op_repr : fsm_path.ntrvl_ops) { update_op_repr(op_repr); }
+  }
+  auto fsm_edges = fsm_.GetFSMEdges();
+  hasher.UpdateValue(fsm_edges.size());
+  for (auto &fsm_edge : fsm_edges) {
+    hasher.UpdateValue(fsm_edge.phys_site_idx);
+    hasher.UpdateValue(fsm_edge.row_stat_idx);
+    hasher.UpdateValue(fsm_edge.col_stat_idx);
+    update_op_repr(fsm_edge.op_repr);
+  }
+  return hasher.HexDigest();
+}
+
+
+// Nonzero elements of a realized local operator.
+template <typename TenElemT, typename QNT>
+LocalOpElemVec<TenElemT> MPOGenerator<TenElemT, QNT>::GenLocalOpElems_(
+    const GQTensorT &op
+) {
+  LocalOpElemVec<TenElemT> op_elems;
+  for (size_t bpb_coor = 0; bpb_coor < op.GetIndexes()[0].dim(); ++bpb_coor) {
+    for (size_t tpb_coor = 0; tpb_coor < op.GetIndexes()[1].dim(); ++tpb_coor) {
+      auto elem = op.GetElem({bpb_coor, tpb_coor});
+      if (elem != 0.0) {
+        op_elems.push_back({bpb_coor, tpb_coor, elem});
+      }
+    }
+  }
+  return op_elems;
+}
+
+
 template< typename TenElemT, typename QNT>
 QNT MPOGenerator<TenElemT, QNT>::CalcTgtRvbQN_(
     const size_t x, const size_t y, const OpRepr &op_repr,
@@ -306,36 +551,35 @@ std::vector<size_t> MPOGenerator<TenElemT, QNT>::SortSparOpReprMatColsByQN_(
   for (size_t y = 0; y < op_repr_mat.cols; ++y) {
     bool has_ntrvl_op = false;
     QNT col_rvb_qn;
-    for (size_t x = 0; x < op_repr_mat.rows; ++x) {
-      auto elem = op_repr_mat(x, y);
-      if (elem != kNullOpRepr) {
-        auto rvb_qn = CalcTgtRvbQN_(
-                          x, y, elem, label_op_mapping, trans_vb
-                      );
-        if (!has_ntrvl_op) {
-          col_rvb_qn = rvb_qn;
-          has_ntrvl_op = true;
-          bool has_qn = false;
-          size_t offset = 0;
-          for (auto &qn_dim : rvb_qn_dim_pairs) {
-            if (qn_dim.first == rvb_qn) {
-              qn_dim.second += 1;
-              auto beg_it = transposed_idxs.begin();
-              transposed_idxs.insert(beg_it+offset, y);
-              has_qn = true;
-              break;
-            } else {
-              offset += qn_dim.second;
-            }
-          }
-          if (!has_qn) {
-            rvb_qn_dim_pairs.push_back(std::make_pair(rvb_qn, 1));
+    for (auto &ref : op_repr_mat.GetColAdj(y)) {
+      auto x = ref.idx;
+      auto &elem = op_repr_mat.data[ref.data_idx];
+      auto rvb_qn = CalcTgtRvbQN_(
+                        x, y, elem, label_op_mapping, trans_vb
+                    );
+      if (!has_ntrvl_op) {
+        col_rvb_qn = rvb_qn;
+        has_ntrvl_op = true;
+        bool has_qn = false;
+        size_t offset = 0;
+        for (auto &qn_dim : rvb_qn_dim_pairs) {
+          if (qn_dim.first == rvb_qn) {
+            qn_dim.second += 1;
             auto beg_it = transposed_idxs.begin();
             transposed_idxs.insert(beg_it+offset, y);
+            has_qn = true;
+            break;
+          } else {
+            offset += qn_dim.second;
           }
-        } else {
-          assert(rvb_qn == col_rvb_qn);
         }
+        if (!has_qn) {
+          rvb_qn_dim_pairs.push_back(std::make_pair(rvb_qn, 1));
+          auto beg_it = transposed_idxs.begin();
+          transposed_idxs.insert(beg_it+offset, y);
+        }
+      } else {
+        assert(rvb_qn == col_rvb_qn);
       }
     }
   }
@@ -354,15 +598,12 @@ typename MPOGenerator<TenElemT, QNT>::GQTensorT
 MPOGenerator<TenElemT, QNT>::HeadMpoTenRepr2MpoTen_(
     const SparOpReprMat &op_repr_mat,
     const IndexT &rvb,
-    const TenElemVec &label_coef_mapping, const GQTensorVec &label_op_mapping
+    const LocalOpElemsCache &op_elems_cache
 ) {
   auto mpo_ten = GQTensorT({pb_in_vector_.front(), rvb, pb_out_vector_.front()});
-  for (size_t y = 0; y < op_repr_mat.cols; ++y) {
-    auto elem = op_repr_mat(0, y);
-    if (elem != kNullOpRepr) {
-      auto op = elem.Realize(label_coef_mapping, label_op_mapping);
-      AddOpToHeadMpoTen(&mpo_ten, op, y);
-    }
+  for (auto &ref : op_repr_mat.GetRowAdj(0)) {
+    auto &op_elems = op_elems_cache.at(op_repr_mat.data[ref.data_idx]);
+    AddOpToHeadMpoTen(&mpo_ten, op_elems, ref.idx);
   }
   return mpo_ten;
 }
@@ -373,14 +614,11 @@ typename MPOGenerator<TenElemT, QNT>::GQTensorT
 MPOGenerator<TenElemT, QNT>::TailMpoTenRepr2MpoTen_(
     const SparOpReprMat &op_repr_mat,
     const IndexT &lvb,
-    const TenElemVec &label_coef_mapping, const GQTensorVec &label_op_mapping) {
+    const LocalOpElemsCache &op_elems_cache) {
   auto mpo_ten = GQTensorT({pb_in_vector_.back(), lvb, pb_out_vector_.back()});
-  for (size_t x = 0; x < op_repr_mat.rows; ++x) {
-    auto elem = op_repr_mat(x, 0);
-    if (elem != kNullOpRepr) {
-      auto op = elem.Realize(label_coef_mapping, label_op_mapping);
-      AddOpToTailMpoTen(&mpo_ten, op, x);
-    }
+  for (auto &ref : op_repr_mat.GetColAdj(0)) {
+    auto &op_elems = op_elems_cache.at(op_repr_mat.data[ref.data_idx]);
+    AddOpToTailMpoTen(&mpo_ten, op_elems, ref.idx);
   }
   return mpo_ten;
 }
@@ -392,61 +630,50 @@ MPOGenerator<TenElemT, QNT>::CentMpoTenRepr2MpoTen_(
     const SparOpReprMat &op_repr_mat,
     const IndexT &lvb,
     const IndexT &rvb,
-    const TenElemVec &label_coef_mapping, const GQTensorVec &label_op_mapping,
+    const LocalOpElemsCache &op_elems_cache,
     const size_t site
 ) {
   auto mpo_ten = GQTensorT({lvb, pb_in_vector_[site], pb_out_vector_[site], rvb});
   for (size_t x = 0; x < op_repr_mat.rows; ++x) {
-    for (size_t y = 0; y < op_repr_mat.cols; ++y) {
-      auto elem = op_repr_mat(x, y);
-      if (elem != kNullOpRepr) {
-        auto op = elem.Realize(label_coef_mapping, label_op_mapping);
-        AddOpToCentMpoTen(&mpo_ten, op, x, y);
-      }
+    for (auto &ref : op_repr_mat.GetRowAdj(x)) {
+      auto &op_elems = op_elems_cache.at(op_repr_mat.data[ref.data_idx]);
+      AddOpToCentMpoTen(&mpo_ten, op_elems, x, ref.idx);
     }
   }
   return mpo_ten;
 }
 
 
-template <typename TenT>
-void AddOpToHeadMpoTen(TenT *pmpo_ten, const TenT &rop, const size_t rvb_coor) {
-  for (size_t bpb_coor = 0; bpb_coor < rop.GetIndexes()[0].dim(); ++bpb_coor) {
-    for (size_t tpb_coor = 0; tpb_coor < rop.GetIndexes()[1].dim(); ++tpb_coor) {
-      auto elem = rop.GetElem({bpb_coor, tpb_coor});
-      if (elem != 0.0) {
-        (*pmpo_ten)(bpb_coor, rvb_coor, tpb_coor) = elem;
-      }
-    }
+template <typename TenT, typename TenElemT>
+void AddOpToHeadMpoTen(
+    TenT *pmpo_ten, const LocalOpElemVec<TenElemT> &op_elems,
+    const size_t rvb_coor
+) {
+  for (auto &op_elem : op_elems) {
+    (*pmpo_ten)(op_elem.bpb_coor, rvb_coor, op_elem.tpb_coor) = op_elem.elem;
   }
 }
 
 
-template <typename TenT>
-void AddOpToTailMpoTen(TenT *pmpo_ten, const TenT &rop, const size_t lvb_coor) {
-  for (size_t bpb_coor = 0; bpb_coor < rop.GetIndexes()[0].dim(); ++bpb_coor) {
-    for (size_t tpb_coor = 0; tpb_coor < rop.GetIndexes()[1].dim(); ++tpb_coor) {
-      auto elem = rop.GetElem({bpb_coor, tpb_coor});
-      if (elem != 0.0) {
-        (*pmpo_ten)(bpb_coor, lvb_coor, tpb_coor) = elem;
-      }
-    }
+template <typename TenT, typename TenElemT>
+void AddOpToTailMpoTen(
+    TenT *pmpo_ten, const LocalOpElemVec<TenElemT> &op_elems,
+    const size_t lvb_coor
+) {
+  for (auto &op_elem : op_elems) {
+    (*pmpo_ten)(op_elem.bpb_coor, lvb_coor, op_elem.tpb_coor) = op_elem.elem;
   }
 }
 
 
-template <typename TenT>
+template <typename TenT, typename TenElemT>
 void AddOpToCentMpoTen(
-    TenT *pmpo_ten, const TenT &rop,
+    TenT *pmpo_ten, const LocalOpElemVec<TenElemT> &op_elems,
     const size_t lvb_coor, const size_t rvb_coor
 ) {
-  for (size_t bpb_coor = 0; bpb_coor < rop.GetIndexes()[0].dim(); ++bpb_coor) {
-    for (size_t tpb_coor = 0; tpb_coor < rop.GetIndexes()[1].dim(); ++tpb_coor) {
-      auto elem = rop.GetElem({bpb_coor, tpb_coor});
-      if (elem != 0.0) {
-        (*pmpo_ten)(lvb_coor, bpb_coor, tpb_coor, rvb_coor) = elem;
-      }
-    }
+  for (auto &op_elem : op_elems) {
+    (*pmpo_ten)(lvb_coor, op_elem.bpb_coor, op_elem.tpb_coor, rvb_coor) =
+        op_elem.elem;
   }
 }
 } /* gqmps2 */
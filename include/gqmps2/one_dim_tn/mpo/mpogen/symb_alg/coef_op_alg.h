@@ -11,8 +11,12 @@
 #include "gqmps2/one_dim_tn/mpo/mpogen/symb_alg/sparse_mat.h"
 
 #include <vector>
+#include <map>
 #include <algorithm>
 #include <iostream>
+#include <iterator>     // back_inserter
+#include <numeric>      // iota
+#include <functional>   // hash
 
 #include <assert.h>
 
@@ -22,11 +26,7 @@
 
 
 // Forward declarations.
-template <typename T>
-bool ElemInVec(const T &, const std::vector<T> &, long &pos);
-
-template <typename VecT>
-VecT ConcatenateTwoVec(const VecT &, const VecT &);
+inline void HashCombine(size_t &, const size_t);
 
 
 // Label of coefficient.
@@ -35,7 +35,8 @@ using CoefLabel = long;
 const CoefLabel kIdCoefLabel = 0;     // Coefficient label for identity 1.
 
 
-// Representation of coefficient.
+// Representation of coefficient. The labels are kept in ascending order, so
+// the equal coefficients have the same representation.
 class CoefRepr {
 
 public:
@@ -46,7 +47,9 @@ public:
   }
 
   CoefRepr(const std::vector<CoefLabel> &coef_label_list) :
-      coef_label_list_(coef_label_list) {}
+      coef_label_list_(coef_label_list) {
+    std::sort(coef_label_list_.begin(), coef_label_list_.end());
+  }
 
   CoefRepr(const CoefRepr &coef_repr) :
       coef_label_list_(coef_repr.coef_label_list_) {}
@@ -61,21 +64,7 @@ public:
   }
 
   bool operator==(const CoefRepr &rhs) const {
-    const std::vector<CoefLabel> &rc_lhs_coef_label_list = coef_label_list_;
-    std::vector<CoefLabel> rhs_coef_label_list = rhs.coef_label_list_;
-    if (rc_lhs_coef_label_list.size() != rhs_coef_label_list.size()) {
-      return false;
-    }
-    for (auto &l_elem : rc_lhs_coef_label_list) {
-      long pos_in_rhs = -1;
-      if (!ElemInVec(l_elem, rhs_coef_label_list, pos_in_rhs)) {
-        return false;
-      } else {
-        rhs_coef_label_list.erase(rhs_coef_label_list.begin() + pos_in_rhs);
-      }
-    }
-    if (!rhs_coef_label_list.empty()) { return false; }
-    return true;
+    return coef_label_list_ == rhs.coef_label_list_;
   }
 
   bool operator!=(const CoefRepr &rhs) const {
@@ -83,7 +72,22 @@ public:
   }
 
   CoefRepr operator+(const CoefRepr &rhs) const {
-    return CoefRepr(ConcatenateTwoVec(coef_label_list_, rhs.coef_label_list_));
+    CoefRepr res;
+    res.coef_label_list_.reserve(
+        coef_label_list_.size() + rhs.coef_label_list_.size());
+    std::merge(
+        coef_label_list_.begin(), coef_label_list_.end(),
+        rhs.coef_label_list_.begin(), rhs.coef_label_list_.end(),
+        std::back_inserter(res.coef_label_list_));
+    return res;
+  }
+
+  size_t Hash(void) const {
+    size_t seed = coef_label_list_.size();
+    for (auto coef_label : coef_label_list_) {
+      HashCombine(seed, std::hash<CoefLabel>()(coef_label));
+    }
+    return seed;
   }
 
   template <typename CoefT>
@@ -136,21 +140,29 @@ public:
     op_label_list_.push_back(op_label);
   }
 
+  // The terms are sorted by the operator labels and the coefficients of the
+  // same operator are summed.
   OpRepr(
       const std::vector<CoefRepr> &coef_reprs,
       const std::vector<OpLabel> &op_labels) {
-    for (size_t i = 0; i < op_labels.size(); ++i) {
-      auto poss_it = std::find(op_label_list_.cbegin(), op_label_list_.cend(),
-                               op_labels[i]);
-      if (poss_it == op_label_list_.cend()) {
+    assert(coef_reprs.size() == op_labels.size());
+    std::vector<size_t> term_idxs(op_labels.size());
+    std::iota(term_idxs.begin(), term_idxs.end(), 0);
+    if (!std::is_sorted(op_labels.begin(), op_labels.end())) {
+      std::stable_sort(
+          term_idxs.begin(), term_idxs.end(),
+          [&op_labels](const size_t i, const size_t j) {
+            return op_labels[i] < op_labels[j];
+          });
+    }
+    for (auto i : term_idxs) {
+      if (!op_label_list_.empty() && op_label_list_.back() == op_labels[i]) {
+        coef_repr_list_.back() = coef_repr_list_.back() + coef_reprs[i];
+      } else {
         coef_repr_list_.push_back(coef_reprs[i]);
         op_label_list_.push_back(op_labels[i]);
-      } else {
-        size_t idx = poss_it - op_label_list_.cbegin();
-        coef_repr_list_[idx] = coef_repr_list_[idx] + coef_reprs[i];
       }
     }
-    assert(coef_repr_list_.size() == op_label_list_.size());
   }
 
   OpRepr(const std::vector<OpLabel> &op_labels) :
@@ -165,49 +177,55 @@ public:
   }
 
   bool operator==(const OpRepr &rhs) const {
-    const std::vector<CoefRepr> &rc_lhs_coef_repr_list = coef_repr_list_;
-    const std::vector<OpLabel> &rc_lhs_op_label_list = op_label_list_;
-    if (rc_lhs_op_label_list.size() != rhs.op_label_list_.size()) {
-      return false;
-    }
-    std::vector<CoefRepr> rhs_coef_repr_list = rhs.coef_repr_list_;
-    std::vector<OpLabel> rhs_op_label_list = rhs.op_label_list_;
-    for (size_t i = 0; i < rc_lhs_op_label_list.size(); ++i) {
-      long pos_in_rhs = -1;
-      if (!ElemInVec(
-               rc_lhs_op_label_list[i], rhs_op_label_list, pos_in_rhs)) {
-        return false;
-      } else if (rc_lhs_coef_repr_list[i] != rhs_coef_repr_list[pos_in_rhs]) {
-        return false;
-      } else {
-        rhs_coef_repr_list.erase(rhs_coef_repr_list.begin() + pos_in_rhs);
-        rhs_op_label_list.erase(rhs_op_label_list.begin() + pos_in_rhs);
-      }
-    }
-    if (!rhs_op_label_list.empty()) { return false; }
-    return true;
+    return (op_label_list_ == rhs.op_label_list_) &&
+           (coef_repr_list_ == rhs.coef_repr_list_);
   }
 
   bool operator!=(const OpRepr &rhs) const {
     return !(*this == rhs);
   }
 
+  // Merge the two sorted term lists.
   OpRepr operator+(const OpRepr &rhs) const {
-    auto coef_repr_list = coef_repr_list_;
-    auto op_label_list = op_label_list_;
-    auto rhs_size = rhs.coef_repr_list_.size();
-    for (size_t i = 0; i < rhs_size; ++i) {
-      auto poss_it = std::find(op_label_list.cbegin(), op_label_list.cend(),
-                               rhs.op_label_list_[i]);
-      if (poss_it == op_label_list.cend()) {
-        coef_repr_list.push_back(rhs.coef_repr_list_[i]);
-        op_label_list.push_back(rhs.op_label_list_[i]);
+    OpRepr res;
+    auto lhs_size = op_label_list_.size();
+    auto rhs_size = rhs.op_label_list_.size();
+    res.coef_repr_list_.reserve(lhs_size + rhs_size);
+    res.op_label_list_.reserve(lhs_size + rhs_size);
+    size_t i = 0, j = 0;
+    while (i < lhs_size || j < rhs_size) {
+      if (
+          j == rhs_size ||
+          (i < lhs_size && op_label_list_[i] < rhs.op_label_list_[j])
+      ) {
+        res.coef_repr_list_.push_back(coef_repr_list_[i]);
+        res.op_label_list_.push_back(op_label_list_[i]);
+        i++;
+      } else if (
+          i == lhs_size ||
+          rhs.op_label_list_[j] < op_label_list_[i]
+      ) {
+        res.coef_repr_list_.push_back(rhs.coef_repr_list_[j]);
+        res.op_label_list_.push_back(rhs.op_label_list_[j]);
+        j++;
       } else {
-        size_t idx = poss_it - op_label_list.cbegin();
-        coef_repr_list[idx] = coef_repr_list[idx] + rhs.coef_repr_list_[i];
+        res.coef_repr_list_.push_back(
+            coef_repr_list_[i] + rhs.coef_repr_list_[j]);
+        res.op_label_list_.push_back(op_label_list_[i]);
+        i++;
+        j++;
       }
     }
-    return OpRepr(coef_repr_list, op_label_list);
+    return res;
+  }
+
+  size_t Hash(void) const {
+    size_t seed = op_label_list_.size();
+    for (size_t i = 0; i < op_label_list_.size(); ++i) {
+      HashCombine(seed, std::hash<OpLabel>()(op_label_list_[i]));
+      HashCombine(seed, coef_repr_list_[i].Hash());
+    }
+    return seed;
   }
 
   template<typename CoefT, typename OpT>
@@ -238,6 +256,19 @@ private:
   std::vector<OpLabel> op_label_list_;
 };
 
+namespace std {
+template <>
+struct hash<CoefRepr> {
+  size_t operator()(const CoefRepr &coef_repr) const { return coef_repr.Hash(); }
+};
+
+template <>
+struct hash<OpRepr> {
+  size_t operator()(const OpRepr &op_repr) const { return op_repr.Hash(); }
+};
+} /* std */
+
+
 const OpRepr kNullOpRepr = OpRepr();          // Operator representation for null operator.
 const OpRepr kIdOpRepr = OpRepr(kIdOpLabel);  // Operator representation for identity operator.
 
@@ -287,10 +318,7 @@ public:
       SparOpReprMatBase(spar_mat) {}
 
   SparOpReprMat &operator=(const SparOpReprMat &spar_mat) {
-    rows = spar_mat.rows;
-    cols = spar_mat.cols;
-    data = spar_mat.data;
-    indexes = spar_mat.indexes;
+    SparOpReprMatBase::operator=(spar_mat);
     return *this;
   }
 
@@ -318,10 +346,8 @@ public:
 
   CoefRepr CalcRowCoef(const size_t row_idx) {
     std::vector<CoefRepr> nonull_op_repr_coefs;
-    for (size_t y = 0; y < cols; ++y) {
-      if (indexes[CalcOffset(row_idx, y)] != -1) {
-        nonull_op_repr_coefs.push_back(GetOpReprCoef((*this)(row_idx, y)));
-      }
+    for (auto &ref : row_adjs[row_idx]) {
+      nonull_op_repr_coefs.push_back(GetOpReprCoef(data[ref.data_idx]));
     }
     if (nonull_op_repr_coefs.size() == 0) {
       return kNullCoefRepr;
@@ -338,10 +364,8 @@ public:
 
   CoefRepr CalcColCoef(const size_t col_idx) {
     std::vector<CoefRepr> nonull_op_repr_coefs;
-    for (size_t x = 0; x < rows; ++x) {
-      if (indexes[CalcOffset(x, col_idx)] != -1) {
-        nonull_op_repr_coefs.push_back(GetOpReprCoef((*this)(x, col_idx)));
-      }
+    for (auto &ref : col_adjs[col_idx]) {
+      nonull_op_repr_coefs.push_back(GetOpReprCoef(data[ref.data_idx]));
     }
     if (nonull_op_repr_coefs.size() == 0) {
       return kNullCoefRepr;
@@ -357,20 +381,14 @@ public:
   }
 
   void RemoveRowCoef(const size_t row_idx) {
-    for (size_t y = 0; y < cols; ++y) {
-      if (indexes[CalcOffset(row_idx, y)] != -1) {
-        auto elem = (*this)(row_idx, y);
-        this->SetElem(row_idx, y, SeparateCoefAndBase(elem).second);
-      }
+    for (auto &ref : row_adjs[row_idx]) {
+      data[ref.data_idx] = SeparateCoefAndBase(data[ref.data_idx]).second;
     }
   }
 
   void RemoveColCoef(const size_t col_idx) {
-    for (size_t x = 0; x < rows; ++x) {
-      if (indexes[CalcOffset(x, col_idx)] != -1) {
-        auto elem = (*this)(x, col_idx);
-        this->SetElem(x, col_idx, SeparateCoefAndBase(elem).second);
-      }
+    for (auto &ref : col_adjs[col_idx]) {
+      data[ref.data_idx] = SeparateCoefAndBase(data[ref.data_idx]).second;
     }
   }
 
@@ -398,11 +416,7 @@ private:
   SortMapping GenSortRowsMapping_(void) const {
     SortMapping mapping;
     for (size_t x = 0; x < rows; ++x) {
-      size_t nonull_elem_num = 0;
-      for (size_t y = 0; y < cols; ++y) {
-        if (indexes[CalcOffset(x, y)] != -1) { nonull_elem_num++; }
-      }
-      mapping.push_back(std::make_pair(nonull_elem_num, x));
+      mapping.push_back(std::make_pair(row_adjs[x].size(), x));
     }
     return mapping;
   }
@@ -410,11 +424,7 @@ private:
   SortMapping GenSortColsMapping_(void) const {
     SortMapping mapping;
     for (size_t y = 0; y < cols; ++y) {
-      size_t nonull_elem_num = 0;
-      for (size_t x = 0; x < rows; ++x) {
-        if (indexes[CalcOffset(x, y)] != -1) { nonull_elem_num++; }
-      }
-      mapping.push_back(std::make_pair(nonull_elem_num, y));
+      mapping.push_back(std::make_pair(col_adjs[y].size(), y));
     }
     return mapping;
   }
@@ -422,19 +432,17 @@ private:
   CoefRepr CalcRowOverlap_(
       const std::vector<OpRepr> &row, const size_t tgt_row_idx) const {
     CoefReprVec poss_overlaps;
-    for (size_t y = 0; y < cols; ++y) {
-      if (indexes[CalcOffset(tgt_row_idx, y)] != -1) {
-        auto tgt_op = row[y];
-        auto base_op = (*this)(tgt_row_idx, y);
-        if (tgt_op == base_op) {
-          poss_overlaps.push_back(kIdCoefRepr);
+    for (auto &ref : row_adjs[tgt_row_idx]) {
+      auto &tgt_op = row[ref.idx];
+      auto &base_op = data[ref.data_idx];
+      if (tgt_op == base_op) {
+        poss_overlaps.push_back(kIdCoefRepr);
+      } else {
+        auto tgt_coef_and_base_op = SeparateCoefAndBase(tgt_op);
+        if (tgt_coef_and_base_op.second == base_op) {
+          poss_overlaps.push_back(tgt_coef_and_base_op.first);
         } else {
-          auto tgt_coef_and_base_op = SeparateCoefAndBase(tgt_op);
-          if (tgt_coef_and_base_op.second == base_op) {
-            poss_overlaps.push_back(tgt_coef_and_base_op.first);
-          } else {
-            return kNullCoefRepr;
-          }
+          return kNullCoefRepr;
         }
       }
     }
@@ -450,19 +458,17 @@ private:
   CoefRepr CalcColOverlap_(
       const std::vector<OpRepr> &col, const size_t tgt_col_idx) const {
     CoefReprVec poss_overlaps;
-    for (size_t x = 0; x < rows; ++x) {
-      if (indexes[CalcOffset(x, tgt_col_idx)] != -1) {
-        auto tgt_op = col[x];
-        auto base_op = (*this)(x, tgt_col_idx);
-        if (tgt_op == base_op) {
-          poss_overlaps.push_back(kIdCoefRepr);
+    for (auto &ref : col_adjs[tgt_col_idx]) {
+      auto &tgt_op = col[ref.idx];
+      auto &base_op = data[ref.data_idx];
+      if (tgt_op == base_op) {
+        poss_overlaps.push_back(kIdCoefRepr);
+      } else {
+        auto tgt_coef_and_base_op = SeparateCoefAndBase(tgt_op);
+        if (tgt_coef_and_base_op.second == base_op) {
+          poss_overlaps.push_back(tgt_coef_and_base_op.first);
         } else {
-          auto tgt_coef_and_base_op = SeparateCoefAndBase(tgt_op);
-          if (tgt_coef_and_base_op.second == base_op) {
-            poss_overlaps.push_back(tgt_coef_and_base_op.first);
-          } else {
-            return kNullCoefRepr;
-          }
+          return kNullCoefRepr;
         }
       }
     }
@@ -499,12 +505,11 @@ void SparCoefReprMatSparOpReprMatIncompleteMultiKernel(
     const size_t coef_mat_row_idx, const size_t op_mat_col_idx,
     SparOpReprMat &res) {
   OpRepr res_elem;
-  for (size_t i = 0; i < coef_mat.cols; ++i) {
-    if (coef_mat.indexes[coef_mat.CalcOffset(coef_mat_row_idx, i)] != -1 &&
-        op_mat.indexes[op_mat.CalcOffset(i, op_mat_col_idx)] != -1) {
+  for (auto &ref : coef_mat.row_adjs[coef_mat_row_idx]) {
+    auto &op = op_mat(ref.idx, op_mat_col_idx);
+    if (op != kNullOpRepr) {
       res_elem = res_elem + CoefReprOpReprIncompleteMulti(
-                                coef_mat(coef_mat_row_idx, i),
-                                op_mat(i, op_mat_col_idx));
+                                coef_mat.data[ref.data_idx], op);
     }
   }
   if (res_elem != kNullOpRepr) {
@@ -518,12 +523,11 @@ void SparOpReprMatSparCoefReprMatIncompleteMultiKernel(
     const size_t op_mat_row_idx, const size_t coef_mat_col_idx,
     SparOpReprMat &res) {
   OpRepr res_elem;
-  for (size_t i = 0; i < op_mat.cols; ++i) {
-    if (op_mat.indexes[op_mat.CalcOffset(op_mat_row_idx, i)] != -1 &&
-        coef_mat.indexes[coef_mat.CalcOffset(i, coef_mat_col_idx)] != -1) {
+  for (auto &ref : op_mat.row_adjs[op_mat_row_idx]) {
+    auto &coef = coef_mat(ref.idx, coef_mat_col_idx);
+    if (coef != kNullCoefRepr) {
       res_elem = res_elem + CoefReprOpReprIncompleteMulti(
-                                coef_mat(i, coef_mat_col_idx),
-                                op_mat(op_mat_row_idx, i));
+                                coef, op_mat.data[ref.data_idx]);
     }
   }
   if (res_elem != kNullOpRepr) {
@@ -536,10 +540,22 @@ SparOpReprMat SparCoefReprMatSparOpReprMatIncompleteMulti(
     const SparCoefReprMat &coef_mat, const SparOpReprMat &op_mat) {
   assert(coef_mat.cols == op_mat.rows);
   SparOpReprMat res(coef_mat.rows, op_mat.cols);
+  // Row by row, the terms of each element are summed in the order of i.
+  std::map<size_t, OpRepr> res_row;
   for (size_t x = 0; x < coef_mat.rows; ++x) {
-    for (size_t y = 0; y < op_mat.cols; ++y) {
-      SparCoefReprMatSparOpReprMatIncompleteMultiKernel(
-          coef_mat, op_mat, x, y, res);
+    res_row.clear();
+    for (auto &coef_ref : coef_mat.row_adjs[x]) {
+      auto &coef = coef_mat.data[coef_ref.data_idx];
+      for (auto &op_ref : op_mat.row_adjs[coef_ref.idx]) {
+        auto &res_elem = res_row[op_ref.idx];
+        res_elem = res_elem + CoefReprOpReprIncompleteMulti(
+                                  coef, op_mat.data[op_ref.data_idx]);
+      }
+    }
+    for (auto &y_elem : res_row) {
+      if (y_elem.second != kNullOpRepr) {
+        res.SetElem(x, y_elem.first, y_elem.second);
+      }
     }
   }
   return res;
@@ -550,10 +566,22 @@ SparOpReprMat SparOpReprMatSparCoefReprMatIncompleteMulti(
     const SparOpReprMat &op_mat, const SparCoefReprMat &coef_mat) {
   assert(op_mat.cols == coef_mat.rows);
   SparOpReprMat res(op_mat.rows, coef_mat.cols);
+  // Row by row, the terms of each element are summed in the order of i.
+  std::map<size_t, OpRepr> res_row;
   for (size_t x = 0; x < op_mat.rows; ++x) {
-    for (size_t y = 0; y < coef_mat.cols; ++y) {
-      SparOpReprMatSparCoefReprMatIncompleteMultiKernel(
-          op_mat, coef_mat, x, y, res);
+    res_row.clear();
+    for (auto &op_ref : op_mat.row_adjs[x]) {
+      auto &op = op_mat.data[op_ref.data_idx];
+      for (auto &coef_ref : coef_mat.row_adjs[op_ref.idx]) {
+        auto &res_elem = res_row[coef_ref.idx];
+        res_elem = res_elem + CoefReprOpReprIncompleteMulti(
+                                  coef_mat.data[coef_ref.data_idx], op);
+      }
+    }
+    for (auto &y_elem : res_row) {
+      if (y_elem.second != kNullOpRepr) {
+        res.SetElem(x, y_elem.first, y_elem.second);
+      }
     }
   }
   return res;
@@ -569,16 +597,15 @@ OpReprVec CalcSparOpReprMatRowLinCmb(
   auto res = OpReprVec(m.cols, kNullOpRepr);
   for (size_t i = 0; i < work_row_num; ++i) {
     auto cmb_coef = cmb[i];
-    auto row = m.GetRow(i);
     if (cmb_coef == kIdCoefRepr) {
-      for (size_t j = 0; j < m.cols; ++j) {
-        res[j] = res[j] + row[j];
+      for (auto &ref : m.row_adjs[i]) {
+        res[ref.idx] = res[ref.idx] + m.data[ref.data_idx];
       }
     } else if (cmb_coef == kNullCoefRepr) {
       // Do nothing.
     } else {
-      for (size_t j = 0; j < m.cols; ++j) {
-        auto elem = row[j];
+      for (auto &ref : m.row_adjs[i]) {
+        auto elem = m.data[ref.data_idx];
         for (auto &coef_repr : elem.coef_repr_list_) {
           if (coef_repr == kIdCoefRepr) {
             coef_repr = cmb_coef;
@@ -587,7 +614,7 @@ OpReprVec CalcSparOpReprMatRowLinCmb(
             exit(1);
           }
         }
-        res[j] = res[j] + elem;
+        res[ref.idx] = res[ref.idx] + elem;
       }
     }
   }
@@ -602,16 +629,15 @@ OpReprVec CalcSparOpReprMatColLinCmb(
   auto res = OpReprVec(m.rows, kNullOpRepr);
   for (size_t i = 0; i < work_col_num; ++i) {
     auto cmb_coef = cmb[i];
-    auto col = m.GetCol(i);
     if (cmb_coef == kIdCoefRepr) {
-      for (size_t j = 0; j < m.rows; ++j) {
-        res[j] = res[j] + col[j];
+      for (auto &ref : m.col_adjs[i]) {
+        res[ref.idx] = res[ref.idx] + m.data[ref.data_idx];
       }
     } else if (cmb_coef == kNullCoefRepr) {
       // Do nothing.
     } else {
-      for (size_t j = 0; j < m.rows; ++j) {
-        auto elem = col[j];
+      for (auto &ref : m.col_adjs[i]) {
+        auto elem = m.data[ref.data_idx];
         for (auto &coef_repr : elem.coef_repr_list_) {
           if (coef_repr == kIdCoefRepr) {
             coef_repr = cmb_coef;
@@ -620,7 +646,7 @@ OpReprVec CalcSparOpReprMatColLinCmb(
             exit(1);
           }
         }
-        res[j] = res[j] + elem;
+        res[ref.idx] = res[ref.idx] + elem;
       }
     }
   }
@@ -628,67 +654,206 @@ OpReprVec CalcSparOpReprMatColLinCmb(
 }
 
 
-void SparOpReprMatRowDelinearize(
-    SparOpReprMat &target, SparOpReprMat &follower) {
-  auto row_num = target.rows;
-  size_t i;
-  for (i = 1; i < row_num; ++i) {
-    auto cmb = target.CalcRowLinCmb(i);
-    if (CalcSparOpReprMatRowLinCmb(target, cmb) == target.GetRow(i)) {
-      // Remove the row.
-      target.RemoveRow(i);
-      // Construct transform matrix.
-      SparCoefReprMat trans_mat(row_num, row_num-1);
-      for (size_t j = 0; j < i; ++j) {
-        trans_mat.SetElem(j, j, kIdCoefRepr);
+// Linear combination of a line (row or column) over the kept lines before it,
+// as (line index, coefficient) pairs in ascending order of the line index.
+using SparLinCmb = std::vector<std::pair<size_t, CoefRepr>>;
+
+
+// Overlap coefficient of a line on a base line, see CalcRowOverlap_.
+CoefRepr CalcAdjListOverlap(
+    const SparMatAdjList &line, const SparMatAdjList &base_line,
+    const OpReprVec &data) {
+  CoefReprVec poss_overlaps;
+  for (auto &ref : base_line) {
+    auto it = FindInSparMatAdjList(line, ref.idx);
+    auto &tgt_op = (it != line.cend() && it->idx == ref.idx) ?
+                   data[it->data_idx] : kNullOpRepr;
+    auto &base_op = data[ref.data_idx];
+    if (tgt_op == base_op) {
+      poss_overlaps.push_back(kIdCoefRepr);
+    } else {
+      auto tgt_coef_and_base_op = SeparateCoefAndBase(tgt_op);
+      if (tgt_coef_and_base_op.second == base_op) {
+        poss_overlaps.push_back(tgt_coef_and_base_op.first);
+      } else {
+        return kNullCoefRepr;
       }
-      for (size_t j = 0; j < i; ++j) {
-        trans_mat.SetElem(i, j, cmb[j]);
+    }
+  }
+  if (poss_overlaps.empty()) { return kNullCoefRepr; }
+  for (auto &poss_overlap : poss_overlaps) {
+    if (poss_overlap != poss_overlaps[0]) {
+      return kNullCoefRepr;
+    }
+  }
+  return poss_overlaps[0];
+}
+
+
+// Term of a line in the linear combination, see CalcSparOpReprMatRowLinCmb.
+OpRepr CalcLinCmbTerm(const CoefRepr &cmb_coef, const OpRepr &elem) {
+  if (cmb_coef == kIdCoefRepr) { return elem; }
+  auto coef_reprs = elem.GetCoefReprList();
+  for (auto &coef_repr : coef_reprs) {
+    if (coef_repr == kIdCoefRepr) {
+      coef_repr = cmb_coef;
+    } else {
+      std::cout << "Unsupported operation!" << std::endl;
+      exit(1);
+    }
+  }
+  return OpRepr(coef_reprs, elem.GetOpLabelList());
+}
+
+
+// Scan the lines in order and find all the lines which are linear combinations
+// of the kept lines before them. A removed line never takes part in the later
+// combinations, so one scan finds the same lines as removing them one by one.
+// Only the kept lines sharing a nonnull position with the line can have a
+// nonnull overlap, they are found from the crossing lists.
+std::vector<bool> FindSparOpReprMatDepLines(
+    const std::vector<SparMatAdjList> &lines,
+    const std::vector<SparMatAdjList> &cross_lines,
+    const OpReprVec &data,
+    std::vector<SparLinCmb> &cmbs) {
+  auto line_num = lines.size();
+  std::vector<bool> is_dep(line_num, false);
+  cmbs = std::vector<SparLinCmb>(line_num);
+  std::vector<size_t> cands;
+  std::map<size_t, OpRepr> lin_cmb;
+  for (size_t i = 1; i < line_num; ++i) {
+    auto &line = lines[i];
+    cands.clear();
+    for (auto &ref : line) {
+      for (auto &cross_ref : cross_lines[ref.idx]) {
+        if (cross_ref.idx >= i) { break; }
+        if (!is_dep[cross_ref.idx]) { cands.push_back(cross_ref.idx); }
+      }
+    }
+    std::sort(cands.begin(), cands.end());
+    cands.erase(std::unique(cands.begin(), cands.end()), cands.end());
+
+    SparLinCmb cmb;
+    for (auto cand : cands) {
+      auto coef = CalcAdjListOverlap(line, lines[cand], data);
+      if (coef != kNullCoefRepr) { cmb.push_back(std::make_pair(cand, coef)); }
+    }
+    lin_cmb.clear();
+    for (auto &cand_coef : cmb) {
+      for (auto &ref : lines[cand_coef.first]) {
+        auto &elem = lin_cmb[ref.idx];
+        elem = elem + CalcLinCmbTerm(cand_coef.second, data[ref.data_idx]);
+      }
+    }
+    if (lin_cmb.size() != line.size()) { continue; }
+    bool is_lin_cmb = true;
+    for (auto &ref : line) {
+      auto it = lin_cmb.find(ref.idx);
+      if (it == lin_cmb.end() || it->second != data[ref.data_idx]) {
+        is_lin_cmb = false;
+        break;
       }
-      for (size_t j = i+1; j < row_num; ++j) {
-        trans_mat.SetElem(j, j-1, kIdCoefRepr);
+    }
+    if (is_lin_cmb) {
+      is_dep[i] = true;
+      cmbs[i] = std::move(cmb);
+    }
+  }
+  return is_dep;
+}
+
+
+// Apply the combined transform of the removed lines on the follower. Each
+// follower line (crossing the transformed direction) gives the new elements
+// keyed by the new indexes. The terms of an element are summed in the order of
+// the old indexes, as the transforms are applied one by one.
+std::vector<std::map<size_t, OpRepr>> ApplySparLinCmbs(
+    const std::vector<SparMatAdjList> &follower_lines,
+    const OpReprVec &follower_data,
+    const std::vector<bool> &is_dep,
+    const std::vector<SparLinCmb> &cmbs) {
+  std::vector<size_t> new_idxs(is_dep.size());
+  size_t new_idx = 0;
+  for (size_t i = 0; i < is_dep.size(); ++i) {
+    new_idxs[i] = new_idx;
+    if (!is_dep[i]) { new_idx++; }
+  }
+  std::vector<std::map<size_t, OpRepr>> new_lines(follower_lines.size());
+  for (size_t x = 0; x < follower_lines.size(); ++x) {
+    auto &new_line = new_lines[x];
+    for (auto &ref : follower_lines[x]) {
+      auto &op = follower_data[ref.data_idx];
+      if (!is_dep[ref.idx]) {
+        auto &res_elem = new_line[new_idxs[ref.idx]];
+        res_elem = res_elem + op;
+      } else {
+        for (auto &cand_coef : cmbs[ref.idx]) {
+          auto &res_elem = new_line[new_idxs[cand_coef.first]];
+          res_elem = res_elem + CoefReprOpReprIncompleteMulti(
+                                    cand_coef.second, op);
+        }
       }
-      // Calculate new follower.
-      follower = SparOpReprMatSparCoefReprMatIncompleteMulti(
-                     follower, trans_mat);
-      break;
     }
   }
-  if (i < row_num) {
-    SparOpReprMatRowDelinearize(target, follower);
+  return new_lines;
+}
+
+
+// Remove all the linearly dependent rows of target in one scan and apply the
+// combined transform on the columns of follower.
+void SparOpReprMatRowDelinearize(
+    SparOpReprMat &target, SparOpReprMat &follower) {
+  assert(target.rows == follower.cols);
+  std::vector<SparLinCmb> cmbs;
+  auto is_dep = FindSparOpReprMatDepLines(
+                    target.row_adjs, target.col_adjs, target.data, cmbs);
+  std::vector<size_t> dep_row_idxs;
+  for (size_t i = 0; i < is_dep.size(); ++i) {
+    if (is_dep[i]) { dep_row_idxs.push_back(i); }
+  }
+  if (dep_row_idxs.empty()) { return; }
+
+  auto new_follower_rows = ApplySparLinCmbs(
+                               follower.row_adjs, follower.data, is_dep, cmbs);
+  SparOpReprMat new_follower(follower.rows, target.rows - dep_row_idxs.size());
+  for (size_t x = 0; x < new_follower_rows.size(); ++x) {
+    for (auto &y_elem : new_follower_rows[x]) {
+      if (y_elem.second != kNullOpRepr) {
+        new_follower.SetElem(x, y_elem.first, y_elem.second);
+      }
+    }
   }
+  follower = new_follower;
+  target.RemoveRows(dep_row_idxs);
 }
 
 
+// Remove all the linearly dependent columns of target in one scan and apply
+// the combined transform on the rows of follower.
 void SparOpReprMatColDelinearize(
     SparOpReprMat &target, SparOpReprMat &follower) {
-  auto col_num = target.cols;
-  size_t i;
-  for (i = 1; i < col_num; ++i) {
-    auto cmb = target.CalcColLinCmb(i);
-    if (CalcSparOpReprMatColLinCmb(target, cmb) == target.GetCol(i)) {
-      // Remove the col.
-      target.RemoveCol(i);
-      // Construct transform matrix.
-      SparCoefReprMat trans_mat(col_num-1, col_num);
-      for (size_t j = 0; j < i; ++j) {
-        trans_mat.SetElem(j, j, kIdCoefRepr);
-      }
-      for (size_t j = 0; j < i; ++j) {
-        trans_mat.SetElem(j, i, cmb[j]);
-      }
-      for (size_t j = i+1; j < col_num; ++j) {
-        trans_mat.SetElem(j-1, j, kIdCoefRepr);
+  assert(target.cols == follower.rows);
+  std::vector<SparLinCmb> cmbs;
+  auto is_dep = FindSparOpReprMatDepLines(
+                    target.col_adjs, target.row_adjs, target.data, cmbs);
+  std::vector<size_t> dep_col_idxs;
+  for (size_t i = 0; i < is_dep.size(); ++i) {
+    if (is_dep[i]) { dep_col_idxs.push_back(i); }
+  }
+  if (dep_col_idxs.empty()) { return; }
+
+  auto new_follower_cols = ApplySparLinCmbs(
+                               follower.col_adjs, follower.data, is_dep, cmbs);
+  SparOpReprMat new_follower(target.cols - dep_col_idxs.size(), follower.cols);
+  for (size_t y = 0; y < new_follower_cols.size(); ++y) {
+    for (auto &x_elem : new_follower_cols[y]) {
+      if (x_elem.second != kNullOpRepr) {
+        new_follower.SetElem(x_elem.first, y, x_elem.second);
       }
-      // Calculate new follower.
-      follower = SparCoefReprMatSparOpReprMatIncompleteMulti(
-                     trans_mat, follower);
-      break;
     }
   }
-  if (i < col_num) {
-    SparOpReprMatColDelinearize(target, follower);
-  }
+  follower = new_follower;
+  target.RemoveCols(dep_col_idxs);
 }
 
 
@@ -758,25 +923,7 @@ void SparOpReprMatColCompresser(
 
 
 // Helpers.
-template <typename T>
-bool ElemInVec(const T &e, const std::vector<T> &v, long &pos) {
-  for (size_t i = 0; i < v.size(); ++i) {
-    if (e == v[i]) {
-      pos = i;
-      return true;
-    }
-  }
-  pos = -1;
-  return false;
-}
-
-
-template <typename VecT>
-VecT ConcatenateTwoVec(const VecT &va, const VecT &vb) {
-  VecT res;
-  res.reserve(va.size() + vb.size());
-  res.insert(res.end(), va.begin(), va.end());
-  res.insert(res.end(), vb.begin(), vb.end());
-  return res;
+inline void HashCombine(size_t &seed, const size_t hash) {
+  seed ^= hash + 0x9e3779b97f4a7c15 + (seed << 6) + (seed >> 2);
 }
 #endif /* ifndef GQMPS2_ONE_DIM_TN_MPO_MPOGEN_COEF_OP_ALG_H */
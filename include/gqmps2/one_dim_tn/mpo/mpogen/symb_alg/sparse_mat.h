@@ -11,70 +11,113 @@
 
 #include <iostream>
 #include <vector>
+#include <algorithm>    // lower_bound, set_union, sort, swap
+#include <iterator>     // back_inserter
+#include <utility>      // move
 #include "assert.h"
 
 
+// Reference of a nonnull element in an adjacency list: the column (row) index
+// of the element in a row (column) list and the location of the element data.
+struct SparMatElemRef {
+  size_t idx;
+  size_t data_idx;
+};
+
+// Adjacency list of a row or a column, sorted by the index.
+using SparMatAdjList = std::vector<SparMatElemRef>;
+
+// First element whose index is not less than the given index.
+inline SparMatAdjList::const_iterator FindInSparMatAdjList(
+    const SparMatAdjList &adj, const size_t idx) {
+  return std::lower_bound(
+             adj.cbegin(), adj.cend(), idx,
+             [](const SparMatElemRef &ref, const size_t i) { return ref.idx < i; });
+}
+
+
+// Sparse matrix whose nonnull elements are reachable from both the row and the
+// column adjacency lists. All the operations cost O(nnz) at most.
 template <typename ElemType>
 class SparMat {
 public:
-  SparMat(void) : rows(0), cols(0), data(), indexes() {}
+  SparMat(void) : rows(0), cols(0), data(), row_adjs(), col_adjs() {}
 
   SparMat(const size_t row_num, const size_t col_num) :
       rows(row_num), cols(col_num),
-      data(), indexes(row_num*col_num, -1) {}
+      data(), row_adjs(row_num), col_adjs(col_num) {}
 
   SparMat(const SparMat<ElemType> &spar_mat) :
       rows(spar_mat.rows), cols(spar_mat.cols),
-      data(spar_mat.data), indexes(spar_mat.indexes) {}
+      data(spar_mat.data),
+      row_adjs(spar_mat.row_adjs), col_adjs(spar_mat.col_adjs) {}
 
   SparMat<ElemType> &operator=(const SparMat<ElemType> &spar_mat) {
     rows = spar_mat.rows;
     cols = spar_mat.cols;
     data = spar_mat.data;
-    indexes = spar_mat.indexes; 
+    row_adjs = spar_mat.row_adjs;
+    col_adjs = spar_mat.col_adjs;
     return *this;
   }
 
   // Element getter and setter.
   const ElemType &operator()(const size_t x, const size_t y) const {
-    auto offset = CalcOffset(x, y);
-    if (indexes[offset] == -1) {
-      return nullelem; 
+    auto &row_adj = row_adjs[x];
+    auto it = FindInAdjList_(row_adj, y);
+    if (it == row_adj.cend() || it->idx != y) {
+      return nullelem;
     } else {
-      return data[indexes[offset]];
+      return data[it->data_idx];
     }
   }
 
   void SetElem(const size_t x, const size_t y, const ElemType &elem) {
+    assert(x < rows && y < cols);
     if (elem == nullelem) { return; }
-    auto offset = CalcOffset(x, y);
-    if (indexes[offset] == -1) {
-      data.push_back(elem);
-      long idx = data.size() - 1;
-      indexes[offset] = idx;
-    } else {
-      data[indexes[offset]] = elem;
+    auto &row_adj = row_adjs[x];
+    auto row_it = FindInAdjList_(row_adj, y);
+    if (row_it != row_adj.end() && row_it->idx == y) {
+      data[row_it->data_idx] = elem;
+      return;
     }
+    data.push_back(elem);
+    size_t data_idx = data.size() - 1;
+    row_adj.insert(row_it, {y, data_idx});
+    auto &col_adj = col_adjs[y];
+    col_adj.insert(FindInAdjList_(col_adj, x), {x, data_idx});
+  }
+
+  // Nonnull elements of a row and a column.
+  const SparMatAdjList &GetRowAdj(const size_t row_idx) const {
+    assert(row_idx < rows);
+    return row_adjs[row_idx];
+  }
+
+  const SparMatAdjList &GetColAdj(const size_t col_idx) const {
+    assert(col_idx < cols);
+    return col_adjs[col_idx];
+  }
+
+  // Number of the nonnull elements.
+  size_t nnz(void) const {
+    size_t num = 0;
+    for (auto &row_adj : row_adjs) { num += row_adj.size(); }
+    return num;
   }
 
   // Get row and column.
   std::vector<ElemType> GetRow(const size_t row_idx) const {
     assert(row_idx < rows); 
-    std::vector<ElemType> row;
-    row.reserve(cols);
-    for (size_t y = 0; y < cols; ++y) {
-      row.push_back((*this)(row_idx, y));
-    }
+    std::vector<ElemType> row(cols, nullelem);
+    for (auto &ref : row_adjs[row_idx]) { row[ref.idx] = data[ref.data_idx]; }
     return row;
   }
   
   std::vector<ElemType> GetCol(const size_t col_idx) const {
     assert(col_idx < cols); 
-    std::vector<ElemType> col;
-    col.reserve(rows);
-    for (size_t x = 0; x < rows; ++x) {
-      col.push_back((*this)(x, col_idx));
-    }
+    std::vector<ElemType> col(rows, nullelem);
+    for (auto &ref : col_adjs[col_idx]) { col[ref.idx] = data[ref.data_idx]; }
     return col;
   }
 
@@ -89,9 +132,15 @@ public:
       return false;
     }
     for (size_t x = 0; x < rows; ++x) {
-      for (size_t y = 0; y < cols; ++y) {
-        if ((*this)(x, y) != rhs(x, y)) {
-          std::cout << "No same elem at (" << x << "," << y << ")" << std::endl;
+      for (auto &ref : row_adjs[x]) {
+        if (data[ref.data_idx] != rhs(x, ref.idx)) {
+          std::cout << "No same elem at (" << x << "," << ref.idx << ")" << std::endl;
+          return false;
+        }
+      }
+      for (auto &ref : rhs.row_adjs[x]) {
+        if ((*this)(x, ref.idx) != rhs.data[ref.data_idx]) {
+          std::cout << "No same elem at (" << x << "," << ref.idx << ")" << std::endl;
           return false;
         }
       }
@@ -106,20 +155,13 @@ public:
       *this = SparMat<ElemType>();
       return;
     }
-    auto new_rows = rows - 1;
-    auto new_size = new_rows * cols;
-    std::vector<long> new_indexes(new_size);
-    for (size_t x = 0; x < rows; ++x) {
-      for (size_t y = 0; y < cols; ++y) {
-        if (x < row_idx) {
-          new_indexes[CalcOffset(x, y)] = indexes[CalcOffset(x, y)];
-        } else if (x > row_idx) {
-          new_indexes[CalcOffset(x-1, y)] = indexes[CalcOffset(x, y)];
-        }
-      }
+    for (auto &ref : row_adjs[row_idx]) {
+      auto &col_adj = col_adjs[ref.idx];
+      col_adj.erase(FindInAdjList_(col_adj, row_idx));
     }
-    rows = new_rows;
-    indexes = new_indexes;
+    row_adjs.erase(row_adjs.begin() + row_idx);
+    for (auto &col_adj : col_adjs) { ShiftAdjListAfter_(col_adj, row_idx); }
+    rows -= 1;
   }
 
   void RemoveCol(const size_t col_idx) {
@@ -128,88 +170,169 @@ public:
       *this = SparMat<ElemType>();
       return;
     }
-    auto new_cols = cols - 1;
-    auto new_size = rows * new_cols;
-    std::vector<long> new_indexes(new_size);
-    for (size_t x = 0; x < rows; ++x) {
-      for (size_t y = 0; y < cols; ++y) {
-        if (y < col_idx) {
-          new_indexes[CalcOffset_(x, y, new_cols)] = indexes[CalcOffset(x, y)];
-        } else if (y > col_idx) {
-          new_indexes[CalcOffset_(x, y-1, new_cols)] =
-              indexes[CalcOffset(x, y)];
-        }
-      }
+    for (auto &ref : col_adjs[col_idx]) {
+      auto &row_adj = row_adjs[ref.idx];
+      row_adj.erase(FindInAdjList_(row_adj, col_idx));
+    }
+    col_adjs.erase(col_adjs.begin() + col_idx);
+    for (auto &row_adj : row_adjs) { ShiftAdjListAfter_(row_adj, col_idx); }
+    cols -= 1;
+  }
+
+  // Remove several rows and columns in one pass, the indexes must be in
+  // ascending order without duplicates.
+  void RemoveRows(const std::vector<size_t> &row_idxs) {
+    if (row_idxs.empty()) { return; }
+    if (row_idxs.size() == rows) {
+      *this = SparMat<ElemType>();
+      return;
+    }
+    RemoveAdjLists_(row_adjs, col_adjs, row_idxs);
+    rows -= row_idxs.size();
+  }
+
+  void RemoveCols(const std::vector<size_t> &col_idxs) {
+    if (col_idxs.empty()) { return; }
+    if (col_idxs.size() == cols) {
+      *this = SparMat<ElemType>();
+      return;
     }
-    cols = new_cols;
-    indexes = new_indexes;
+    RemoveAdjLists_(col_adjs, row_adjs, col_idxs);
+    cols -= col_idxs.size();
   }
 
   // Swap two rows and columns.
   void SwapTwoRows(const size_t row_idx1, const size_t row_idx2) {
     assert(row_idx1 < rows && row_idx2 < rows);
     if (row_idx1 == row_idx2) { return; }
-    for (size_t y = 0; y < cols; ++y) {
-      auto offset1 = CalcOffset(row_idx1, y);
-      auto offset2 = CalcOffset(row_idx2, y);
-      auto temp = indexes[offset1];
-      indexes[offset1] = indexes[offset2];
-      indexes[offset2] = temp;
-    }
+    SwapTwoAdjLists_(row_adjs, col_adjs, row_idx1, row_idx2);
   }
 
   void SwapTwoCols(const size_t col_idx1, const size_t col_idx2) {
     assert(col_idx1 < cols && col_idx2 < cols);
     if (col_idx1 == col_idx2) { return; }
-    for (size_t x = 0; x < rows; ++x) {
-      auto offset1 = CalcOffset(x, col_idx1);
-      auto offset2 = CalcOffset(x, col_idx2);
-      auto temp = indexes[offset1];
-      indexes[offset1] = indexes[offset2];
-      indexes[offset2] = temp;
-    }
+    SwapTwoAdjLists_(col_adjs, row_adjs, col_idx1, col_idx2);
   }
 
   // Transpose rows and columns.
   void TransposeRows(const std::vector<size_t> &transposed_row_idxs) {
     assert(transposed_row_idxs.size() == rows);
-    std::vector<long> new_indexes(indexes.size());
-    for (size_t i = 0; i < rows; ++i) {
-      auto transposed_row_idx = transposed_row_idxs[i];
-      for (size_t y = 0; y < cols; ++y) {
-        new_indexes[CalcOffset(i, y)] =
-            indexes[CalcOffset(transposed_row_idx, y)];
-      }
-    }
-    indexes = new_indexes;
+    TransposeAdjLists_(row_adjs, col_adjs, transposed_row_idxs);
   }
 
   void TransposeCols(const std::vector<size_t> &transposed_col_idxs) {
     assert(transposed_col_idxs.size() == cols);
-    std::vector<long> new_indexes(indexes.size());
-    for (size_t i = 0; i < cols; ++i) {
-      auto transposed_col_idx = transposed_col_idxs[i];
-      for (size_t x = 0; x < rows; ++x) {
-        new_indexes[CalcOffset(x, i)] =
-            indexes[CalcOffset(x, transposed_col_idx)];
-      }
-    }
-    indexes = new_indexes;
-  }
-  
-  size_t CalcOffset(const size_t x, const size_t y) const {
-    return x*cols + y;
+    TransposeAdjLists_(col_adjs, row_adjs, transposed_col_idxs);
   }
 
   size_t rows;
   size_t cols;
   std::vector<ElemType> data;
-  std::vector<long> indexes;
+  std::vector<SparMatAdjList> row_adjs;   ///< Nonnull elements of each row.
+  std::vector<SparMatAdjList> col_adjs;   ///< Nonnull elements of each column.
 
 private:
-  size_t CalcOffset_(
-      const size_t x, const size_t y, const size_t new_cols) const {
-    return x*new_cols + y; 
+  static SparMatAdjList::iterator FindInAdjList_(
+      SparMatAdjList &adj, const size_t idx) {
+    return std::lower_bound(
+               adj.begin(), adj.end(), idx,
+               [](const SparMatElemRef &ref, const size_t i) { return ref.idx < i; });
+  }
+
+  static SparMatAdjList::const_iterator FindInAdjList_(
+      const SparMatAdjList &adj, const size_t idx) {
+    return FindInSparMatAdjList(adj, idx);
+  }
+
+  // Move the elements after the removed index one step forward.
+  static void ShiftAdjListAfter_(SparMatAdjList &adj, const size_t removed_idx) {
+    for (auto it = FindInAdjList_(adj, removed_idx); it != adj.end(); ++it) {
+      it->idx -= 1;
+    }
+  }
+
+  // Drop the removed lists and their elements in the crossing lists, the
+  // remaining lists are relabeled in order.
+  static void RemoveAdjLists_(
+      std::vector<SparMatAdjList> &adjs,
+      std::vector<SparMatAdjList> &cross_adjs,
+      const std::vector<size_t> &removed_idxs) {
+    auto adj_num = adjs.size();
+    std::vector<bool> removed(adj_num, false);
+    for (size_t i = 0; i < removed_idxs.size(); ++i) {
+      assert(removed_idxs[i] < adj_num);
+      assert(i == 0 || removed_idxs[i-1] < removed_idxs[i]);
+      removed[removed_idxs[i]] = true;
+    }
+    std::vector<size_t> new_idxs(adj_num);
+    size_t new_adj_num = 0;
+    for (size_t i = 0; i < adj_num; ++i) {
+      new_idxs[i] = new_adj_num;
+      if (!removed[i]) {
+        if (new_adj_num != i) { adjs[new_adj_num] = std::move(adjs[i]); }
+        new_adj_num++;
+      }
+    }
+    adjs.resize(new_adj_num);
+    for (auto &cross_adj : cross_adjs) {
+      size_t kept_num = 0;
+      for (auto &ref : cross_adj) {
+        if (!removed[ref.idx]) {
+          cross_adj[kept_num] = {new_idxs[ref.idx], ref.data_idx};
+          kept_num++;
+        }
+      }
+      cross_adj.resize(kept_num);
+    }
+  }
+
+  // Swap two lists and relabel their elements in the crossing lists.
+  static void SwapTwoAdjLists_(
+      std::vector<SparMatAdjList> &adjs,
+      std::vector<SparMatAdjList> &cross_adjs,
+      const size_t idx1, const size_t idx2) {
+    std::swap(adjs[idx1], adjs[idx2]);
+    std::vector<size_t> cross_idxs1, cross_idxs2, touched_cross_idxs;
+    for (auto &ref : adjs[idx1]) { cross_idxs1.push_back(ref.idx); }
+    for (auto &ref : adjs[idx2]) { cross_idxs2.push_back(ref.idx); }
+    std::set_union(
+        cross_idxs1.begin(), cross_idxs1.end(),
+        cross_idxs2.begin(), cross_idxs2.end(),
+        std::back_inserter(touched_cross_idxs));
+    for (auto cross_idx : touched_cross_idxs) {
+      auto &cross_adj = cross_adjs[cross_idx];
+      for (auto &ref : cross_adj) {
+        if (ref.idx == idx1) {
+          ref.idx = idx2;
+        } else if (ref.idx == idx2) {
+          ref.idx = idx1;
+        }
+      }
+      std::sort(
+          cross_adj.begin(), cross_adj.end(),
+          [](const SparMatElemRef &a, const SparMatElemRef &b) {
+            return a.idx < b.idx;
+          });
+    }
+  }
+
+  // New list i is the old list transposed_idxs[i], the crossing lists are
+  // rebuilt in order.
+  static void TransposeAdjLists_(
+      std::vector<SparMatAdjList> &adjs,
+      std::vector<SparMatAdjList> &cross_adjs,
+      const std::vector<size_t> &transposed_idxs) {
+    std::vector<SparMatAdjList> new_adjs(adjs.size());
+    for (size_t i = 0; i < adjs.size(); ++i) {
+      new_adjs[i] = std::move(adjs[transposed_idxs[i]]);
+    }
+    adjs = std::move(new_adjs);
+    for (auto &cross_adj : cross_adjs) { cross_adj.clear(); }
+    for (size_t i = 0; i < adjs.size(); ++i) {
+      for (auto &ref : adjs[i]) {
+        cross_adjs[ref.idx].push_back({i, ref.data_idx});
+      }
+    }
   }
 
   static ElemType nullelem;
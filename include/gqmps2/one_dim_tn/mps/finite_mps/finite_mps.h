@@ -14,11 +14,14 @@
 #define GQMPS2_ONE_DIM_TN_MPS_FINITE_MPS_FINITE_MPS_H
 
 
-#include "gqmps2/one_dim_tn/mps/mps.h"    // MPS
-#include "gqten/gqten.h"                  // SVD, Contract
+#include "gqmps2/one_dim_tn/mps/mps.h"          // MPS
+#include "gqmps2/mock_gqten/ten_decomp.h"       // TruncDecompType, mock_gqten::TruncatedDecomp
+#include "gqten/gqten.h"                        // SVD, Contract
 
 #include <vector>     // vector
+#include <utility>    // move
 #include <iomanip>    // fix, scientific, setw
+#include <fstream>    // ifstream, ofstream
 
 #ifdef Release
   #define NDEBUG
@@ -33,6 +36,41 @@ using namespace gqten;
 const int kUncentralizedCenterIdx = -1;
 
 
+// Helpers
+inline std::string GenMPSCenterFileName(const std::string &mps_path) {
+  return mps_path + "/" + kMpsCenterFileName;
+}
+
+
+/**
+Record the center of a finite MPS in the MPS directory.
+
+@param mps_path Path to the MPS directory.
+@param center The center of the MPS.
+*/
+inline void DumpMPSCenter(const std::string &mps_path, const int center) {
+  std::ofstream ofs(GenMPSCenterFileName(mps_path));
+  ofs << center << std::endl;
+  ofs.close();
+}
+
+
+/**
+Read the center of a finite MPS recorded in the MPS directory.
+
+@param mps_path Path to the MPS directory.
+
+@return The center, or kUncentralizedCenterIdx if it is not recorded.
+*/
+inline int LoadMPSCenter(const std::string &mps_path) {
+  int center = kUncentralizedCenterIdx;
+  std::ifstream ifs(GenMPSCenterFileName(mps_path));
+  if (ifs) { ifs >> center; }
+  ifs.close();
+  return center;
+}
+
+
 /// Canonical type of a MPS local tensor.
 enum MPSTenCanoType {
   NONE,   ///< Not a canonical MPS tensor.
@@ -104,8 +142,54 @@ public:
     return DuoVector<LocalTenT>::operator()(idx);
   }
 
+  // HDD I/O
+  /**
+  Dump finite MPS, the local tensors and the center, to HDD.
+
+  @param mps_path Path to the MPS directory.
+  */
+  void Dump(const std::string &mps_path = kMpsPath) const {
+    MPS<TenElemT, QNT>::Dump(mps_path);
+    DumpMPSCenter(mps_path, center_);
+  }
+
+  /**
+  Dump finite MPS, the local tensors and the center, to HDD.
+
+  @param mps_path Path to the MPS directory.
+  @param release_mem Wheter release memory after dump.
+  */
+  void Dump(
+      const std::string &mps_path = kMpsPath,
+      const bool release_mem = false
+  ) {
+    MPS<TenElemT, QNT>::Dump(mps_path, release_mem);
+    DumpMPSCenter(mps_path, center_);
+  }
+
+  /**
+  Load finite MPS from HDD. The canonical types of the local tensors are
+  restored from the recorded center.
+
+  @param mps_path Path to the MPS directory.
+  */
+  void Load(const std::string &mps_path = kMpsPath) {
+    MPS<TenElemT, QNT>::Load(mps_path);
+    center_ = LoadMPSCenter(mps_path);
+    for (int i = 0; i < int(this->size()); ++i) {
+      if (center_ == kUncentralizedCenterIdx || i == center_) {
+        tens_cano_type_[i] = MPSTenCanoType::NONE;
+      } else if (i < center_) {
+        tens_cano_type_[i] = MPSTenCanoType::LEFT;
+      } else {
+        tens_cano_type_[i] = MPSTenCanoType::RIGHT;
+      }
+    }
+  }
+
   // MPS global operations.
   void Centralize(const int);
+  GQTensor<GQTEN_Double, QNT> MoveCenterRight(void);
 
   // Properties getter.
   /**
@@ -134,7 +218,7 @@ private:
   std::vector<MPSTenCanoType> tens_cano_type_;
 
   void LeftCanonicalize_(const size_t);
-  void LeftCanonicalizeTen_(const size_t);
+  void LeftCanonicalizeTen_(const size_t, GQTensor<GQTEN_Double, QNT> *ps = nullptr);
   void RightCanonicalize_(const size_t);
   void RightCanonicalizeTen_(const size_t);
 };
@@ -157,6 +241,23 @@ void FiniteMPS<TenElemT, QNT>::Centralize(const int target_center) {
 }
 
 
+/**
+Move the center of the finite MPS one site to the right.
+
+@return The singular values on the bond between the old and the new center.
+*/
+template <typename TenElemT, typename QNT>
+GQTensor<GQTEN_Double, QNT> FiniteMPS<TenElemT, QNT>::MoveCenterRight(void) {
+  assert(center_ != kUncentralizedCenterIdx);
+  assert(center_ < int(this->size()) - 1);
+  auto center = center_;
+  GQTensor<GQTEN_Double, QNT> s;
+  LeftCanonicalizeTen_(center, &s);   // The local tensor access resets the center.
+  center_ = center + 1;
+  return s;
+}
+
+
 template <typename TenElemT, typename QNT>
 void FiniteMPS<TenElemT, QNT>::LeftCanonicalize_(const size_t stop_idx) {
   size_t start_idx;
@@ -170,7 +271,10 @@ void FiniteMPS<TenElemT, QNT>::LeftCanonicalize_(const size_t stop_idx) {
 
 
 template <typename TenElemT, typename QNT>
-void FiniteMPS<TenElemT, QNT>::LeftCanonicalizeTen_(const size_t site_idx) {
+void FiniteMPS<TenElemT, QNT>::LeftCanonicalizeTen_(
+    const size_t site_idx,
+    GQTensor<GQTEN_Double, QNT> *ps
+) {
   assert(site_idx < this->size() - 1);
   size_t ldims;
   if (site_idx == 0) {
@@ -194,6 +298,7 @@ void FiniteMPS<TenElemT, QNT>::LeftCanonicalizeTen_(const size_t site_idx) {
 
   tens_cano_type_[site_idx] = MPSTenCanoType::LEFT;
   tens_cano_type_[site_idx + 1] = MPSTenCanoType::NONE;
+  if (ps != nullptr) { *ps = std::move(s); }
 }
 
 
@@ -252,13 +357,17 @@ tensor generated from each SVD step will be normalized.
 @param mps To-be truncated finite MPS.
 @param trunc_err The target truncation error.
 @param Dmin The 
+@param decomp_type Backend of the truncated decomposition.
+@param thread_num Number of threads used to decompose the quantum number blocks.
 */
 template <typename TenElemT, typename QNT>
 void TruncateMPS(
     FiniteMPS<TenElemT, QNT> &mps,
     const GQTEN_Double trunc_err,
     const size_t Dmin,
-    const size_t Dmax
+    const size_t Dmax,
+    const TruncDecompType decomp_type = FULL_SVD,
+    const size_t thread_num = 1
 ) {
   auto mps_size = mps.size();
   assert(mps_size >= 2);
@@ -279,11 +388,20 @@ void TruncateMPS(
     GQTensor<GQTEN_Double, QNT> s;
     LocalTenT vt;
     auto pu = new LocalTenT;
-    SVD(
-        mps(i),
-        ldims, Div(mps[i]), trunc_err, Dmin, Dmax,
-        pu, &s, &vt, &actual_trunc_err, &D
-    );
+    if (decomp_type == FULL_SVD && thread_num <= 1) {
+      SVD(
+          mps(i),
+          ldims, Div(mps[i]), trunc_err, Dmin, Dmax,
+          pu, &s, &vt, &actual_trunc_err, &D
+      );
+    } else {
+      mock_gqten::TruncatedDecomp(
+          mps(i),
+          ldims, Div(mps[i]), trunc_err, Dmin, Dmax,
+          pu, &s, &vt, &actual_trunc_err, &D,
+          decomp_type, thread_num
+      );
+    }
     std::cout << "Truncate MPS bond " << std::setw(4) << i
               << " TruncErr = " << std::setprecision(2) << std::scientific << actual_trunc_err << std::fixed
               << " D = " << std::setw(5) << D;
@@ -0,0 +1,297 @@
+// SPDX-License-Identifier: LGPL-3.0-only
+
+/*
+* Author: Rongyang Sun <sun-rongyang@outlook.com>
+* Creation Date: 2020-10-23 15:06
+*
+* Description: GraceQ/MPS2 project. Out-of-core measurements of the finite MPS
+*              which lives on the disk.
+*/
+
+/**
+@file finite_mps_disk_measu.h
+@brief Out-of-core measurements of the finite MPS which lives on the disk.
+*/
+#ifndef GQMPS2_ONE_DIM_TN_MPS_FINITE_MPS_FINITE_MPS_DISK_MEASU_H
+#define GQMPS2_ONE_DIM_TN_MPS_FINITE_MPS_FINITE_MPS_DISK_MEASU_H
+
+
+#include "gqmps2/one_dim_tn/mps/finite_mps/finite_mps.h"          // FiniteMPS
+#include "gqmps2/one_dim_tn/mps/finite_mps/finite_mps_measu.h"    // MeasuRes, MeasureHeadGroupFromEnv
+#include "gqmps2/consts.h"                                        // kMpsPath
+#include "gqten/gqten.h"
+
+#include <iostream>     // cout, endl
+#include <string>       // string
+#include <vector>       // vector
+#include <future>       // async, future
+#include <fstream>      // ifstream
+#include <assert.h>     // assert
+
+
+namespace gqmps2 {
+using namespace gqten;
+
+
+/**
+Stream the local tensors of a finite MPS from the disk. At most the required
+tensor and the prefetched next one are held in the memory; the next tensor is
+read in the background while the required one is contracted. The next tensor is
+the one on the right, or on the left for a backward streamer.
+*/
+template <typename TenElemT, typename QNT>
+class MPSTenStreamer {
+public:
+  using Tensor = GQTensor<TenElemT, QNT>;
+
+  MPSTenStreamer(
+      FiniteMPS<TenElemT, QNT> &mps,
+      const std::string &mps_path,
+      const bool backward = false
+  ) : mps_(mps), mps_path_(mps_path), backward_(backward),
+      prefetch_site_(kNoPrefetch_) {}
+
+  MPSTenStreamer(const MPSTenStreamer &) = delete;
+  MPSTenStreamer &operator=(const MPSTenStreamer &) = delete;
+
+  ~MPSTenStreamer(void) {
+    DropPrefetch_();
+    mps_.clear();
+  }
+
+  /**
+  Make sure the local tensor on the site is in the memory and start to prefetch
+  the tensor on the next site.
+  */
+  const Tensor &Require(const size_t site) {
+    if (IsNotLoaded_(site)) {
+      if (prefetch_site_ == site) {
+        mps_(site) = prefetch_ten_.get();
+        prefetch_site_ = kNoPrefetch_;
+      } else {
+        mps_(site) = LoadTen_(site);
+      }
+    }
+    auto next_site = backward_ ? site - 1 : site + 1;   // Wraps around at the left end.
+    if (
+        next_site < mps_.size() &&
+        IsNotLoaded_(next_site) &&
+        prefetch_site_ != next_site
+    ) {
+      DropPrefetch_();
+      prefetch_site_ = next_site;
+      prefetch_ten_ = std::async(
+                          std::launch::async,
+                          &MPSTenStreamer::LoadTen_, this, next_site
+                      );
+    }
+    return mps_[site];
+  }
+
+  /// Release the memory of the local tensor on the site.
+  void Release(const size_t site) { mps_.dealloc(site); }
+
+private:
+  static const size_t kNoPrefetch_ = size_t(-1);
+
+  FiniteMPS<TenElemT, QNT> &mps_;
+  std::string mps_path_;
+  bool backward_;
+  size_t prefetch_site_;
+  std::future<Tensor *> prefetch_ten_;
+
+  bool IsNotLoaded_(const size_t site) const {
+    const FiniteMPS<TenElemT, QNT> &cmps = mps_;
+    return cmps(site) == nullptr;
+  }
+
+  Tensor *LoadTen_(const size_t site) const {
+    auto pten = new Tensor;
+    std::ifstream ifs(GenMPSTenName(mps_path_, site), std::ifstream::binary);
+    ifs >> *pten;
+    ifs.close();
+    return pten;
+  }
+
+  void DropPrefetch_(void) {
+    if (prefetch_site_ != kNoPrefetch_) {
+      delete prefetch_ten_.get();
+      prefetch_site_ = kNoPrefetch_;
+    }
+  }
+};
+
+
+/**
+Measure operator strings on a finite MPS which lives on the disk. The measure
+events are grouped by their head sites. One identity left environment is
+carried from the left end to the right; each group starts its transfer tensor
+from it and reuses the transfer tensor while the operator strings share their
+leading operators.
+
+Each group streams the sites from its head to the largest tail of its events,
+and again from the head for an event whose operators differ from the previous
+one before its tail. A tensor is thus loaded once per group which covers it;
+measuring all the pairs of N sites costs about \f$N^2/2\f$ tensor loads, i.e.
+N/2 passes over the MPS on the disk. The loads are prefetched in the background
+and overlap with the contractions. If the MPS fits in the memory, load it and
+use the in-memory measurements instead.
+
+@note The MPS on the disk must be right canonical from site 1 to the end, which
+      is the case after a TwoSiteFiniteVMPS run. The center recorded by
+      FiniteMPS::Dump or TwoSiteFiniteVMPS is checked.
+*/
+template <typename TenElemT, typename QNT>
+MeasuRes<TenElemT> MeasureOpsVecsOnDisk_(
+    FiniteMPS<TenElemT, QNT> &mps,
+    const std::string &mps_path,
+    const std::vector<std::vector<size_t>> &sites_set,
+    const OpsVecGen<TenElemT, QNT> &gen_ops
+) {
+  using Tensor = GQTensor<TenElemT, QNT>;
+  assert(mps.empty());
+  auto center = LoadMPSCenter(mps_path);
+  if (center != 0) {
+    std::cout << "The MPS in " << mps_path << " has center " << center
+              << ", it must be right canonical from site 1 (center 0)."
+              << std::endl;
+    exit(1);
+  }
+  const FiniteMPS<TenElemT, QNT> &cmps = mps;
+  auto id_op_set = cmps.GetSitesInfo().id_ops;
+  MeasuRes<TenElemT> measu_res(sites_set.size());
+  MPSTenStreamer<TenElemT, QNT> streamer(mps, mps_path);
+
+  Tensor *penv = nullptr;     // Left environment of the sites [0, env_site).
+  size_t env_site = 0;
+  for (auto &event_group : GroupMeasuEventsByHead(sites_set)) {
+    auto head_site = sites_set[event_group.front()].front();
+    while (env_site < head_site) {
+      streamer.Require(env_site);
+      if (env_site == 0) {
+        penv = CtrctHeadTen(cmps, 0, id_op_set[0]);
+      } else {
+        CtrctIdMidTen(cmps, env_site, penv);
+      }
+      streamer.Release(env_site);
+      env_site++;
+    }
+
+    MeasureHeadGroupFromEnv(
+        cmps, penv, event_group, sites_set, gen_ops, measu_res,
+        [&streamer](const size_t site) { streamer.Require(site); },
+        [&streamer](const size_t site) { streamer.Release(site); }
+    );
+  }
+  delete penv;
+  return measu_res;
+}
+
+
+/**
+Measure a single one-site operator on each sites of a finite MPS which lives on
+the disk. Only a few local tensors are loaded into the memory at the same time.
+
+@param mps The empty finite MPS which defines the sites information.
+@param op The single one-site operator.
+@param mps_path The directory of the MPS local tensors, the MPS must be right
+       canonical from site 1 to the end.
+@param res_file_basename The basename of the output file.
+@param res_format Output format of the measurement results.
+*/
+template <typename TenElemT, typename QNT>
+MeasuRes<TenElemT> MeasureOneSiteOpOnDisk(
+    FiniteMPS<TenElemT, QNT> &mps,
+    const GQTensor<TenElemT, QNT> &op,
+    const std::string &mps_path,
+    const std::string &res_file_basename,
+    const MeasuResFormat res_format = MEASU_RES_JSON
+) {
+  std::vector<std::vector<size_t>> sites_set;
+  for (size_t i = 0; i < mps.size(); ++i) { sites_set.push_back({i}); }
+  auto measu_res = MeasureOpsVecsOnDisk_<TenElemT, QNT>(
+                       mps, mps_path, sites_set,
+                       [&op](const size_t) {
+                         return std::vector<GQTensor<TenElemT, QNT>>({op});
+                       }
+                   );
+  DumpMeasuRes(measu_res, res_file_basename, res_format);
+  return measu_res;
+}
+
+
+/**
+Measure a two-site operator whose insert operators are the same on a finite
+MPS which lives on the disk, see MeasureTwoSiteOp.
+
+@param mps The empty finite MPS which defines the sites information.
+@param phys_ops Physical operators \f$A\f$ and \f$B\f$.
+@param inst_op Insert operator \f$ O \f$.
+@param sites_set The indexes of the two physical operators with ascending order
+       for each measure event.
+@param mps_path The directory of the MPS local tensors, the MPS must be right
+       canonical from site 1 to the end.
+@param res_file_basename The basename of the output file.
+@param res_format Output format of the measurement results.
+*/
+template <typename TenElemT, typename QNT>
+MeasuRes<TenElemT> MeasureTwoSiteOpOnDisk(
+    FiniteMPS<TenElemT, QNT> &mps,
+    const std::vector<GQTensor<TenElemT, QNT>> &phys_ops,
+    const GQTensor<TenElemT, QNT> &inst_op,
+    const std::vector<std::vector<size_t>> &sites_set,
+    const std::string &mps_path,
+    const std::string &res_file_basename,
+    const MeasuResFormat res_format = MEASU_RES_JSON
+) {
+  assert(phys_ops.size() == 2);
+  std::vector<GQTensor<TenElemT, QNT>> inst_ops = {inst_op};
+  auto measu_res = MeasureOpsVecsOnDisk_<TenElemT, QNT>(
+                       mps, mps_path, sites_set,
+                       [&phys_ops, &inst_ops, &sites_set](const size_t i) {
+                         assert(sites_set[i].size() == 2);
+                         return GenOpsVec(phys_ops, inst_ops, sites_set[i]);
+                       }
+                   );
+  DumpMeasuRes(measu_res, res_file_basename, res_format);
+  return measu_res;
+}
+
+
+/**
+Measure a multi-site operator on a finite MPS which lives on the disk, see
+MeasureMultiSiteOp.
+
+@param mps The empty finite MPS which defines the sites information.
+@param phys_ops_set Physical operators for each measure events.
+@param inst_ops_set_set Insert operators for each measure event.
+@param sites_set The indexes of the physical operators with ascending order
+       for each measure event.
+@param mps_path The directory of the MPS local tensors, the MPS must be right
+       canonical from site 1 to the end.
+@param res_file_basename The basename of the output file.
+@param res_format Output format of the measurement results.
+*/
+template <typename TenElemT, typename QNT>
+MeasuRes<TenElemT> MeasureMultiSiteOpOnDisk(
+    FiniteMPS<TenElemT, QNT> &mps,
+    const TenVV<TenElemT, QNT> &phys_ops_set,
+    const TenVVV<TenElemT, QNT> &inst_ops_set_set,
+    const std::vector<std::vector<size_t>> &sites_set,
+    const std::string &mps_path,
+    const std::string &res_file_basename,
+    const MeasuResFormat res_format = MEASU_RES_JSON
+) {
+  assert(phys_ops_set.size() == sites_set.size());
+  assert(inst_ops_set_set.size() == sites_set.size());
+  auto measu_res = MeasureOpsVecsOnDisk_<TenElemT, QNT>(
+                       mps, mps_path, sites_set,
+                       [&phys_ops_set, &inst_ops_set_set](const size_t i) {
+                         return GenOpsVec(phys_ops_set[i], inst_ops_set_set[i]);
+                       }
+                   );
+  DumpMeasuRes(measu_res, res_file_basename, res_format);
+  return measu_res;
+}
+} /* gqmps2 */
+#endif /* ifndef GQMPS2_ONE_DIM_TN_MPS_FINITE_MPS_FINITE_MPS_DISK_MEASU_H */
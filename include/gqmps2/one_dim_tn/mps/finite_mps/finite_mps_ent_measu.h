@@ -0,0 +1,223 @@
+// SPDX-License-Identifier: LGPL-3.0-only
+
+/*
+* Author: Rongyang Sun <sun-rongyang@outlook.com>
+* Creation Date: 2020-10-24 09:37
+*
+* Description: GraceQ/MPS2 project. Entanglement measurements of the finite MPS.
+*/
+
+/**
+@file finite_mps_ent_measu.h
+@brief Entanglement measurements of the finite MPS.
+*/
+#ifndef GQMPS2_ONE_DIM_TN_MPS_FINITE_MPS_FINITE_MPS_ENT_MEASU_H
+#define GQMPS2_ONE_DIM_TN_MPS_FINITE_MPS_FINITE_MPS_ENT_MEASU_H
+
+
+#include "gqmps2/one_dim_tn/mps/finite_mps/finite_mps.h"    // FiniteMPS
+#include "gqten/gqten.h"
+
+#include <string>       // string
+#include <vector>       // vector
+#include <fstream>      // ofstream
+#include <sstream>      // ostringstream, istringstream
+#include <iomanip>      // setw, setprecision
+#include <cmath>        // log, pow, sqrt
+#include <algorithm>    // find_if, sort
+#include <functional>   // greater
+#include <assert.h>     // assert
+
+
+namespace gqmps2 {
+using namespace gqten;
+
+
+/**
+Singular values in a quantum number sector of a bond.
+
+@tparam QNT Quantum number type.
+*/
+template <typename QNT>
+struct EntSpecSector {
+  QNT qn;                             ///< Quantum number of the bond sector.
+  std::vector<GQTEN_Double> svs;      ///< Normalized singular values, descending order.
+};
+
+
+/**
+Entanglement of a bond of the finite MPS.
+
+@tparam QNT Quantum number type.
+*/
+template <typename QNT>
+struct BondEnt {
+  size_t bond;                          ///< The bond between site bond and site bond + 1.
+  GQTEN_Double ee;                      ///< Von Neumann entanglement entropy.
+  std::vector<GQTEN_Double> renyi_ees;  ///< Renyi entropies of the given orders.
+  std::vector<EntSpecSector<QNT>> spec; ///< Quantum number resolved entanglement spectrum.
+};
+
+template <typename QNT>
+using EntProfile = std::vector<BondEnt<QNT>>;
+
+
+template <typename QNT>
+BondEnt<QNT> CalcBondEnt(
+    const GQTensor<GQTEN_Double, QNT> &,
+    const size_t,
+    const std::vector<GQTEN_Double> &
+);
+
+template <typename QNT>
+void DumpEntProfile(const EntProfile<QNT> &, const std::string &);
+
+
+/**
+Measure the entanglement entropy, the Renyi entropies and the quantum number
+resolved entanglement spectrum of every bond of the finite MPS. The MPS is
+centralized to the left end and the center is moved to the right end site by
+site; the singular values of each step are the Schmidt values of the bond, so
+one canonicalization sweep measures all the bonds. The center of the MPS is at
+the right end after the measurement.
+
+@param mps To-be-measured MPS.
+@param renyi_orders Orders \f$n\f$ of the Renyi entropies
+       \f$S_{n} = \frac{1}{1 - n}\ln\sum_{i}p_{i}^{n}\f$, \f$n > 0\f$ and
+       \f$n \neq 1\f$.
+@param res_file_basename The basename of the output file.
+*/
+template <typename TenElemT, typename QNT>
+EntProfile<QNT> MeasureEntanglementProfile(
+    FiniteMPS<TenElemT, QNT> &mps,
+    const std::vector<GQTEN_Double> &renyi_orders,
+    const std::string &res_file_basename
+) {
+  auto N = mps.size();
+  assert(N >= 2);
+  EntProfile<QNT> ent_profile;
+  mps.Centralize(0);
+  for (size_t i = 0; i < N - 1; ++i) {
+    auto s = mps.MoveCenterRight();
+    ent_profile.push_back(CalcBondEnt(s, i, renyi_orders));
+  }
+  DumpEntProfile(ent_profile, res_file_basename);
+  return ent_profile;
+}
+
+
+/**
+Calculate the entanglement of a bond from its singular values.
+
+@param s The diagonal singular value tensor of the bond.
+@param bond The bond index.
+@param renyi_orders Orders of the Renyi entropies.
+*/
+template <typename QNT>
+BondEnt<QNT> CalcBondEnt(
+    const GQTensor<GQTEN_Double, QNT> &s,
+    const size_t bond,
+    const std::vector<GQTEN_Double> &renyi_orders
+) {
+  auto bond_idx = s.GetIndexes()[0];
+  auto sdim = bond_idx.dim();
+  GQTEN_Double norm2 = 0;
+  for (size_t i = 0; i < sdim; ++i) { norm2 += std::pow(s(i, i), 2.0); }
+
+  BondEnt<QNT> bond_ent;
+  bond_ent.bond = bond;
+  bond_ent.ee = 0;
+  bond_ent.renyi_ees = std::vector<GQTEN_Double>(renyi_orders.size(), 0);
+  for (size_t i = 0; i < sdim; ++i) {
+    auto sv = s(i, i) / std::sqrt(norm2);
+    auto p = sv * sv;
+    if (p > 0) { bond_ent.ee += (-p * std::log(p)); }
+    for (size_t k = 0; k < renyi_orders.size(); ++k) {
+      bond_ent.renyi_ees[k] += std::pow(p, renyi_orders[k]);
+    }
+
+    auto qn = bond_idx.GetQNSctFromActualCoor(i).GetQn();
+    auto it = std::find_if(
+                  bond_ent.spec.begin(), bond_ent.spec.end(),
+                  [&qn](const EntSpecSector<QNT> &sct) { return sct.qn == qn; }
+              );
+    if (it == bond_ent.spec.end()) {
+      bond_ent.spec.push_back({qn, {}});
+      it = bond_ent.spec.end() - 1;
+    }
+    it->svs.push_back(sv);
+  }
+  for (size_t k = 0; k < renyi_orders.size(); ++k) {
+    auto n = renyi_orders[k];
+    assert(n > 0 && n != 1);
+    bond_ent.renyi_ees[k] = std::log(bond_ent.renyi_ees[k]) / (1 - n);
+  }
+  for (auto &sct : bond_ent.spec) {
+    std::sort(sct.svs.begin(), sct.svs.end(), std::greater<GQTEN_Double>());
+  }
+  return bond_ent;
+}
+
+
+// Write the quantum number as a JSON array of the values of its stream output.
+template <typename QNT>
+void DumpQNJson_(std::ofstream &ofs, const QNT &qn) {
+  std::ostringstream oss;
+  oss << qn;
+  std::istringstream iss(oss.str());
+  std::string val;
+  ofs << "[";
+  for (size_t k = 0; iss >> val; ++k) {
+    if (k != 0) { ofs << ", "; }
+    ofs << val;
+  }
+  ofs << "]";
+}
+
+
+/**
+Dump the entanglement profile to a JSON file. Each bond is dumped as
+[bond, ee, [renyi_ees], [[qn, [singular values]], ...]], one [qn, [singular
+values]] pair per quantum number sector of the bond. The quantum number is
+written as the array of the values of its stream output.
+*/
+template <typename QNT>
+void DumpEntProfile(
+    const EntProfile<QNT> &ent_profile,
+    const std::string &basename
+) {
+  auto file = basename + ".json";
+  std::ofstream ofs(file);
+  ofs << std::setprecision(12);
+  ofs << "[\n";
+  for (auto it = ent_profile.begin(); it != ent_profile.end(); ++it) {
+    ofs << "  [" << it->bond << ", " << std::setw(14) << it->ee << ", [";
+    for (size_t k = 0; k < it->renyi_ees.size(); ++k) {
+      if (k != 0) { ofs << ", "; }
+      ofs << it->renyi_ees[k];
+    }
+    ofs << "], [";
+    for (size_t q = 0; q < it->spec.size(); ++q) {
+      if (q != 0) { ofs << ", "; }
+      ofs << "[";
+      DumpQNJson_(ofs, it->spec[q].qn);
+      ofs << ", [";
+      auto &svs = it->spec[q].svs;
+      for (size_t k = 0; k < svs.size(); ++k) {
+        if (k != 0) { ofs << ", "; }
+        ofs << svs[k];
+      }
+      ofs << "]]";
+    }
+    ofs << "]";
+    if (it == ent_profile.end() - 1) {
+      ofs << "]\n";
+    } else {
+      ofs << "],\n";
+    }
+  }
+  ofs << "]";
+  ofs.close();
+}
+} /* gqmps2 */
+#endif /* ifndef GQMPS2_ONE_DIM_TN_MPS_FINITE_MPS_FINITE_MPS_ENT_MEASU_H */
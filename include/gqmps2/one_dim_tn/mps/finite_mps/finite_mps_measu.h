@@ -16,12 +16,21 @@
 
 
 #include "gqmps2/one_dim_tn/mps/finite_mps/finite_mps.h"    // FiniteMPS
+#include "gqmps2/mock_gqten/ten_decomp.h"                   // ParallelFor
+#include "gqmps2/one_dim_tn/mpo/mpogen/mpogen.h"            // GQTensorContentHash
 #include "gqten/gqten.h"
+#include "mkl.h"      // mkl_set_num_threads_local
 
 #include <string>
 #include <fstream>
+#include <iostream>
 #include <iomanip>
 #include <algorithm>
+#include <functional>
+#include <unordered_map>
+#include <cstring>
+#include <cstdint>
+#include <cstdlib>
 
 
 namespace gqmps2 {
@@ -34,6 +43,17 @@ using TenVV = std::vector<std::vector<GQTensor<TenElemT, QNT>>>;
 template <typename TenElemT, typename QNT>
 using TenVVV = std::vector<std::vector<std::vector<GQTensor<TenElemT, QNT>>>>;
 
+/// Output format of the measurement results.
+enum MeasuResFormat {
+  MEASU_RES_JSON,     ///< JSON text, readable and suitable for small outputs.
+  MEASU_RES_BINARY    ///< Compact binary columns, see DumpMeasuResBinary.
+};
+
+
+/// Generator of the operator string of the i-th measure event.
+template <typename TenElemT, typename QNT>
+using OpsVecGen = std::function<std::vector<GQTensor<TenElemT, QNT>>(const size_t)>;
+
 
 /**
 Measurement result for a set specific operator(s).
@@ -82,6 +102,19 @@ MeasuResElem<TenElemT> MultiSiteOpAvg(
     const std::vector<size_t> &
 );
 
+template <typename TenElemT, typename QNT>
+std::vector<GQTensor<TenElemT, QNT>> GenOpsVec(
+    const std::vector<GQTensor<TenElemT, QNT>> &,
+    const TenVV<TenElemT, QNT> &
+);
+
+template <typename TenElemT, typename QNT>
+std::vector<GQTensor<TenElemT, QNT>> GenOpsVec(
+    const std::vector<GQTensor<TenElemT, QNT>> &,
+    const std::vector<GQTensor<TenElemT, QNT>> &,
+    const std::vector<size_t> &
+);
+
 template <typename TenElemT, typename QNT>
 TenElemT OpsVecAvg(
     const FiniteMPS<TenElemT, QNT> &,
@@ -90,6 +123,18 @@ TenElemT OpsVecAvg(
     const size_t
 );
 
+template <typename TenElemT, typename QNT>
+GQTensor<TenElemT, QNT> *CtrctHeadTen(
+    const FiniteMPS<TenElemT, QNT> &, const size_t,
+    const GQTensor<TenElemT, QNT> &
+);
+
+template <typename TenElemT, typename QNT>
+TenElemT CtrctTailTen(
+    const FiniteMPS<TenElemT, QNT> &, const size_t,
+    const GQTensor<TenElemT, QNT> &, const GQTensor<TenElemT, QNT> &
+);
+
 template <typename TenElemT, typename QNT>
 void CtrctMidTen(
     const FiniteMPS<TenElemT, QNT> &, const size_t,
@@ -97,8 +142,27 @@ void CtrctMidTen(
     GQTensor<TenElemT, QNT> * &
 );
 
+template <typename TenElemT, typename QNT>
+void CtrctIdMidTen(
+    const FiniteMPS<TenElemT, QNT> &, const size_t,
+    GQTensor<TenElemT, QNT> * &
+);
+
+template <typename TenElemT, typename QNT>
+void CtrctOpMidTen(
+    const FiniteMPS<TenElemT, QNT> &, const size_t,
+    const GQTensor<TenElemT, QNT> &,
+    GQTensor<TenElemT, QNT> * &
+);
+
+template <typename AvgT>
+void DumpMeasuRes(
+    const MeasuRes<AvgT> &, const std::string &,
+    const MeasuResFormat res_format = MEASU_RES_JSON
+);
+
 template <typename AvgT>
-void DumpMeasuRes(const MeasuRes<AvgT> &, const std::string &);
+void DumpMeasuResBinary(const MeasuRes<AvgT> &, const std::string &);
 
 
 // Helpers.
@@ -112,6 +176,33 @@ inline bool IsOrderKept(const std::vector<size_t> &sites) {
 }
 
 
+// Group the measure events by their head sites. The groups are ordered by the
+// head site and the events in each group are stably ordered by the tail site.
+inline std::vector<std::vector<size_t>> GroupMeasuEventsByHead(
+    const std::vector<std::vector<size_t>> &sites_set
+) {
+  std::vector<size_t> event_idxs(sites_set.size());
+  for (size_t i = 0; i < sites_set.size(); ++i) { event_idxs[i] = i; }
+  std::stable_sort(
+      event_idxs.begin(), event_idxs.end(),
+      [&sites_set](const size_t a, const size_t b) {
+        if (sites_set[a].front() != sites_set[b].front()) {
+          return sites_set[a].front() < sites_set[b].front();
+        }
+        return sites_set[a].back() < sites_set[b].back();
+      }
+  );
+  std::vector<std::vector<size_t>> groups;
+  for (auto i : event_idxs) {
+    if (groups.empty() || sites_set[groups.back().front()].front() != sites_set[i].front()) {
+      groups.push_back({});
+    }
+    groups.back().push_back(i);
+  }
+  return groups;
+}
+
+
 inline void DumpSites(std::ofstream &ofs, const std::vector<size_t> &sites) {
   ofs << "[";
   for (auto it = sites.begin(); it != sites.end()-1; ++it) {
@@ -136,6 +227,332 @@ inline void DumpAvgVal(std::ofstream &ofs, const GQTEN_Complex avg) {
 }
 
 
+/**
+Incremental measurement engine for the operator strings which start at the same
+head site. It keeps one left transfer tensor which has absorbed the leading
+operators of the last measured string. A new operator string only pays for the
+sites beyond the common leading part, so all the
+\f$\langle A_{i} O_{i+1} \cdots O_{j-1} B_{j} \rangle\f$ with a fixed
+\f$i\f$ are read off in a single pass when they are measured with ascending
+\f$j\f$.
+
+Each operator is labeled once when a string is measured: identity operators get
+kIdOpLabel and the others the index of the first equal operator met by the
+engine. The common leading part is then found by comparing labels, and the
+identity operators are transferred without contracting the operator. Because
+the MPS is right canonical on the right of the head site, the identity
+operators behind the last non-identity operator of a string are not contracted
+at all.
+
+@tparam TenElemT Type of the tensor element, real or complex.
+@tparam QNT Quantum number type.
+*/
+template <typename TenElemT, typename QNT>
+class OpsVecAvgEngine {
+public:
+  using Tensor = GQTensor<TenElemT, QNT>;
+
+  /**
+  Create the engine.
+
+  @param mps The MPS which has been centralized to the head site, or which is
+         right canonical from the head site when penv is given.
+  @param head_site The head site of all the operator strings.
+  @param penv The identity left environment of the sites before the head site,
+         optional. The engine does not own it.
+  @param require_ten Called before a local tensor is used, optional.
+  @param release_ten Called after a local tensor beyond the head site is used,
+         optional.
+  */
+  OpsVecAvgEngine(
+      const FiniteMPS<TenElemT, QNT> &mps,
+      const size_t head_site,
+      const Tensor *penv = nullptr,
+      const std::function<void(const size_t)> &require_ten = nullptr,
+      const std::function<void(const size_t)> &release_ten = nullptr
+  ) : mps_(mps), head_site_(head_site), penv_(penv),
+      id_op_set_(mps.GetSitesInfo().id_ops),
+      require_ten_(require_ten), release_ten_(release_ten) {}
+
+  OpsVecAvgEngine(const OpsVecAvgEngine &) = delete;
+  OpsVecAvgEngine &operator=(const OpsVecAvgEngine &) = delete;
+
+  ~OpsVecAvgEngine(void) { delete ptransfer_ten_; }
+
+  /**
+  Average of an operator string which starts at the head site.
+
+  @param ops Operators on the sites head_site, head_site + 1, ....
+  */
+  TenElemT Avg(const std::vector<Tensor> &ops) {
+    assert(!ops.empty());
+    auto labels = LabelOps_(ops);
+    // Identity operators on the tail are traced out by the right canonical MPS.
+    auto ops_size = labels.size();
+    while (ops_size > 1 && labels[ops_size - 1] == kIdOpLabel) { ops_size--; }
+
+    if (ops_size == 1) {
+      Require_(head_site_);
+      if (penv_ == nullptr) {
+        return OneSiteOpAvg(mps_[head_site_], ops[0], head_site_, mps_.size()).avg;
+      } else {
+        return CtrctTailTen(mps_, head_site_, ops[0], *penv_);
+      }
+    }
+
+    if (!IsTransferTenReusable_(labels, ops_size)) {
+      delete ptransfer_ten_;
+      Require_(head_site_);
+      if (penv_ == nullptr) {
+        ptransfer_ten_ = CtrctHeadTen(mps_, head_site_, ops[0]);
+      } else {
+        ptransfer_ten_ = new Tensor(*penv_);
+        CtrctMidTen_(head_site_, ops[0], labels[0]);
+      }
+      absorbed_labels_ = {labels[0]};
+    }
+    for (size_t k = absorbed_labels_.size(); k < ops_size - 1; ++k) {
+      auto site = head_site_ + k;
+      Require_(site);
+      CtrctMidTen_(site, ops[k], labels[k]);
+      Release_(site);
+      absorbed_labels_.push_back(labels[k]);
+    }
+    auto tail_site = head_site_ + ops_size - 1;
+    Require_(tail_site);
+    auto avg = CtrctTailTen(mps_, tail_site, ops[ops_size - 1], *ptransfer_ten_);
+    Release_(tail_site);
+    return avg;
+  }
+
+private:
+  static const long kIdOpLabel = -1;
+
+  const FiniteMPS<TenElemT, QNT> &mps_;
+  size_t head_site_;
+  const Tensor *penv_;
+  const std::vector<Tensor> &id_op_set_;
+  std::function<void(const size_t)> require_ten_;
+  std::function<void(const size_t)> release_ten_;
+  std::vector<Tensor> labeled_ops_;       ///< Distinct non-identity operators met by the engine.
+  std::unordered_multimap<size_t, long> label_hash_map_;   ///< Content hash to labels.
+  std::unordered_map<size_t, size_t> id_op_hashes_;         ///< Content hashes of the identity operators on the sites.
+  std::vector<long> absorbed_labels_;     ///< Labels of the operators absorbed in the transfer tensor.
+  Tensor *ptransfer_ten_ = nullptr;
+
+  // Each operator is hashed once; the operators are only compared when their
+  // hashes are equal.
+  std::vector<long> LabelOps_(const std::vector<Tensor> &ops) {
+    GQTensorContentHash<TenElemT, QNT> hasher;
+    std::vector<long> labels(ops.size());
+    for (size_t k = 0; k < ops.size(); ++k) {
+      auto site = head_site_ + k;
+      auto hash = hasher(ops[k]);
+      if (hash == IdOpHash_(site) && ops[k] == id_op_set_[site]) {
+        labels[k] = kIdOpLabel;
+        continue;
+      }
+      auto range = label_hash_map_.equal_range(hash);
+      auto it = std::find_if(
+                    range.first, range.second,
+                    [this, &ops, k](const std::pair<const size_t, long> &hash_label) {
+                      return labeled_ops_[hash_label.second] == ops[k];
+                    }
+                );
+      if (it != range.second) {
+        labels[k] = it->second;
+      } else {
+        labels[k] = labeled_ops_.size();
+        labeled_ops_.push_back(ops[k]);
+        label_hash_map_.emplace(hash, labels[k]);
+      }
+    }
+    return labels;
+  }
+
+  size_t IdOpHash_(const size_t site) {
+    auto it = id_op_hashes_.find(site);
+    if (it != id_op_hashes_.end()) { return it->second; }
+    auto hash = GQTensorContentHash<TenElemT, QNT>()(id_op_set_[site]);
+    id_op_hashes_.emplace(site, hash);
+    return hash;
+  }
+
+  bool IsTransferTenReusable_(
+      const std::vector<long> &labels, const size_t ops_size
+  ) const {
+    if (ptransfer_ten_ == nullptr) { return false; }
+    if (absorbed_labels_.size() > ops_size - 1) { return false; }
+    return std::equal(
+               absorbed_labels_.begin(), absorbed_labels_.end(),
+               labels.begin()
+           );
+  }
+
+  void CtrctMidTen_(const size_t site, const Tensor &op, const long label) {
+    if (label == kIdOpLabel) {
+      CtrctIdMidTen(mps_, site, ptransfer_ten_);
+    } else {
+      CtrctOpMidTen(mps_, site, op, ptransfer_ten_);
+    }
+  }
+
+  void Require_(const size_t site) const {
+    if (require_ten_) { require_ten_(site); }
+  }
+
+  void Release_(const size_t site) const {
+    if (release_ten_ && site != head_site_) { release_ten_(site); }
+  }
+};
+
+
+/**
+Measure a group of measure events with the same head site from the identity
+left environment of the head site. The sites on the right of the head site
+must be right canonical. The MPS is only read, so different groups can be
+measured concurrently.
+
+@param mps The MPS whose local tensors from the head site to the tails of the
+       events are available (after require_ten is called).
+@param penv The left environment of the sites before the head site, nullptr
+       when the head site is the left end.
+@param event_group Indexes of the measure events, ascending tail sites.
+@param sites_set Sites of all the measure events.
+@param gen_ops Operator string generator of the measure events.
+@param measu_res The measurement results of the events in the group are set.
+@param require_ten Called before a local tensor is used, optional.
+@param release_ten Called after a local tensor beyond the head site is used,
+       optional.
+*/
+template <typename TenElemT, typename QNT>
+void MeasureHeadGroupFromEnv(
+    const FiniteMPS<TenElemT, QNT> &mps,
+    const GQTensor<TenElemT, QNT> *penv,
+    const std::vector<size_t> &event_group,
+    const std::vector<std::vector<size_t>> &sites_set,
+    const OpsVecGen<TenElemT, QNT> &gen_ops,
+    MeasuRes<TenElemT> &measu_res,
+    const std::function<void(const size_t)> &require_ten = nullptr,
+    const std::function<void(const size_t)> &release_ten = nullptr
+) {
+  auto head_site = sites_set[event_group.front()].front();
+  assert((head_site == 0) == (penv == nullptr));
+  OpsVecAvgEngine<TenElemT, QNT> engine(
+      mps, head_site, penv, require_ten, release_ten
+  );
+  for (auto i : event_group) {
+    auto &sites = sites_set[i];
+    assert(IsOrderKept(sites));
+    measu_res[i] = MeasuResElem<TenElemT>(sites, engine.Avg(gen_ops(i)));
+  }
+}
+
+
+/**
+Measure the operator strings of the measure events concurrently. The MPS is
+centralized to the left end once and the head site groups are split into
+contiguous chunks of about the same cost, one for each worker thread. The
+identity left environment is carried from the left end to the head of each
+chunk and copied once for the worker, which then carries its own copy through
+the heads of its chunk; so at most thread_num environments are alive. The
+workers run MKL with a single thread to avoid oversubscription.
+
+@param mps To-be-measured MPS.
+@param sites_set Sites of the measure events.
+@param gen_ops Operator string generator of the measure events.
+@param thread_num Number of the worker threads.
+*/
+template <typename TenElemT, typename QNT>
+MeasuRes<TenElemT> MeasureOpsVecsParallel(
+    FiniteMPS<TenElemT, QNT> &mps,
+    const std::vector<std::vector<size_t>> &sites_set,
+    const OpsVecGen<TenElemT, QNT> &gen_ops,
+    const size_t thread_num
+) {
+  using Tensor = GQTensor<TenElemT, QNT>;
+  mps.Centralize(0);
+  const FiniteMPS<TenElemT, QNT> &cmps = mps;
+  const auto &id_op_set = cmps.GetSitesInfo().id_ops;
+  auto event_groups = GroupMeasuEventsByHead(sites_set);
+  auto group_num = event_groups.size();
+  auto head_site = [&](const size_t g) {
+    return sites_set[event_groups[g].front()].front();
+  };
+
+  // Split the groups by the number of the sites they transfer through.
+  std::vector<size_t> group_costs(group_num, 0);
+  size_t total_cost = 0;
+  for (size_t g = 0; g < group_num; ++g) {
+    for (auto i : event_groups[g]) {
+      group_costs[g] += sites_set[i].back() - head_site(g) + 1;
+    }
+    total_cost += group_costs[g];
+  }
+  auto chunk_num = std::max(size_t(1), std::min(group_num, thread_num));
+  std::vector<size_t> chunk_begins = {0};
+  size_t acc_cost = 0;
+  for (size_t g = 0; g < group_num; ++g) {
+    auto chunk = chunk_begins.size();
+    if (
+        chunk < chunk_num &&
+        g > chunk_begins.back() &&
+        acc_cost * chunk_num >= total_cost * chunk
+    ) {
+      chunk_begins.push_back(g);
+    }
+    acc_cost += group_costs[g];
+  }
+  chunk_num = chunk_begins.size();
+  chunk_begins.push_back(group_num);
+
+  // Moves the identity left environment of the sites [0, env_site) to the head
+  // site of a group.
+  auto move_env = [&cmps, &id_op_set](
+      Tensor *&penv, size_t &env_site, const size_t site
+  ) {
+    while (env_site < site) {
+      if (env_site == 0) {
+        penv = CtrctHeadTen(cmps, 0, id_op_set[0]);
+      } else {
+        CtrctIdMidTen(cmps, env_site, penv);
+      }
+      env_site++;
+    }
+  };
+
+  // Identity left environments of the heads of the chunks.
+  std::vector<Tensor *> chunk_penvs(chunk_num, nullptr);
+  Tensor *penv = nullptr;
+  size_t env_site = 0;
+  for (size_t c = 0; c < chunk_num; ++c) {
+    if (group_num == 0) { break; }
+    move_env(penv, env_site, head_site(chunk_begins[c]));
+    if (penv != nullptr) { chunk_penvs[c] = new Tensor(*penv); }
+  }
+  delete penv;
+
+  MeasuRes<TenElemT> measu_res(sites_set.size());
+  mock_gqten::ParallelFor(
+      chunk_num, chunk_num,
+      [&](const size_t c) {
+        if (chunk_num > 1) { mkl_set_num_threads_local(1); }
+        Tensor *pchunk_env = chunk_penvs[c];
+        size_t chunk_env_site = (group_num == 0) ? 0 : head_site(chunk_begins[c]);
+        for (size_t g = chunk_begins[c]; g < chunk_begins[c+1]; ++g) {
+          move_env(pchunk_env, chunk_env_site, head_site(g));
+          MeasureHeadGroupFromEnv(
+              cmps, pchunk_env, event_groups[g], sites_set, gen_ops, measu_res
+          );
+        }
+        delete pchunk_env;
+        if (chunk_num > 1) { mkl_set_num_threads_local(0); }
+      }
+  );
+  return measu_res;
+}
+
+
 // Measure one-site operator.
 /**
 Measure a single one-site operator on each sites of the finite MPS.
@@ -308,14 +725,17 @@ MeasuRes<TenElemT> MeasureMultiSiteOp(
 ) {
   auto measu_event_num = sites_set.size();
   MeasuRes<TenElemT> measu_res(measu_event_num);
-  for (size_t i = 0; i < measu_event_num; ++i) {
-    auto &phys_ops = phys_ops_set[i];
-    auto &inst_ops_set = inst_ops_set_set[i];
-    auto &sites = sites_set[i];
-    assert(sites.size() > 1);
-    assert(IsOrderKept(sites));
-    mps.Centralize(sites[0]);
-    measu_res[i] = MultiSiteOpAvg(mps, phys_ops, inst_ops_set, sites);
+  for (auto &event_group : GroupMeasuEventsByHead(sites_set)) {
+    auto head_site = sites_set[event_group.front()].front();
+    mps.Centralize(head_site);
+    OpsVecAvgEngine<TenElemT, QNT> engine(mps, head_site);
+    for (auto i : event_group) {
+      auto &sites = sites_set[i];
+      assert(sites.size() > 1);
+      assert(IsOrderKept(sites));
+      auto ops = GenOpsVec(phys_ops_set[i], inst_ops_set_set[i]);
+      measu_res[i] = MeasuResElem<TenElemT>(sites, engine.Avg(ops));
+    }
   }
   DumpMeasuRes(measu_res, res_file_basename);
   return measu_res;
@@ -349,20 +769,168 @@ MeasuRes<TenElemT> MeasureMultiSiteOp(
 ) {
   auto measu_event_num = sites_set.size();
   MeasuRes<TenElemT> measu_res(measu_event_num);
-  for (std::size_t i = 0; i < measu_event_num; ++i) {
-    auto &phys_ops = phys_ops_set[i];
-    auto &inst_ops = inst_ops_set[i];
-    auto &sites = sites_set[i];
-    assert(sites.size() > 1);
-    assert(IsOrderKept(sites));
-    mps.Centralize(sites[0]);
-    measu_res[i] = MultiSiteOpAvg(mps, phys_ops, inst_ops, sites);
+  for (auto &event_group : GroupMeasuEventsByHead(sites_set)) {
+    auto head_site = sites_set[event_group.front()].front();
+    mps.Centralize(head_site);
+    OpsVecAvgEngine<TenElemT, QNT> engine(mps, head_site);
+    for (auto i : event_group) {
+      auto &sites = sites_set[i];
+      assert(sites.size() > 1);
+      assert(IsOrderKept(sites));
+      auto ops = GenOpsVec(phys_ops_set[i], inst_ops_set[i], sites);
+      measu_res[i] = MeasuResElem<TenElemT>(sites, engine.Avg(ops));
+    }
   }
   DumpMeasuRes(measu_res, res_file_basename);
   return measu_res;
 }
 
 
+// Thread-parallel measurements.
+/**
+Measure a list of one-site operators on each sites of the finite MPS with
+several threads.
+
+@param thread_num Number of the worker threads.
+@param res_format Output format of the measurement results.
+
+@see MeasureOneSiteOp(FiniteMPS<TenElemT, QNT> &, const std::vector<GQTensor<TenElemT, QNT>> &, const std::vector<std::string> &)
+*/
+template <typename TenElemT, typename QNT>
+MeasuResSet<TenElemT> MeasureOneSiteOp(
+    FiniteMPS<TenElemT, QNT> &mps,
+    const std::vector<GQTensor<TenElemT, QNT>> &ops,
+    const std::vector<std::string> &res_file_basenames,
+    const size_t thread_num,
+    const MeasuResFormat res_format = MEASU_RES_JSON
+) {
+  auto op_num = ops.size();
+  assert(op_num == res_file_basenames.size());
+  auto N = mps.size();
+  std::vector<std::vector<size_t>> sites_set;
+  for (size_t j = 0; j < op_num; ++j) {
+    for (size_t i = 0; i < N; ++i) { sites_set.push_back({i}); }
+  }
+  auto measu_res = MeasureOpsVecsParallel<TenElemT, QNT>(
+                       mps, sites_set,
+                       [&ops, N](const size_t e) {
+                         return std::vector<GQTensor<TenElemT, QNT>>({ops[e / N]});
+                       },
+                       thread_num
+                   );
+  MeasuResSet<TenElemT> measu_res_set(op_num);
+  for (size_t j = 0; j < op_num; ++j) {
+    measu_res_set[j] = MeasuRes<TenElemT>(
+                           measu_res.begin() + j * N,
+                           measu_res.begin() + (j + 1) * N
+                       );
+    DumpMeasuRes(measu_res_set[j], res_file_basenames[j], res_format);
+  }
+  return measu_res_set;
+}
+
+
+/**
+Measure a two-site operator whose insert operators are the same with several
+threads.
+
+@param thread_num Number of the worker threads.
+@param res_format Output format of the measurement results.
+
+@see MeasureTwoSiteOp(FiniteMPS<TenElemT, QNT> &, const std::vector<GQTensor<TenElemT, QNT>> &, const GQTensor<TenElemT, QNT> &, const std::vector<std::vector<size_t>> &, const std::string &)
+*/
+template <typename TenElemT, typename QNT>
+MeasuRes<TenElemT> MeasureTwoSiteOp(
+    FiniteMPS<TenElemT, QNT> &mps,
+    const std::vector<GQTensor<TenElemT, QNT>> &phys_ops,
+    const GQTensor<TenElemT, QNT> &inst_op,
+    const std::vector<std::vector<size_t>> &sites_set,
+    const std::string &res_file_basename,
+    const size_t thread_num,
+    const MeasuResFormat res_format = MEASU_RES_JSON
+) {
+  assert(phys_ops.size() == 2);
+  auto measu_event_num = sites_set.size();
+  TenVV<TenElemT, QNT> phys_ops_set(measu_event_num, phys_ops);
+  TenVV<TenElemT, QNT> inst_ops_set(measu_event_num, {inst_op});
+  return MeasureMultiSiteOp(
+      mps,
+      phys_ops_set,
+      inst_ops_set,
+      sites_set,
+      res_file_basename,
+      thread_num,
+      res_format
+  );
+}
+
+
+/**
+Measure a multi-site operator with several threads.
+
+@param thread_num Number of the worker threads.
+@param res_format Output format of the measurement results.
+
+@see MeasureMultiSiteOp(FiniteMPS<TenElemT, QNT> &, const TenVV<TenElemT, QNT> &, const TenVVV<TenElemT, QNT> &, const std::vector<std::vector<size_t>> &, const std::string &)
+*/
+template <typename TenElemT, typename QNT>
+MeasuRes<TenElemT> MeasureMultiSiteOp(
+    FiniteMPS<TenElemT, QNT> &mps,
+    const TenVV<TenElemT, QNT> &phys_ops_set,
+    const TenVVV<TenElemT, QNT> &inst_ops_set_set,
+    const std::vector<std::vector<size_t>> &sites_set,
+    const std::string &res_file_basename,
+    const size_t thread_num,
+    const MeasuResFormat res_format = MEASU_RES_JSON
+) {
+  assert(phys_ops_set.size() == sites_set.size());
+  assert(inst_ops_set_set.size() == sites_set.size());
+  auto measu_res = MeasureOpsVecsParallel<TenElemT, QNT>(
+                       mps, sites_set,
+                       [&phys_ops_set, &inst_ops_set_set](const size_t i) {
+                         return GenOpsVec(phys_ops_set[i], inst_ops_set_set[i]);
+                       },
+                       thread_num
+                   );
+  DumpMeasuRes(measu_res, res_file_basename, res_format);
+  return measu_res;
+}
+
+
+/**
+Measure a multi-site operator whose insert operators between two given physical
+operators are the same with several threads.
+
+@param thread_num Number of the worker threads.
+@param res_format Output format of the measurement results.
+
+@see MeasureMultiSiteOp(FiniteMPS<TenElemT, QNT> &, const TenVV<TenElemT, QNT> &, const TenVV<TenElemT, QNT> &, const std::vector<std::vector<size_t>> &, const std::string &)
+*/
+template <typename TenElemT, typename QNT>
+MeasuRes<TenElemT> MeasureMultiSiteOp(
+    FiniteMPS<TenElemT, QNT> &mps,
+    const TenVV<TenElemT, QNT> &phys_ops_set,
+    const TenVV<TenElemT, QNT> &inst_ops_set,
+    const std::vector<std::vector<size_t>> &sites_set,
+    const std::string &res_file_basename,
+    const size_t thread_num,
+    const MeasuResFormat res_format = MEASU_RES_JSON
+) {
+  assert(phys_ops_set.size() == sites_set.size());
+  assert(inst_ops_set.size() == sites_set.size());
+  auto measu_res = MeasureOpsVecsParallel<TenElemT, QNT>(
+                       mps, sites_set,
+                       [&phys_ops_set, &inst_ops_set, &sites_set](const size_t i) {
+                         assert(sites_set[i].size() > 1);
+                         return GenOpsVec(phys_ops_set[i], inst_ops_set[i], sites_set[i]);
+                       },
+                       thread_num
+                   );
+  DumpMeasuRes(measu_res, res_file_basename, res_format);
+  return measu_res;
+}
+
+
 // Averages.
 template <typename TenElemT, typename QNT>
 MeasuResElem<TenElemT> OneSiteOpAvg(
@@ -402,12 +970,17 @@ MeasuResElem<TenElemT> OneSiteOpAvg(
 }
 
 
+/**
+Generate the operator string from the head site to the tail site of a measure
+event.
+
+@param phys_ops Physical operators.
+@param inst_ops_set Insert operators between (and after) the physical operators.
+*/
 template <typename TenElemT, typename QNT>
-MeasuResElem<TenElemT> MultiSiteOpAvg(
-    const FiniteMPS<TenElemT, QNT> &mps,
+std::vector<GQTensor<TenElemT, QNT>> GenOpsVec(
     const std::vector<GQTensor<TenElemT, QNT>> &phys_ops,
-    const TenVV<TenElemT, QNT> &inst_ops_set,
-    const std::vector<size_t> &sites
+    const TenVV<TenElemT, QNT> &inst_ops_set
 ) {
   auto inst_ops_num = inst_ops_set.size();
   auto phys_op_num = phys_ops.size();
@@ -428,17 +1001,20 @@ MeasuResElem<TenElemT> MultiSiteOpAvg(
       ops.push_back(tail_inst_op);
     }
   }
-  auto head_site = sites.front();
-  auto tail_site = head_site + ops.size() - 1;
-  auto avg = OpsVecAvg(mps, ops, head_site, tail_site);
-
-  return MeasuResElem<TenElemT>(sites, avg);
+  return ops;
 }
 
 
+/**
+Generate the operator string from the head site to the tail site of a measure
+event whose insert operators between two physical operators are the same.
+
+@param phys_ops Physical operators.
+@param inst_ops Insert operator between each two neighboring physical operators.
+@param sites Sites of the physical operators.
+*/
 template <typename TenElemT, typename QNT>
-MeasuResElem<TenElemT> MultiSiteOpAvg(
-    FiniteMPS<TenElemT, QNT> &mps,
+std::vector<GQTensor<TenElemT, QNT>> GenOpsVec(
     const std::vector<GQTensor<TenElemT, QNT>> &phys_ops,
     const std::vector<GQTensor<TenElemT, QNT>> &inst_ops,
     const std::vector<size_t> &sites
@@ -455,8 +1031,39 @@ MeasuResElem<TenElemT> MultiSiteOpAvg(
         )
     );
   }
+  return GenOpsVec(phys_ops, inst_ops_set);
+}
 
-  return MultiSiteOpAvg(mps, phys_ops, inst_ops_set, sites);
+
+template <typename TenElemT, typename QNT>
+MeasuResElem<TenElemT> MultiSiteOpAvg(
+    const FiniteMPS<TenElemT, QNT> &mps,
+    const std::vector<GQTensor<TenElemT, QNT>> &phys_ops,
+    const TenVV<TenElemT, QNT> &inst_ops_set,
+    const std::vector<size_t> &sites
+) {
+  auto ops = GenOpsVec(phys_ops, inst_ops_set);
+  auto head_site = sites.front();
+  auto tail_site = head_site + ops.size() - 1;
+  auto avg = OpsVecAvg(mps, ops, head_site, tail_site);
+
+  return MeasuResElem<TenElemT>(sites, avg);
+}
+
+
+template <typename TenElemT, typename QNT>
+MeasuResElem<TenElemT> MultiSiteOpAvg(
+    FiniteMPS<TenElemT, QNT> &mps,
+    const std::vector<GQTensor<TenElemT, QNT>> &phys_ops,
+    const std::vector<GQTensor<TenElemT, QNT>> &inst_ops,
+    const std::vector<size_t> &sites
+) {
+  auto ops = GenOpsVec(phys_ops, inst_ops, sites);
+  auto head_site = sites.front();
+  auto tail_site = head_site + ops.size() - 1;
+  auto avg = OpsVecAvg(mps, ops, head_site, tail_site);
+
+  return MeasuResElem<TenElemT>(sites, avg);
 }
 
 
@@ -467,8 +1074,22 @@ TenElemT OpsVecAvg(
     const size_t head_site,
     const size_t tail_site
 ) {
-  auto id_op_set = mps.GetSitesInfo().id_ops;
-  // Deal with head tensor.
+  assert(ops.size() == (tail_site - head_site + 1));
+  OpsVecAvgEngine<TenElemT, QNT> engine(mps, head_site);
+  return engine.Avg(ops);
+}
+
+
+/**
+Contract the head MPS tensor, its conjugate and the operator on it to a new
+left transfer tensor. The caller owns the returned tensor.
+*/
+template <typename TenElemT, typename QNT>
+GQTensor<TenElemT, QNT> *CtrctHeadTen(
+    const FiniteMPS<TenElemT, QNT> &mps,      // Has been centralized to head_site
+    const size_t head_site,
+    const GQTensor<TenElemT, QNT> &op
+) {
   std::vector<size_t> head_mps_ten_ctrct_axes1;
   std::vector<size_t> head_mps_ten_ctrct_axes2;
   std::vector<size_t> head_mps_ten_ctrct_axes3;
@@ -484,7 +1105,7 @@ TenElemT OpsVecAvg(
   GQTensor<TenElemT, QNT> temp_ten0;
   auto ptemp_ten = new GQTensor<TenElemT, QNT>;
   Contract(
-      &mps[head_site], &ops[0],
+      &mps[head_site], &op,
       {head_mps_ten_ctrct_axes1, {0}},
       &temp_ten0
   );
@@ -494,14 +1115,21 @@ TenElemT OpsVecAvg(
       {head_mps_ten_ctrct_axes2, head_mps_ten_ctrct_axes3},
       ptemp_ten
   );
+  return ptemp_ten;
+}
 
-  // Deal with middle tensors.
-  assert(ops.size() == (tail_site - head_site + 1));
-  for (size_t i = head_site + 1; i < tail_site; ++i) {
-    CtrctMidTen(mps, i, ops[i - head_site], id_op_set[i], ptemp_ten);
-  }
 
-  // Deal with tail tensor.
+/**
+Close a left transfer tensor with the tail MPS tensor, its conjugate and the
+operator on it. The transfer tensor is kept unchanged.
+*/
+template <typename TenElemT, typename QNT>
+TenElemT CtrctTailTen(
+    const FiniteMPS<TenElemT, QNT> &mps,
+    const size_t tail_site,
+    const GQTensor<TenElemT, QNT> &op,
+    const GQTensor<TenElemT, QNT> &transfer_ten
+) {
   std::vector<size_t> tail_mps_ten_ctrct_axes1;
   std::vector<size_t> tail_mps_ten_ctrct_axes2;
   if (tail_site == mps.size()-1) {
@@ -512,10 +1140,9 @@ TenElemT OpsVecAvg(
     tail_mps_ten_ctrct_axes2 = {2, 0, 1};
   }
   GQTensor<TenElemT, QNT> temp_ten2, temp_ten3, res_ten;
-  Contract(&mps[tail_site], ptemp_ten, {{0}, {0}}, &temp_ten2);
-  delete ptemp_ten;
-  Contract(&temp_ten2, &ops.back(), {{0}, {0}}, &temp_ten3);
-  mps_ten_dag = std::move(Dag(mps[tail_site]));
+  Contract(&mps[tail_site], &transfer_ten, {{0}, {0}}, &temp_ten2);
+  Contract(&temp_ten2, &op, {{0}, {0}}, &temp_ten3);
+  auto mps_ten_dag = Dag(mps[tail_site]);
   Contract(
       &temp_ten3, &mps_ten_dag,
       {tail_mps_ten_ctrct_axes1, tail_mps_ten_ctrct_axes2},
@@ -533,32 +1160,66 @@ void CtrctMidTen(
     const GQTensor<TenElemT, QNT> &op,
     const GQTensor<TenElemT, QNT> &id_op,
     GQTensor<TenElemT, QNT> * &t) {
-  using Tensor = GQTensor<TenElemT, QNT>;
   if (op == id_op) {
-    Tensor temp_ten;
-    Contract(&mps[site], t, {{0}, {0}}, &temp_ten);
-    delete t;
-    t = new Tensor;
-    auto mps_ten_dag = Dag(mps[site]);
-    Contract(&temp_ten, &mps_ten_dag, {{0, 2}, {1, 0}}, t);
+    CtrctIdMidTen(mps, site, t);
   } else {
-    Tensor temp_ten1, temp_ten2;
-    Contract(&mps[site], t, {{0}, {0}}, &temp_ten1);
-    delete t;
-    Contract(&temp_ten1, &op, {{0}, {0}}, &temp_ten2);
-    t = new Tensor;
-    auto mps_ten_dag = Dag(mps[site]);
-    Contract(&temp_ten2, &mps_ten_dag, {{1, 2}, {0, 1}}, t);
+    CtrctOpMidTen(mps, site, op, t);
   }
 }
 
 
+/**
+Transfer the left transfer tensor through a middle site with the identity
+operator, which is not contracted.
+*/
+template <typename TenElemT, typename QNT>
+void CtrctIdMidTen(
+    const FiniteMPS<TenElemT, QNT> &mps,
+    const size_t site,
+    GQTensor<TenElemT, QNT> * &t) {
+  using Tensor = GQTensor<TenElemT, QNT>;
+  Tensor temp_ten;
+  Contract(&mps[site], t, {{0}, {0}}, &temp_ten);
+  delete t;
+  t = new Tensor;
+  auto mps_ten_dag = Dag(mps[site]);
+  Contract(&temp_ten, &mps_ten_dag, {{0, 2}, {1, 0}}, t);
+}
+
+
+/// Transfer the left transfer tensor through a middle site with an operator.
+template <typename TenElemT, typename QNT>
+void CtrctOpMidTen(
+    const FiniteMPS<TenElemT, QNT> &mps,
+    const size_t site,
+    const GQTensor<TenElemT, QNT> &op,
+    GQTensor<TenElemT, QNT> * &t) {
+  using Tensor = GQTensor<TenElemT, QNT>;
+  Tensor temp_ten1, temp_ten2;
+  Contract(&mps[site], t, {{0}, {0}}, &temp_ten1);
+  delete t;
+  Contract(&temp_ten1, &op, {{0}, {0}}, &temp_ten2);
+  t = new Tensor;
+  auto mps_ten_dag = Dag(mps[site]);
+  Contract(&temp_ten2, &mps_ten_dag, {{1, 2}, {0, 1}}, t);
+}
+
+
 // Date dump.
+/**
+Dump the measurement results to basename.json or, for the binary format, to
+basename.gqmr.
+*/
 template <typename AvgT>
 void DumpMeasuRes(
     const MeasuRes<AvgT> &res,
-    const std::string &basename
+    const std::string &basename,
+    const MeasuResFormat res_format
 ) {
+  if (res_format == MEASU_RES_BINARY) {
+    DumpMeasuResBinary(res, basename);
+    return;
+  }
   auto file = basename + ".json";
   std::ofstream ofs(file);
 
@@ -582,5 +1243,164 @@ void DumpMeasuRes(
 
   ofs.close();
 }
+
+
+// Binary dump.
+const char kMeasuResBinMagic[4] = {'G', 'Q', 'M', 'R'};
+const uint32_t kMeasuResBinVersion = 1;
+
+
+inline void AppendVarUint(std::string &buf, uint64_t v) {
+  while (v >= 0x80) {
+    buf.push_back(char((v & 0x7F) | 0x80));
+    v >>= 7;
+  }
+  buf.push_back(char(v));
+}
+
+
+inline uint64_t ReadVarUint(std::istream &is) {
+  uint64_t v = 0;
+  for (size_t shift = 0; shift < 64; shift += 7) {
+    auto byte = is.get();
+    if (byte == std::char_traits<char>::eof()) {
+      std::cout << "Unexpected end of the binary measurement result file!" << std::endl;
+      exit(1);
+    }
+    v |= uint64_t(byte & 0x7F) << shift;
+    if ((byte & 0x80) == 0) { break; }
+  }
+  return v;
+}
+
+
+// Zigzag encoding maps the signed differences to small unsigned integers.
+inline uint64_t ZigzagEncode(const int64_t v) {
+  return (uint64_t(v) << 1) ^ uint64_t(v >> 63);
+}
+
+
+inline int64_t ZigzagDecode(const uint64_t v) {
+  return int64_t(v >> 1) ^ -int64_t(v & 1);
+}
+
+
+template <typename T>
+inline void AppendRaw(std::string &buf, const T &v) {
+  char bytes[sizeof(T)];
+  std::memcpy(bytes, &v, sizeof(T));
+  buf.append(bytes, sizeof(T));
+}
+
+
+template <typename T>
+inline T ReadRaw(std::istream &is) {
+  T v;
+  is.read(reinterpret_cast<char *>(&v), sizeof(T));
+  return v;
+}
+
+
+inline uint8_t MeasuResAvgTypeTag(const GQTEN_Double) { return 0; }
+inline uint8_t MeasuResAvgTypeTag(const GQTEN_Complex) { return 1; }
+
+
+/**
+Dump the measurement results to basename.gqmr in a compact binary columnar
+format, which is much smaller and faster to write and read than the JSON text
+for large outputs, for example, the all-pairs correlation functions. The file
+contains (integers and doubles in the native byte order):
+
+1. The magic "GQMR", the uint32 version, the uint8 type tag of the average
+   (0 for real, 1 for complex) and the uint64 number of the measure events;
+2. The column of the numbers of sites of the events, as varints;
+3. The column of the sites. The first site of each event is stored as the
+   zigzag varint of its difference to the first site of the previous event and
+   the others as the zigzag varints of their differences to the previous site
+   in the event;
+4. The column of the averages as raw doubles (the real and the imaginary parts
+   for the complex case).
+
+@see LoadMeasuResBinary
+*/
+template <typename AvgT>
+void DumpMeasuResBinary(
+    const MeasuRes<AvgT> &res,
+    const std::string &basename
+) {
+  std::string buf(kMeasuResBinMagic, 4);
+  AppendRaw(buf, kMeasuResBinVersion);
+  AppendRaw(buf, MeasuResAvgTypeTag(AvgT()));
+  AppendRaw(buf, uint64_t(res.size()));
+  for (auto &measu_res_elem : res) {
+    AppendVarUint(buf, measu_res_elem.sites.size());
+  }
+  int64_t prev_head_site = 0;
+  for (auto &measu_res_elem : res) {
+    auto &sites = measu_res_elem.sites;
+    if (sites.empty()) { continue; }
+    AppendVarUint(buf, ZigzagEncode(int64_t(sites[0]) - prev_head_site));
+    prev_head_site = sites[0];
+    for (size_t i = 1; i < sites.size(); ++i) {
+      AppendVarUint(buf, ZigzagEncode(int64_t(sites[i]) - int64_t(sites[i-1])));
+    }
+  }
+  for (auto &measu_res_elem : res) { AppendRaw(buf, measu_res_elem.avg); }
+
+  std::ofstream ofs(basename + ".gqmr", std::ofstream::binary);
+  ofs.write(buf.data(), buf.size());
+  ofs.close();
+}
+
+
+/**
+Load the measurement results dumped by DumpMeasuResBinary.
+
+@param basename The basename of the binary file.
+*/
+template <typename AvgT>
+MeasuRes<AvgT> LoadMeasuResBinary(const std::string &basename) {
+  auto file = basename + ".gqmr";
+  std::ifstream ifs(file, std::ifstream::binary);
+  if (!ifs) {
+    std::cout << "Unable to open " << file << std::endl;
+    exit(1);
+  }
+  char magic[4];
+  ifs.read(magic, 4);
+  if (!ifs || std::memcmp(magic, kMeasuResBinMagic, 4) != 0) {
+    std::cout << file << " is not a binary measurement result file!" << std::endl;
+    exit(1);
+  }
+  auto version = ReadRaw<uint32_t>(ifs);
+  auto avg_type_tag = ReadRaw<uint8_t>(ifs);
+  if (version != kMeasuResBinVersion || avg_type_tag != MeasuResAvgTypeTag(AvgT())) {
+    std::cout << "Unsupported version or average type of " << file << std::endl;
+    exit(1);
+  }
+  auto event_num = ReadRaw<uint64_t>(ifs);
+
+  MeasuRes<AvgT> res(event_num);
+  for (auto &measu_res_elem : res) {
+    measu_res_elem.sites.resize(ReadVarUint(ifs));
+  }
+  int64_t prev_head_site = 0;
+  for (auto &measu_res_elem : res) {
+    auto &sites = measu_res_elem.sites;
+    if (sites.empty()) { continue; }
+    sites[0] = prev_head_site + ZigzagDecode(ReadVarUint(ifs));
+    prev_head_site = sites[0];
+    for (size_t i = 1; i < sites.size(); ++i) {
+      sites[i] = sites[i-1] + ZigzagDecode(ReadVarUint(ifs));
+    }
+  }
+  for (auto &measu_res_elem : res) { measu_res_elem.avg = ReadRaw<AvgT>(ifs); }
+  if (!ifs) {
+    std::cout << "Unexpected end of " << file << std::endl;
+    exit(1);
+  }
+  ifs.close();
+  return res;
+}
 } /* gqmps2 */ 
 #endif /* ifndef GQMPS2_ONE_DIM_TN_MPS_FINITE_MPS_FINITE_MPS_MEASU_H */
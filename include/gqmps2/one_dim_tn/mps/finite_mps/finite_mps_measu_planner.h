@@ -0,0 +1,222 @@
+// SPDX-License-Identifier: LGPL-3.0-only
+
+/*
+* Author: Rongyang Sun <sun-rongyang@outlook.com>
+* Creation Date: 2020-10-22 10:41
+*
+* Description: GraceQ/MPS2 project. Batch measurement planner for finite MPS.
+*/
+
+/**
+@file finite_mps_measu_planner.h
+@brief Batch measurement planner for finite MPS.
+*/
+#ifndef GQMPS2_ONE_DIM_TN_MPS_FINITE_MPS_FINITE_MPS_MEASU_PLANNER_H
+#define GQMPS2_ONE_DIM_TN_MPS_FINITE_MPS_FINITE_MPS_MEASU_PLANNER_H
+
+
+#include "gqmps2/one_dim_tn/mps/finite_mps/finite_mps.h"          // FiniteMPS
+#include "gqmps2/one_dim_tn/mps/finite_mps/finite_mps_measu.h"    // MeasuRes, OpsVecAvgEngine
+#include "gqten/gqten.h"
+
+#include <string>       // string
+#include <vector>       // vector
+#include <functional>   // function
+#include <algorithm>    // stable_sort
+#include <assert.h>     // assert
+
+
+namespace gqmps2 {
+using namespace gqten;
+
+
+/**
+Batch measurement planner. One-site, two-site and multi-site measurement
+requests are collected first and measured together: all the measure events
+are ordered by their head sites, so the canonical center of the MPS only moves
+monotonically and each batch costs at most one pass of gauge moves. The events
+with the same head site share the left transfer tensor through
+OpsVecAvgEngine.
+
+@tparam TenElemT Type of the tensor element, real or complex.
+@tparam QNT Quantum number type.
+*/
+template <typename TenElemT, typename QNT>
+class MeasuPlanner {
+public:
+  using Tensor = GQTensor<TenElemT, QNT>;
+
+  /**
+  Add a request to measure a one-site operator on each site.
+
+  @param op The one-site operator.
+  @param N Number of sites of the to-be-measured MPS.
+  @param res_file_basename The basename of the output file.
+
+  @return Index of the request in the measurement results.
+  */
+  size_t AddOneSiteOp(
+      const Tensor &op,
+      const size_t N,
+      const std::string &res_file_basename
+  ) {
+    std::vector<std::vector<size_t>> sites_set;
+    for (size_t i = 0; i < N; ++i) { sites_set.push_back({i}); }
+    return AddRequest_(
+        sites_set,
+        [op](const size_t) { return std::vector<Tensor>({op}); },
+        res_file_basename
+    );
+  }
+
+  /**
+  Add a request to measure a two-site operator whose insert operators are the
+  same, see MeasureTwoSiteOp.
+  */
+  size_t AddTwoSiteOp(
+      const std::vector<Tensor> &phys_ops,
+      const Tensor &inst_op,
+      const std::vector<std::vector<size_t>> &sites_set,
+      const std::string &res_file_basename
+  ) {
+    assert(phys_ops.size() == 2);
+    TenVV<TenElemT, QNT> phys_ops_set(sites_set.size(), phys_ops);
+    TenVV<TenElemT, QNT> inst_ops_set(sites_set.size(), {inst_op});
+    return AddMultiSiteOp(
+        phys_ops_set, inst_ops_set, sites_set, res_file_basename
+    );
+  }
+
+  /**
+  Add a request to measure a multi-site operator whose insert operators between
+  two given physical operators are the same, see MeasureMultiSiteOp.
+  */
+  size_t AddMultiSiteOp(
+      const TenVV<TenElemT, QNT> &phys_ops_set,
+      const TenVV<TenElemT, QNT> &inst_ops_set,
+      const std::vector<std::vector<size_t>> &sites_set,
+      const std::string &res_file_basename
+  ) {
+    assert(phys_ops_set.size() == sites_set.size());
+    assert(inst_ops_set.size() == sites_set.size());
+    return AddRequest_(
+        sites_set,
+        [phys_ops_set, inst_ops_set, sites_set](const size_t i) {
+          return GenOpsVec(phys_ops_set[i], inst_ops_set[i], sites_set[i]);
+        },
+        res_file_basename
+    );
+  }
+
+  /**
+  Add a request to measure a multi-site operator whose physical and insert
+  operators are all given by the user, see MeasureMultiSiteOp.
+  */
+  size_t AddMultiSiteOp(
+      const TenVV<TenElemT, QNT> &phys_ops_set,
+      const TenVVV<TenElemT, QNT> &inst_ops_set_set,
+      const std::vector<std::vector<size_t>> &sites_set,
+      const std::string &res_file_basename
+  ) {
+    assert(phys_ops_set.size() == sites_set.size());
+    assert(inst_ops_set_set.size() == sites_set.size());
+    return AddRequest_(
+        sites_set,
+        [phys_ops_set, inst_ops_set_set](const size_t i) {
+          return GenOpsVec(phys_ops_set[i], inst_ops_set_set[i]);
+        },
+        res_file_basename
+    );
+  }
+
+  /**
+  Measure all the requests and dump the result of each request.
+
+  @param mps To-be-measured MPS.
+  @param res_format Output format of the measurement results.
+
+  @return Measurement results of the requests in the order they are added.
+  */
+  MeasuResSet<TenElemT> Measure(
+      FiniteMPS<TenElemT, QNT> &mps,
+      const MeasuResFormat res_format = MEASU_RES_JSON
+  ) const {
+    MeasuResSet<TenElemT> measu_res_set;
+    std::vector<MeasuEvent_> events;
+    for (size_t req = 0; req < requests_.size(); ++req) {
+      auto &sites_set = requests_[req].sites_set;
+      measu_res_set.push_back(MeasuRes<TenElemT>(sites_set.size()));
+      for (size_t i = 0; i < sites_set.size(); ++i) {
+        assert(!sites_set[i].empty());
+        assert(IsOrderKept(sites_set[i]));
+        events.push_back({sites_set[i].front(), sites_set[i].back(), req, i});
+      }
+    }
+    std::stable_sort(
+        events.begin(), events.end(),
+        [](const MeasuEvent_ &a, const MeasuEvent_ &b) {
+          if (a.head_site != b.head_site) { return a.head_site < b.head_site; }
+          return a.tail_site < b.tail_site;
+        }
+    );
+
+    auto N = mps.size();
+    size_t group_begin = 0;
+    while (group_begin < events.size()) {
+      auto head_site = events[group_begin].head_site;
+      mps.Centralize(head_site);
+      OpsVecAvgEngine<TenElemT, QNT> engine(mps, head_site);
+      size_t e = group_begin;
+      for (; e < events.size() && events[e].head_site == head_site; ++e) {
+        auto &event = events[e];
+        auto &request = requests_[event.request_idx];
+        auto &sites = request.sites_set[event.event_idx];
+        auto ops = request.gen_ops(event.event_idx);
+        auto &measu_res_elem = measu_res_set[event.request_idx][event.event_idx];
+        if (ops.size() == 1) {
+          measu_res_elem = OneSiteOpAvg(mps[head_site], ops[0], head_site, N);
+        } else {
+          measu_res_elem = MeasuResElem<TenElemT>(sites, engine.Avg(ops));
+        }
+      }
+      group_begin = e;
+    }
+
+    for (size_t req = 0; req < requests_.size(); ++req) {
+      DumpMeasuRes(
+          measu_res_set[req], requests_[req].res_file_basename, res_format
+      );
+    }
+    return measu_res_set;
+  }
+
+  /// Number of the collected requests.
+  size_t size(void) const { return requests_.size(); }
+
+private:
+  struct MeasuRequest_ {
+    std::vector<std::vector<size_t>> sites_set;
+    std::function<std::vector<Tensor>(const size_t)> gen_ops;   ///< Operator string generator of each event.
+    std::string res_file_basename;
+  };
+
+  struct MeasuEvent_ {
+    size_t head_site;
+    size_t tail_site;
+    size_t request_idx;
+    size_t event_idx;
+  };
+
+  std::vector<MeasuRequest_> requests_;
+
+  size_t AddRequest_(
+      const std::vector<std::vector<size_t>> &sites_set,
+      const std::function<std::vector<Tensor>(const size_t)> &gen_ops,
+      const std::string &res_file_basename
+  ) {
+    requests_.push_back({sites_set, gen_ops, res_file_basename});
+    return requests_.size() - 1;
+  }
+};
+} /* gqmps2 */
+#endif /* ifndef GQMPS2_ONE_DIM_TN_MPS_FINITE_MPS_FINITE_MPS_MEASU_PLANNER_H */
@@ -0,0 +1,198 @@
+// SPDX-License-Identifier: LGPL-3.0-only
+
+/*
+* Author: Rongyang Sun <sun-rongyang@outlook.com>
+* Creation Date: 2020-10-25 14:52
+*
+* Description: GraceQ/MPS2 project. Expectation value and variance of a matrix
+*              product operator on the finite MPS.
+*/
+
+/**
+@file finite_mps_mpo_measu.h
+@brief Expectation value and variance of a matrix product operator on the
+       finite MPS.
+*/
+#ifndef GQMPS2_ONE_DIM_TN_MPS_FINITE_MPS_FINITE_MPS_MPO_MEASU_H
+#define GQMPS2_ONE_DIM_TN_MPS_FINITE_MPS_FINITE_MPS_MPO_MEASU_H
+
+
+#include "gqmps2/one_dim_tn/mps/finite_mps/finite_mps.h"              // FiniteMPS
+#include "gqmps2/one_dim_tn/mps/finite_mps/finite_mps_disk_measu.h"   // MPSTenStreamer
+#include "gqmps2/one_dim_tn/mpo/mpo.h"                                // MPO
+#include "gqten/gqten.h"
+
+#include <string>       // string
+#include <complex>      // real, norm
+#include <functional>   // function
+#include <utility>      // move
+#include <assert.h>     // assert
+
+
+namespace gqmps2 {
+using namespace gqten;
+
+
+/**
+Expectation value and variance of a matrix product operator \f$H\f$.
+
+@tparam TenElemT Type of the tensor element, real or complex.
+*/
+template <typename TenElemT>
+struct MPOExpectRes {
+  TenElemT avg;         ///< \f$\langle H \rangle\f$.
+  TenElemT avg2;        ///< \f$\langle H^{2} \rangle\f$.
+  GQTEN_Double var;     ///< \f$\langle H^{2} \rangle - |\langle H \rangle|^{2}\f$.
+};
+
+
+/**
+Contract the MPS, the MPO and the conjugate MPS from the right end to the left
+end. Three right environments are carried: the norm, the single MPO layer and
+the two stacked MPO layers, so \f$H^{2}\f$ is never formed. Only the local
+tensor of the current site is needed at each step.
+
+@param mps The MPS whose local tensors are available after require_ten is
+       called.
+@param mpo The MPO.
+@param calc_var Whether to contract the two stacked MPO layers.
+@param require_ten Called before a local tensor is used, optional.
+@param release_ten Called after a local tensor is used, optional.
+*/
+template <typename TenElemT, typename QNT>
+MPOExpectRes<TenElemT> MPOExpectation_(
+    const FiniteMPS<TenElemT, QNT> &mps,
+    const MPO<GQTensor<TenElemT, QNT>> &mpo,
+    const bool calc_var,
+    const std::function<void(const size_t)> &require_ten = nullptr,
+    const std::function<void(const size_t)> &release_ten = nullptr
+) {
+  using TenT = GQTensor<TenElemT, QNT>;
+  auto N = mps.size();
+  assert(N >= 2);
+  assert(mpo.size() == N);
+
+  TenT norm_env, env, env2;
+  for (size_t j = 0; j < N; ++j) {
+    auto i = N - 1 - j;
+    if (require_ten) { require_ten(i); }
+    auto &mps_ten = mps[i];
+    auto mps_ten_dag = Dag(mps_ten);
+    if (i == N - 1) {
+      Contract(&mps_ten, &mps_ten_dag, {{1}, {1}}, &norm_env);
+      TenT temp;
+      Contract(&mps_ten, &mpo[i], {{1}, {0}}, &temp);
+      Contract(&temp, &mps_ten_dag, {{2}, {1}}, &env);
+      if (calc_var) {
+        TenT temp2;
+        Contract(&temp, &mpo[i], {{2}, {0}}, &temp2);
+        Contract(&temp2, &mps_ten_dag, {{3}, {1}}, &env2);
+      }
+    } else if (i != 0) {
+      TenT temp0, new_norm_env;
+      Contract(&mps_ten, &norm_env, {{2}, {0}}, &temp0);
+      Contract(&temp0, &mps_ten_dag, {{1, 2}, {1, 2}}, &new_norm_env);
+      norm_env = std::move(new_norm_env);
+
+      TenT temp1, temp2, new_env;
+      Contract(&mps_ten, &env, {{2}, {0}}, &temp1);
+      Contract(&temp1, &mpo[i], {{1, 2}, {1, 3}}, &temp2);
+      Contract(&temp2, &mps_ten_dag, {{3, 1}, {1, 2}}, &new_env);
+      env = std::move(new_env);
+
+      if (calc_var) {
+        TenT temp3, temp4, temp5, new_env2;
+        Contract(&mps_ten, &env2, {{2}, {0}}, &temp3);
+        Contract(&temp3, &mpo[i], {{1, 2}, {1, 3}}, &temp4);
+        Contract(&temp4, &mpo[i], {{4, 1}, {1, 3}}, &temp5);
+        Contract(&temp5, &mps_ten_dag, {{4, 1}, {1, 2}}, &new_env2);
+        env2 = std::move(new_env2);
+      }
+    } else {
+      TenT temp0, norm_ten;
+      Contract(&mps_ten, &norm_env, {{1}, {0}}, &temp0);
+      Contract(&temp0, &mps_ten_dag, {{0, 1}, {0, 1}}, &norm_ten);
+      norm_env = std::move(norm_ten);
+
+      TenT temp1, temp2, avg_ten;
+      Contract(&mps_ten, &env, {{1}, {0}}, &temp1);
+      Contract(&temp1, &mpo[i], {{0, 1}, {0, 1}}, &temp2);
+      Contract(&temp2, &mps_ten_dag, {{1, 0}, {0, 1}}, &avg_ten);
+      env = std::move(avg_ten);
+
+      if (calc_var) {
+        TenT temp3, temp4, temp5, avg2_ten;
+        Contract(&mps_ten, &env2, {{1}, {0}}, &temp3);
+        Contract(&temp3, &mpo[i], {{0, 1}, {0, 1}}, &temp4);
+        Contract(&temp4, &mpo[i], {{2, 0}, {0, 1}}, &temp5);
+        Contract(&temp5, &mps_ten_dag, {{1, 0}, {0, 1}}, &avg2_ten);
+        env2 = std::move(avg2_ten);
+      }
+    }
+    if (release_ten) { release_ten(i); }
+  }
+
+  TenElemT norm = norm_env();
+  MPOExpectRes<TenElemT> res;
+  res.avg = env() / norm;
+  if (calc_var) {
+    res.avg2 = env2() / norm;
+    res.var = std::real(res.avg2) - std::norm(res.avg);
+  } else {
+    res.avg2 = 0;
+    res.var = 0;
+  }
+  return res;
+}
+
+
+/**
+Measure the expectation value \f$\langle H \rangle\f$ and the variance
+\f$\langle H^{2} \rangle - \langle H \rangle^{2}\f$ of a MPO on the finite MPS.
+The results are normalized by the norm of the MPS and the MPS needs not to be
+canonical.
+
+@param mps To-be-measured MPS.
+@param mpo The MPO, for example, the Hamiltonian.
+@param calc_var Whether to calculate \f$\langle H^{2} \rangle\f$ and the
+       variance.
+*/
+template <typename TenElemT, typename QNT>
+MPOExpectRes<TenElemT> MeasureMPOExpectation(
+    const FiniteMPS<TenElemT, QNT> &mps,
+    const MPO<GQTensor<TenElemT, QNT>> &mpo,
+    const bool calc_var = true
+) {
+  return MPOExpectation_(mps, mpo, calc_var);
+}
+
+
+/**
+Measure the expectation value and the variance of a MPO on a finite MPS which
+lives on the disk. Only a few local tensors are loaded into the memory at the
+same time.
+
+@param mps The empty finite MPS which defines the sites information.
+@param mpo The MPO, for example, the Hamiltonian.
+@param mps_path The directory of the MPS local tensors.
+@param calc_var Whether to calculate \f$\langle H^{2} \rangle\f$ and the
+       variance.
+*/
+template <typename TenElemT, typename QNT>
+MPOExpectRes<TenElemT> MeasureMPOExpectationOnDisk(
+    FiniteMPS<TenElemT, QNT> &mps,
+    const MPO<GQTensor<TenElemT, QNT>> &mpo,
+    const std::string &mps_path,
+    const bool calc_var = true
+) {
+  assert(mps.empty());
+  MPSTenStreamer<TenElemT, QNT> streamer(mps, mps_path, true);
+  const FiniteMPS<TenElemT, QNT> &cmps = mps;
+  return MPOExpectation_(
+      cmps, mpo, calc_var,
+      [&streamer](const size_t i) { streamer.Require(i); },
+      [&streamer](const size_t i) { streamer.Release(i); }
+  );
+}
+} /* gqmps2 */
+#endif /* ifndef GQMPS2_ONE_DIM_TN_MPS_FINITE_MPS_FINITE_MPS_MPO_MEASU_H */
@@ -0,0 +1,213 @@
+// SPDX-License-Identifier: LGPL-3.0-only
+
+/*
+* Author: Rongyang Sun <sun-rongyang@outlook.com>
+* Creation Date: 2020-10-26 10:18
+*
+* Description: GraceQ/MPS2 project. Overlap and fidelity of two finite MPSs.
+*/
+
+/**
+@file finite_mps_overlap.h
+@brief Overlap and fidelity of two finite MPSs.
+*/
+#ifndef GQMPS2_ONE_DIM_TN_MPS_FINITE_MPS_FINITE_MPS_OVERLAP_H
+#define GQMPS2_ONE_DIM_TN_MPS_FINITE_MPS_FINITE_MPS_OVERLAP_H
+
+
+#include "gqmps2/one_dim_tn/mps/finite_mps/finite_mps.h"              // FiniteMPS
+#include "gqmps2/one_dim_tn/mps/finite_mps/finite_mps_disk_measu.h"   // MPSTenStreamer
+#include "gqten/gqten.h"
+
+#include <string>       // string
+#include <cmath>        // abs, sqrt
+#include <functional>   // function
+#include <utility>      // move
+#include <assert.h>     // assert
+
+
+namespace gqmps2 {
+using namespace gqten;
+
+
+/**
+Absorb the ket and the conjugate bra local tensors on a middle site into the
+overlap transfer tensor whose legs are (ket bond, bra bond). The transfer
+tensor is contracted first with the tensor whose cost is lower according to
+the bond dimensions.
+*/
+template <typename TenElemT, typename QNT>
+void CtrctOverlapMidTen(
+    const GQTensor<TenElemT, QNT> &bra_ten,
+    const GQTensor<TenElemT, QNT> &ket_ten,
+    GQTensor<TenElemT, QNT> &transfer_ten
+) {
+  using TenT = GQTensor<TenElemT, QNT>;
+  auto bra_ten_dag = Dag(bra_ten);
+  auto d = ket_ten.GetIndexes()[1].dim();
+  auto lk = ket_ten.GetIndexes()[0].dim();
+  auto rk = ket_ten.GetIndexes()[2].dim();
+  auto lb = bra_ten.GetIndexes()[0].dim();
+  auto rb = bra_ten.GetIndexes()[2].dim();
+  // Cost of absorbing the ket tensor first and the bra tensor first.
+  auto ket_first_cost = lb * lk * d * rk + lb * d * rk * rb;
+  auto bra_first_cost = lk * lb * d * rb + lk * d * rb * rk;
+  TenT temp_ten, new_transfer_ten;
+  if (ket_first_cost <= bra_first_cost) {
+    Contract(&transfer_ten, &ket_ten, {{0}, {0}}, &temp_ten);
+    Contract(&temp_ten, &bra_ten_dag, {{0, 1}, {0, 1}}, &new_transfer_ten);
+  } else {
+    Contract(&transfer_ten, &bra_ten_dag, {{1}, {0}}, &temp_ten);
+    Contract(&ket_ten, &temp_ten, {{0, 1}, {0, 1}}, &new_transfer_ten);
+  }
+  transfer_ten = std::move(new_transfer_ten);
+}
+
+
+/**
+Calculate the overlap \f$\langle \phi | \psi \rangle\f$ from the left end to the
+right end. Only the transfer tensor and the local tensors of the current site
+are needed at each step.
+
+@param bra The MPS \f$|\phi\rangle\f$.
+@param ket The MPS \f$|\psi\rangle\f$.
+@param require_ten Called before the local tensors on a site are used,
+       optional.
+@param release_ten Called after the local tensors on a site are used, optional.
+*/
+template <typename TenElemT, typename QNT>
+TenElemT MPSOverlap_(
+    const FiniteMPS<TenElemT, QNT> &bra,
+    const FiniteMPS<TenElemT, QNT> &ket,
+    const std::function<void(const size_t)> &require_ten = nullptr,
+    const std::function<void(const size_t)> &release_ten = nullptr
+) {
+  using TenT = GQTensor<TenElemT, QNT>;
+  auto N = ket.size();
+  assert(N >= 2);
+  assert(bra.size() == N);
+
+  TenT transfer_ten;
+  TenElemT overlap;
+  for (size_t i = 0; i < N; ++i) {
+    if (require_ten) { require_ten(i); }
+    if (i == 0) {
+      auto bra_ten_dag = Dag(bra[0]);
+      Contract(&ket[0], &bra_ten_dag, {{0}, {0}}, &transfer_ten);
+    } else if (i != N - 1) {
+      CtrctOverlapMidTen(bra[i], ket[i], transfer_ten);
+    } else {
+      TenT temp_ten, res_ten;
+      auto bra_ten_dag = Dag(bra[i]);
+      Contract(&transfer_ten, &ket[i], {{0}, {0}}, &temp_ten);
+      Contract(&temp_ten, &bra_ten_dag, {{0, 1}, {0, 1}}, &res_ten);
+      overlap = res_ten();
+    }
+    if (release_ten) { release_ten(i); }
+  }
+  return overlap;
+}
+
+
+/**
+Calculate the overlap \f$\langle \phi | \psi \rangle\f$ of two finite MPSs.
+
+@param bra The MPS \f$|\phi\rangle\f$.
+@param ket The MPS \f$|\psi\rangle\f$.
+*/
+template <typename TenElemT, typename QNT>
+TenElemT MPSOverlap(
+    const FiniteMPS<TenElemT, QNT> &bra,
+    const FiniteMPS<TenElemT, QNT> &ket
+) {
+  return MPSOverlap_(bra, ket);
+}
+
+
+/**
+Calculate the overlap \f$\langle \phi | \psi \rangle\f$ of two finite MPSs
+which live on the disk. Both MPSs are streamed site by site, so only the
+transfer tensor and a few local tensors are held in the memory.
+
+@param bra The empty MPS \f$|\phi\rangle\f$ which defines the sites information.
+@param bra_path The directory of the local tensors of the bra MPS.
+@param ket The empty MPS \f$|\psi\rangle\f$ which defines the sites information.
+@param ket_path The directory of the local tensors of the ket MPS.
+*/
+template <typename TenElemT, typename QNT>
+TenElemT MPSOverlapOnDisk(
+    FiniteMPS<TenElemT, QNT> &bra,
+    const std::string &bra_path,
+    FiniteMPS<TenElemT, QNT> &ket,
+    const std::string &ket_path
+) {
+  assert(&bra != &ket);
+  assert(bra.empty() && ket.empty());
+  MPSTenStreamer<TenElemT, QNT> bra_streamer(bra, bra_path);
+  MPSTenStreamer<TenElemT, QNT> ket_streamer(ket, ket_path);
+  const FiniteMPS<TenElemT, QNT> &cbra = bra;
+  const FiniteMPS<TenElemT, QNT> &cket = ket;
+  return MPSOverlap_(
+      cbra, cket,
+      [&bra_streamer, &ket_streamer](const size_t i) {
+        bra_streamer.Require(i);
+        ket_streamer.Require(i);
+      },
+      [&bra_streamer, &ket_streamer](const size_t i) {
+        bra_streamer.Release(i);
+        ket_streamer.Release(i);
+      }
+  );
+}
+
+
+/**
+Calculate the fidelity
+\f$|\langle \phi | \psi \rangle| / \sqrt{\langle \phi | \phi \rangle
+\langle \psi | \psi \rangle}\f$ of two finite MPSs.
+
+@param bra The MPS \f$|\phi\rangle\f$.
+@param ket The MPS \f$|\psi\rangle\f$.
+*/
+template <typename TenElemT, typename QNT>
+GQTEN_Double MPSFidelity(
+    const FiniteMPS<TenElemT, QNT> &bra,
+    const FiniteMPS<TenElemT, QNT> &ket
+) {
+  auto bra_norm2 = std::abs(MPSOverlap_(bra, bra));
+  auto ket_norm2 = std::abs(MPSOverlap_(ket, ket));
+  return std::abs(MPSOverlap_(bra, ket)) / std::sqrt(bra_norm2 * ket_norm2);
+}
+
+
+/**
+Calculate the fidelity of two finite MPSs which live on the disk. Three
+streaming passes are performed, one for the overlap and one for each norm.
+
+@see MPSOverlapOnDisk
+*/
+template <typename TenElemT, typename QNT>
+GQTEN_Double MPSFidelityOnDisk(
+    FiniteMPS<TenElemT, QNT> &bra,
+    const std::string &bra_path,
+    FiniteMPS<TenElemT, QNT> &ket,
+    const std::string &ket_path
+) {
+  auto norm2_on_disk = [](FiniteMPS<TenElemT, QNT> &mps, const std::string &path) {
+    MPSTenStreamer<TenElemT, QNT> streamer(mps, path);
+    const FiniteMPS<TenElemT, QNT> &cmps = mps;
+    return std::abs(
+        MPSOverlap_(
+            cmps, cmps,
+            [&streamer](const size_t i) { streamer.Require(i); },
+            [&streamer](const size_t i) { streamer.Release(i); }
+        )
+    );
+  };
+  auto bra_norm2 = norm2_on_disk(bra, bra_path);
+  auto ket_norm2 = norm2_on_disk(ket, ket_path);
+  auto overlap = MPSOverlapOnDisk(bra, bra_path, ket, ket_path);
+  return std::abs(overlap) / std::sqrt(bra_norm2 * ket_norm2);
+}
+} /* gqmps2 */
+#endif /* ifndef GQMPS2_ONE_DIM_TN_MPS_FINITE_MPS_FINITE_MPS_OVERLAP_H */
@@ -0,0 +1,121 @@
+// SPDX-License-Identifier: LGPL-3.0-only
+/*
+* Author: Rongyang Sun <sun-rongyang@outlook.com>
+* Creation Date: 2020-10-16 14:05
+*
+* Description: GraceQ/MPS2 project. The infinite matrix product state class.
+*/
+
+/**
+@file infinite_mps.h
+@brief The infinite matrix product state class.
+*/
+#ifndef GQMPS2_ONE_DIM_TN_MPS_INFINITE_MPS_INFINITE_MPS_H
+#define GQMPS2_ONE_DIM_TN_MPS_INFINITE_MPS_INFINITE_MPS_H
+
+
+#include "gqmps2/one_dim_tn/mps/mps.h"    // MPS
+#include "gqten/gqten.h"
+
+#include <string>     // string
+#include <fstream>    // ifstream, ofstream
+
+
+namespace gqmps2 {
+using namespace gqten;
+
+
+// Helpers
+inline std::string GenIMPSBondTenName(const std::string &mps_path) {
+  return mps_path + "/" + kIMpsBondTenBaseName + "." + kGQTenFileSuffix;
+}
+
+
+/**
+The infinite matrix product state class. Only the local tensors of one unit
+cell are stored. All of the local tensors have the (lvb, pb, rvb) form. The
+tensors on the left of the center bond are left canonical and the tensors on
+the right of the center bond are right canonical. The singular values on the
+center bond are stored separately.
+
+@tparam TenElemT Element type of the local tensors.
+@tparam QNT Quantum number type of the system.
+*/
+template <typename TenElemT, typename QNT>
+class InfiniteMPS : public MPS<TenElemT, QNT> {
+public:
+  using LocalTenT = typename MPS<TenElemT, QNT>::LocalTenT;
+  using BondTenT = GQTensor<GQTEN_Double, QNT>;
+
+  /**
+  Create a empty infinite MPS using the sites information of one unit cell.
+
+  @param unit_cell_site_vec The sites information of the unit cell.
+  @param center_bond The center bond is between the center_bond-1 th and the
+         center_bond th local tensors of the unit cell.
+  */
+  InfiniteMPS(
+      const SiteVec<TenElemT, QNT> &unit_cell_site_vec,
+      const size_t center_bond
+  ) : MPS<TenElemT, QNT>(unit_cell_site_vec), center_bond_(center_bond) {}
+
+  /**
+  Create a empty infinite MPS whose center bond is in the middle of the unit
+  cell.
+
+  @param unit_cell_site_vec The sites information of the unit cell.
+  */
+  InfiniteMPS(const SiteVec<TenElemT, QNT> &unit_cell_site_vec) :
+      InfiniteMPS(unit_cell_site_vec, unit_cell_site_vec.size / 2) {}
+
+  /**
+  Get the size of the unit cell.
+  */
+  size_t GetUnitCellSize(void) const { return this->size(); }
+
+  /**
+  Get the position of the center bond.
+  */
+  size_t GetCenterBond(void) const { return center_bond_; }
+
+  /**
+  Access to the singular values on the center bond.
+  */
+  BondTenT &GetCenterBondTen(void) { return center_bond_ten_; }
+
+  /**
+  Read-only access to the singular values on the center bond.
+  */
+  const BondTenT &GetCenterBondTen(void) const { return center_bond_ten_; }
+
+  // HDD I/O
+  /**
+  Dump infinite MPS, the unit cell tensors and the center bond tensor, to HDD.
+
+  @param mps_path Path to the MPS directory.
+  */
+  void Dump(const std::string &mps_path = kMpsPath) const {
+    MPS<TenElemT, QNT>::Dump(mps_path);
+    std::ofstream ofs(GenIMPSBondTenName(mps_path), std::ofstream::binary);
+    ofs << center_bond_ten_;
+    ofs.close();
+  }
+
+  /**
+  Load infinite MPS from HDD.
+
+  @param mps_path Path to the MPS directory.
+  */
+  void Load(const std::string &mps_path = kMpsPath) {
+    MPS<TenElemT, QNT>::Load(mps_path);
+    std::ifstream ifs(GenIMPSBondTenName(mps_path), std::ifstream::binary);
+    ifs >> center_bond_ten_;
+    ifs.close();
+  }
+
+private:
+  size_t center_bond_;
+  BondTenT center_bond_ten_;
+};
+} /* gqmps2 */
+#endif /* ifndef GQMPS2_ONE_DIM_TN_MPS_INFINITE_MPS_INFINITE_MPS_H */
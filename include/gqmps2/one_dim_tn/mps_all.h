@@ -21,6 +21,14 @@
 #include "gqmps2/one_dim_tn/mps/finite_mps/finite_mps.h"
 #include "gqmps2/one_dim_tn/mps/finite_mps/finite_mps_init.h"
 #include "gqmps2/one_dim_tn/mps/finite_mps/finite_mps_measu.h"
+#include "gqmps2/one_dim_tn/mps/finite_mps/finite_mps_measu_planner.h"
+#include "gqmps2/one_dim_tn/mps/finite_mps/finite_mps_disk_measu.h"
+#include "gqmps2/one_dim_tn/mps/finite_mps/finite_mps_ent_measu.h"
+#include "gqmps2/one_dim_tn/mps/finite_mps/finite_mps_mpo_measu.h"
+#include "gqmps2/one_dim_tn/mps/finite_mps/finite_mps_overlap.h"
+
+// Infinite MPS related
+#include "gqmps2/one_dim_tn/mps/infinite_mps/infinite_mps.h"
 
 
 #endif /* ifndef GQMPS2_ONE_DIM_TN_MPS_ALL_H */
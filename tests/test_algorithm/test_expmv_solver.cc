@@ -0,0 +1,368 @@
+// SPDX-License-Identifier: LGPL-3.0-only
+/*
+* Author: Rongyang Sun <sun-rongyang@outlook.com>
+* Creation Date: 2020-10-16 10:12
+*
+* Description: GraceQ/mps2 project. Krylov matrix exponential solver unittests.
+*/
+#include "gqmps2/algorithm/expmv_solver.h"
+#include "../testing_utils.h"
+#include "gqten/gqten.h"
+
+#include "gtest/gtest.h"
+
+#include <vector>
+#include <string>
+#include <complex>
+#include <cmath>
+
+#include "mkl.h"
+
+
+using namespace gqmps2;
+using namespace gqten;
+
+using U1QN = QN<U1QNVal>;
+using QNT = U1QN;
+using IndexT = Index<U1QN>;
+using QNSctT = QNSector<U1QN>;
+
+using DGQTensor = GQTensor<GQTEN_Double, U1QN>;
+using ZGQTensor = GQTensor<GQTEN_Complex, U1QN>;
+
+
+struct TestExpmv : public testing::Test {
+  size_t d = 2;
+  size_t D = 8;
+  size_t dh = 2;
+  QNT qn0 = QNT({QNCard("Sz", U1QNVal(0))});
+  IndexT idx_din = IndexT({QNSctT(qn0, d)}, GQTenIndexDirType::IN);
+  IndexT idx_dout = InverseIndex(idx_din);
+  IndexT idx_Din = IndexT({QNSctT(qn0, D)}, GQTenIndexDirType::IN);
+  IndexT idx_Dout = InverseIndex(idx_Din);
+  IndexT idx_vin = IndexT({QNSctT(qn0, dh)}, GQTenIndexDirType::IN);
+  IndexT idx_vout = InverseIndex(idx_vin);
+};
+
+
+inline GQTEN_Double Conj(const GQTEN_Double d) { return d; }
+
+
+inline GQTEN_Complex Conj(const GQTEN_Complex z) { return std::conj(z); }
+
+
+// Calculate exp(tau * H) * v by the full diagonalization of the dense matrix.
+template <typename TenElemT, typename CoefT, typename QNT>
+std::vector<GQTEN_Complex> DenseExpmv(
+    const std::vector<GQTensor<TenElemT, QNT> *> &eff_ham,
+    const GQTensor<TenElemT, QNT> &state,
+    const CoefT tau,
+    const std::string &where
+) {
+  using TenT = GQTensor<TenElemT, QNT>;
+  auto eff_ham_ten = new TenT;
+  if (where == "cent") {
+    Contract(eff_ham[0], eff_ham[1], {{1}, {0}}, eff_ham_ten);
+    InplaceContract(eff_ham_ten, eff_ham[2], {{4}, {0}});
+    InplaceContract(eff_ham_ten, eff_ham[3], {{6}, {1}});
+    // Indexes: (in, in, in, in, out, out, out, out).
+    eff_ham_ten->Transpose({0, 2, 4, 6, 1, 3, 5, 7});
+  } else if (where == "lend") {
+    Contract(eff_ham[1], eff_ham[2], {{1}, {0}}, eff_ham_ten);
+    InplaceContract(eff_ham_ten, eff_ham[3], {{4}, {1}});
+    // Indexes: (in, in, in, out, out, out).
+    eff_ham_ten->Transpose({0, 2, 4, 1, 3, 5});
+  } else {
+    Contract(eff_ham[0], eff_ham[1], {{1}, {0}}, eff_ham_ten);
+    InplaceContract(eff_ham_ten, eff_ham[2], {{4}, {1}});
+    // Indexes: (in, in, in, out, out, out).
+    eff_ham_ten->Transpose({0, 2, 4, 1, 3, 5});
+  }
+  auto state_shape = state.GetShape();
+  size_t dim = 1;
+  for (auto &s : state_shape) { dim *= s; }
+  std::vector<TenElemT> dense_mat(dim * dim);
+  size_t idx = 0;
+  for (auto &coors : GenAllCoors(eff_ham_ten->GetShape())) {
+    auto in = idx / dim;
+    auto out = idx % dim;
+    dense_mat[out * dim + in] = eff_ham_ten->GetElem(coors);
+    idx++;
+  }
+  std::vector<TenElemT> v;
+  v.reserve(dim);
+  for (auto &coors : GenAllCoors(state_shape)) { v.push_back(state.GetElem(coors)); }
+
+  std::vector<double> w(dim);
+  LapackeSyev(
+      LAPACK_ROW_MAJOR, 'V', 'U',
+      dim, dense_mat.data(), dim, w.data());
+  std::vector<GQTEN_Complex> res(dim, 0.0);
+  for (size_t j = 0; j < dim; ++j) {
+    GQTEN_Complex proj = 0.0;
+    for (size_t k = 0; k < dim; ++k) { proj += Conj(dense_mat[k*dim + j]) * v[k]; }
+    proj *= std::exp(GQTEN_Complex(tau) * w[j]);
+    for (size_t i = 0; i < dim; ++i) { res[i] += dense_mat[i*dim + j] * proj; }
+  }
+  delete eff_ham_ten;
+  return res;
+}
+
+
+template <typename TenElemT, typename CoefT, typename QNT>
+void RunTestExpmvSolverCase(
+    const std::vector<GQTensor<TenElemT, QNT> *> &eff_ham,
+    GQTensor<TenElemT, QNT> *pinit_state,
+    const CoefT tau,
+    const ExpmvParams &expmv_params,
+    const std::string &where
+) {
+  auto benchmark = DenseExpmv(eff_ham, *pinit_state, tau, where);
+  auto expmv_res = ExpmvSolver(
+                       eff_ham, pinit_state,
+                       tau,
+                       expmv_params,
+                       where
+                   );
+  EXPECT_LT(expmv_res.err, expmv_params.error);
+  size_t idx = 0;
+  for (auto &coors : GenAllCoors(expmv_res.expmv_vec->GetShape())) {
+    GQTEN_Complex elem = expmv_res.expmv_vec->GetElem(coors);
+    EXPECT_NEAR(elem.real(), benchmark[idx].real(), 1.0E-8);
+    EXPECT_NEAR(elem.imag(), benchmark[idx].imag(), 1.0E-8);
+    idx++;
+  }
+  delete expmv_res.expmv_vec;
+  mkl_free_buffers();
+}
+
+
+TEST_F(TestExpmv, TestCentExpmvSolver) {
+  // Tensor with double elements, imaginary time evolution.
+  auto dlblock = DGQTensor({idx_Dout, idx_vout, idx_Din});
+  auto dlsite  = DGQTensor({idx_vin, idx_din, idx_dout, idx_vout});
+  auto drblock = DGQTensor({idx_Din, idx_vin, idx_Dout});
+  auto dblock_random_mat =  new double [D*D];
+  RandRealSymMat(dblock_random_mat, D);
+  for (size_t i = 0; i < D; ++i) {
+    for (size_t j = 0; j < D; ++j) {
+      for (size_t k = 0; k < dh; ++k) {
+        dlblock({i, k, j}) = dblock_random_mat[(i*D + j)];
+        drblock({j, k, i}) = dblock_random_mat[(i*D + j)];
+      }
+    }
+  }
+  delete[] dblock_random_mat;
+  auto dsite_random_mat = new double [d*d];
+  RandRealSymMat(dsite_random_mat, d);
+  for (size_t i = 0; i < d; ++i) {
+    for (size_t j = 0; j < d; ++j) {
+      for (size_t k = 0; k < dh; ++k) {
+        dlsite({k, i, j, k}) = dsite_random_mat[(i*d + j)];
+      }
+    }
+  }
+  delete[] dsite_random_mat;
+  auto drsite  = DGQTensor(dlsite);
+  auto pdinit_state = new DGQTensor({idx_Din, idx_dout, idx_dout, idx_Dout});
+  srand(0);
+  pdinit_state->Random(qn0);
+  RunTestExpmvSolverCase(
+      {&dlblock, &dlsite, &drsite, &drblock},
+      pdinit_state,
+      -0.05,
+      ExpmvParams(1.0E-12),
+      "cent"
+  );
+
+  // Tensor with complex elements, real time evolution.
+  auto zlblock = ZGQTensor({idx_Dout, idx_vout, idx_Din});
+  auto zlsite  = ZGQTensor({idx_vin, idx_din, idx_dout, idx_vout});
+  auto zrblock = ZGQTensor({idx_Din, idx_vin, idx_Dout});
+  auto zblock_random_mat =  new GQTEN_Complex [D*D];
+  RandCplxHerMat(zblock_random_mat, D);
+  for (size_t i = 0; i < D; ++i) {
+    for (size_t j = 0; j < D; ++j) {
+      for (size_t k = 0; k < dh; ++k) {
+        zlblock({i, k, j}) = zblock_random_mat[(i*D+j)];
+        zrblock({j, k, i}) = zblock_random_mat[(i*D+j)];
+      }
+    }
+  }
+  delete [] zblock_random_mat;
+  auto zsite_random_mat = new GQTEN_Complex [d*d];
+  RandCplxHerMat(zsite_random_mat, d);
+  for (size_t i = 0; i < d; ++i) {
+    for (size_t j = 0; j < d; ++j) {
+      for (size_t k = 0; k < dh; ++k) {
+        zlsite({k, i, j, k}) = zsite_random_mat[(i*d+j)];
+      }
+    }
+  }
+  delete[] zsite_random_mat;
+  auto zrsite  = ZGQTensor(zlsite);
+  auto pzinit_state = new ZGQTensor({idx_Din, idx_dout, idx_dout, idx_Dout});
+  srand(0);
+  pzinit_state->Random(qn0);
+  RunTestExpmvSolverCase(
+      {&zlblock, &zlsite, &zrsite, &zrblock},
+      pzinit_state,
+      GQTEN_Complex(0.0, -0.05),
+      ExpmvParams(1.0E-12),
+      "cent"
+  );
+}
+
+
+TEST_F(TestExpmv, TestLendExpmvSolver) {
+  // Tensor with double elements, imaginary time evolution.
+  auto dlsite = DGQTensor({idx_din, idx_vout, idx_dout});
+  auto drsite = DGQTensor({idx_vin, idx_din, idx_dout, idx_vout});
+  auto drblock = DGQTensor({idx_Din, idx_vin, idx_Dout});
+  auto dblock_random_mat = new double [D*D];
+  RandRealSymMat(dblock_random_mat, D);
+  for (size_t i = 0; i < D; ++i) {
+    for (size_t j = 0; j < D; ++j) {
+      for (size_t k = 0; k < dh; ++k) {
+        drblock({j, k, i}) = dblock_random_mat[(i*D + j)];
+      }
+    }
+  }
+  delete[] dblock_random_mat;
+  auto dsite_random_mat = new double [d*d];
+  RandRealSymMat(dsite_random_mat, d);
+  for (size_t i = 0; i < d; ++i) {
+    for (size_t j = 0; j < d; ++j) {
+      for (size_t k = 0; k < dh; ++k) {
+        dlsite({i, k, j}) = dsite_random_mat[(i*d + j)];
+        drsite({k, i, j, k}) = dsite_random_mat[(i*d + j)];
+      }
+    }
+  }
+  delete[] dsite_random_mat;
+  auto dnull_ten = DGQTensor();
+  auto pdinit_state = new DGQTensor({idx_dout, idx_dout, idx_Dout});
+  srand(0);
+  pdinit_state->Random(qn0);
+  RunTestExpmvSolverCase(
+      {&dnull_ten, &dlsite, &drsite, &drblock},
+      pdinit_state,
+      -0.05,
+      ExpmvParams(1.0E-12),
+      "lend"
+  );
+
+  // Tensor with complex elements, real time evolution.
+  auto zlsite = ZGQTensor({idx_din, idx_vout, idx_dout});
+  auto zrsite = ZGQTensor({idx_vin, idx_din, idx_dout, idx_vout});
+  auto zrblock = ZGQTensor({idx_Din, idx_vin, idx_Dout});
+  auto zblock_random_mat = new GQTEN_Complex [D*D];
+  RandCplxHerMat(zblock_random_mat, D);
+  for (size_t i = 0; i < D; ++i) {
+    for (size_t j = 0; j < D; ++j) {
+      for (size_t k = 0; k < dh; ++k) {
+        zrblock({j, k, i}) = zblock_random_mat[(i*D + j)];
+      }
+    }
+  }
+  delete[] zblock_random_mat;
+  auto zsite_random_mat = new GQTEN_Complex [d*d];
+  RandCplxHerMat(zsite_random_mat, d);
+  for (size_t i = 0; i < d; ++i) {
+    for (size_t j = 0; j < d; ++j) {
+      for (size_t k = 0; k < dh; ++k) {
+        zlsite({i, k, j}) = zsite_random_mat[(i*d + j)];
+        zrsite({k, i, j, k}) = zsite_random_mat[(i*d + j)];
+      }
+    }
+  }
+  delete[] zsite_random_mat;
+  auto znull_ten = ZGQTensor();
+  auto pzinit_state = new ZGQTensor({idx_dout, idx_dout, idx_Dout});
+  srand(0);
+  pzinit_state->Random(qn0);
+  RunTestExpmvSolverCase(
+      {&znull_ten, &zlsite, &zrsite, &zrblock},
+      pzinit_state,
+      GQTEN_Complex(0.0, -0.05),
+      ExpmvParams(1.0E-12),
+      "lend"
+  );
+}
+
+
+TEST_F(TestExpmv, TestRendExpmvSolver) {
+  // Tensor with double elements, imaginary time evolution.
+  auto dlblock = DGQTensor({idx_Dout, idx_vout, idx_Din});
+  auto dlsite = DGQTensor({idx_vin, idx_din, idx_dout, idx_vout});
+  auto drsite = DGQTensor({idx_din, idx_vin, idx_dout});
+  auto dblock_random_mat = new double [D*D];
+  RandRealSymMat(dblock_random_mat, D);
+  for (size_t i = 0; i < D; ++i) {
+    for (size_t j = 0; j < D; ++j) {
+      for (size_t k = 0; k < dh; ++k) {
+        dlblock({i, k, j}) = dblock_random_mat[(i*D + j)];
+      }
+    }
+  }
+  delete[] dblock_random_mat;
+  auto dsite_random_mat = new double [d*d];
+  RandRealSymMat(dsite_random_mat, d);
+  for (size_t i = 0; i < d; ++i) {
+    for (size_t j = 0; j < d; ++j) {
+      for (size_t k = 0; k < dh; ++k) {
+        dlsite({k, i, j, k}) = dsite_random_mat[(i*d + j)];
+        drsite({i, k, j}) = dsite_random_mat[(i*d + j)];
+      }
+    }
+  }
+  delete[] dsite_random_mat;
+  auto dnull_ten = DGQTensor();
+  auto pdinit_state = new DGQTensor({idx_Din, idx_dout, idx_dout});
+  srand(0);
+  pdinit_state->Random(qn0);
+  RunTestExpmvSolverCase(
+      {&dlblock, &dlsite, &drsite, &dnull_ten},
+      pdinit_state,
+      -0.05,
+      ExpmvParams(1.0E-12),
+      "rend"
+  );
+
+  // Tensor with complex elements, real time evolution.
+  auto zlblock = ZGQTensor({idx_Dout, idx_vout, idx_Din});
+  auto zlsite = ZGQTensor({idx_vin, idx_din, idx_dout, idx_vout});
+  auto zrsite = ZGQTensor({idx_din, idx_vin, idx_dout});
+  auto zblock_random_mat = new GQTEN_Complex [D*D];
+  RandCplxHerMat(zblock_random_mat, D);
+  for (size_t i = 0; i < D; ++i) {
+    for (size_t j = 0; j < D; ++j) {
+      for (size_t k = 0; k < dh; ++k) {
+        zlblock({i, k, j}) = zblock_random_mat[(i*D + j)];
+      }
+    }
+  }
+  delete[] zblock_random_mat;
+  auto zsite_random_mat = new GQTEN_Complex [d*d];
+  RandCplxHerMat(zsite_random_mat, d);
+  for (size_t i = 0; i < d; ++i) {
+    for (size_t j = 0; j < d; ++j) {
+      for (size_t k = 0; k < dh; ++k) {
+        zlsite({k, i, j, k}) = zsite_random_mat[(i*d + j)];
+        zrsite({i, k, j}) = zsite_random_mat[(i*d + j)];
+      }
+    }
+  }
+  delete[] zsite_random_mat;
+  auto znull_ten = ZGQTensor();
+  auto pzinit_state = new ZGQTensor({idx_Din, idx_dout, idx_dout});
+  srand(0);
+  pzinit_state->Random(qn0);
+  RunTestExpmvSolverCase(
+      {&zlblock, &zlsite, &zrsite, &znull_ten},
+      pzinit_state,
+      GQTEN_Complex(0.0, -0.05),
+      ExpmvParams(1.0E-12),
+      "rend"
+  );
+}
@@ -0,0 +1,213 @@
+// SPDX-License-Identifier: LGPL-3.0-only
+/*
+* Author: Rongyang Sun <sun-rongyang@outlook.com>
+* Creation Date: 2020-10-17 09:30
+*
+* Description: GraceQ/mps2 project. Unittest for two sites algorithm with
+*              several local processes.
+*/
+#include "gqmps2/gqmps2.h"
+#include "gqmps2/local_proc_comm.h"
+#include "gtest/gtest.h"
+#include "gqten/gqten.h"
+
+#include <vector>
+#include <fstream>      // ifstream
+
+#include <stdlib.h>     // system
+
+
+using namespace gqmps2;
+using namespace gqten;
+
+using U1QN = QN<U1QNVal>;
+using IndexT = Index<U1QN>;
+using QNSctT = QNSector<U1QN>;
+using DGQTensor = GQTensor<GQTEN_Double, U1QN>;
+using ZGQTensor = GQTensor<GQTEN_Complex, U1QN>;
+using DSiteVec = SiteVec<GQTEN_Double, U1QN>;
+using ZSiteVec = SiteVec<GQTEN_Complex, U1QN>;
+using DMPS = FiniteMPS<GQTEN_Double, U1QN>;
+using ZMPS = FiniteMPS<GQTEN_Complex, U1QN>;
+
+
+inline void RemoveFolder(const std::string &folder_path) {
+  std::string command = "rm -rf " + folder_path;
+  system(command.c_str());
+}
+
+
+// The MPS and the MPO must be prepared before launching the processes.
+template <typename TenElemT, typename QNT>
+void RunTestDistTwoSiteAlgorithmCase(
+    FiniteMPS<TenElemT, QNT> &mps,
+    const MPO<GQTensor<TenElemT, QNT>> &mpo,
+    const SweepParams &sweep_params,
+    const size_t proc_num,
+    const double benmrk_e0, const double precision
+) {
+  LocalProcComm comm(proc_num);
+  auto e0 = TwoSiteFiniteVMPS(mps, mpo, sweep_params, comm);
+  EXPECT_EQ(comm.rank(), 0);
+  EXPECT_NEAR(e0, benmrk_e0, precision);
+  EXPECT_TRUE(mps.empty());
+}
+
+
+struct TestDistTwoSiteAlgorithmSpinSystem : public testing::Test {
+  size_t N = 6;
+
+  U1QN qn0 = U1QN({QNCard("Sz", U1QNVal(0))});
+  IndexT pb_out = IndexT({
+                      QNSctT(U1QN({QNCard("Sz", U1QNVal( 1))}), 1),
+                      QNSctT(U1QN({QNCard("Sz", U1QNVal(-1))}), 1)},
+                      GQTenIndexDirType::OUT
+                  );
+  IndexT pb_in = InverseIndex(pb_out);
+  DSiteVec dsite_vec_6 = DSiteVec(N, pb_out);
+  ZSiteVec zsite_vec_6 = ZSiteVec(N, pb_out);
+
+  DGQTensor  dsz  = DGQTensor({pb_in, pb_out});
+  DGQTensor  dsp  = DGQTensor({pb_in, pb_out});
+  DGQTensor  dsm  = DGQTensor({pb_in, pb_out});
+  DMPS dmps = DMPS(dsite_vec_6);
+
+  ZGQTensor  zsz  = ZGQTensor({pb_in, pb_out});
+  ZGQTensor  zsp  = ZGQTensor({pb_in, pb_out});
+  ZGQTensor  zsm  = ZGQTensor({pb_in, pb_out});
+  ZMPS zmps = ZMPS(zsite_vec_6);
+
+  void SetUp(void) {
+    dsz({0, 0}) = 0.5;
+    dsz({1, 1}) = -0.5;
+    dsp({0, 1}) = 1;
+    dsm({1, 0}) = 1;
+
+    zsz({0, 0}) = 0.5;
+    zsz({1, 1}) = -0.5;
+    zsp({0, 1}) = 1;
+    zsm({1, 0}) = 1;
+  }
+};
+
+
+TEST_F(TestDistTwoSiteAlgorithmSpinSystem, 1DHeisenberg) {
+  auto dmpo_gen = MPOGenerator<GQTEN_Double, U1QN>(dsite_vec_6, qn0);
+  for (size_t i = 0; i < N-1; ++i) {
+    dmpo_gen.AddTerm(1,   {dsz, dsz}, {i, i+1});
+    dmpo_gen.AddTerm(0.5, {dsp, dsm}, {i, i+1});
+    dmpo_gen.AddTerm(0.5, {dsm, dsp}, {i, i+1});
+  }
+  auto dmpo = dmpo_gen.Gen();
+
+  auto sweep_params = SweepParams(
+                          4,
+                          8, 8, 1.0E-9,
+                          LanczosParams(1.0E-7)
+                      );
+  std::vector<size_t> stat_labs;
+  for (size_t i = 0; i < N; ++i) { stat_labs.push_back(i % 2); }
+  for (size_t proc_num : {1, 2, 3}) {
+    DirectStateInitMps(dmps, stat_labs, qn0);
+    dmps.Dump(sweep_params.mps_path, true);
+    RunTestDistTwoSiteAlgorithmCase(
+        dmps, dmpo, sweep_params, proc_num,
+        -2.493577133888, 1.0E-12
+    );
+    RemoveFolder(sweep_params.mps_path);
+    RemoveFolder(sweep_params.temp_path);
+  }
+
+  // Complex Hamiltonian
+  auto zmpo_gen = MPOGenerator<GQTEN_Complex, U1QN>(zsite_vec_6, qn0);
+  for (size_t i = 0; i < N-1; ++i) {
+    zmpo_gen.AddTerm(1,   {zsz, zsz}, {i, i+1});
+    zmpo_gen.AddTerm(0.5, {zsp, zsm}, {i, i+1});
+    zmpo_gen.AddTerm(0.5, {zsm, zsp}, {i, i+1});
+  }
+  auto zmpo = zmpo_gen.Gen();
+  DirectStateInitMps(zmps, stat_labs, qn0);
+  zmps.Dump(sweep_params.mps_path, true);
+  RunTestDistTwoSiteAlgorithmCase(
+      zmps, zmpo, sweep_params, 3,
+      -2.493577133888, 1.0E-12
+  );
+  RemoveFolder(sweep_params.mps_path);
+  RemoveFolder(sweep_params.temp_path);
+}
+
+
+// No process, the master included, holds a full environment: each one only
+// holds the blocks of the MPO bond sectors assigned to it, and the slices sum
+// up to the environment of the serial initialization.
+TEST_F(TestDistTwoSiteAlgorithmSpinSystem, EnvSlices) {
+  auto dmpo_gen = MPOGenerator<GQTEN_Double, U1QN>(dsite_vec_6, qn0);
+  for (size_t i = 0; i < N-1; ++i) {
+    dmpo_gen.AddTerm(1,   {dsz, dsz}, {i, i+1});
+    dmpo_gen.AddTerm(0.5, {dsp, dsm}, {i, i+1});
+    dmpo_gen.AddTerm(0.5, {dsm, dsp}, {i, i+1});
+  }
+  auto dmpo = dmpo_gen.Gen();
+
+  std::vector<size_t> stat_labs, flipped_stat_labs;
+  for (size_t i = 0; i < N; ++i) {
+    stat_labs.push_back(i % 2);
+    flipped_stat_labs.push_back((i + 1) % 2);
+  }
+  ExtendDirectRandomInitMps(dmps, {stat_labs, flipped_stat_labs}, qn0, 2);
+  dmps.Dump(kMpsPath, true);
+  auto ref_params = SweepParams(1, 8, 8, 1.0E-9, LanczosParams(1.0E-7));
+  ref_params.temp_path = "ref_renv";
+  CreatPath(ref_params.temp_path);
+  InitEnvs(dmps, dmpo, ref_params);
+  auto sweep_params = SweepParams(1, 8, 8, 1.0E-9, LanczosParams(1.0E-7));
+  CreatPath(sweep_params.temp_path);
+
+  size_t proc_num = 3;
+  LocalProcComm comm(proc_num);
+  DistInitEnvs(dmps, dmpo, sweep_params, comm);
+  for (size_t len = 1; len <= N - 2; ++len) {
+    auto pslice = LoadEnvSlice<DGQTensor>(
+                      GenDistEnvTenName(
+                          "r", len, sweep_params.temp_path, comm.rank()
+                      )
+                  );
+    auto psum = ReduceSumTen(
+                    comm, (pslice == nullptr) ? nullptr : new DGQTensor(*pslice)
+                );
+    if (comm.rank() == 0) {
+      DGQTensor renv;
+      std::ifstream ifs(
+          GenEnvTenName("r", len, ref_params.temp_path), std::ifstream::binary
+      );
+      ifs >> renv;
+      ifs.close();
+      auto diff = *psum + (-renv);
+      EXPECT_NEAR(diff.Get2Norm(), 0.0, 1.0E-13);
+
+      auto site = N - len;
+      auto proc_coors = PartitionMPOBond(
+                            dmpo[site].GetIndexes()[MPOLeftBondIdx(dmpo, site)],
+                            proc_num
+                        );
+      std::vector<size_t> other_coors;
+      for (size_t r = 1; r < proc_num; ++r) {
+        other_coors.insert(
+            other_coors.end(), proc_coors[r].begin(), proc_coors[r].end()
+        );
+      }
+      EXPECT_FALSE(other_coors.empty());
+      ASSERT_NE(pslice, nullptr);
+      EXPECT_LT(pslice->Get2Norm(), renv.Get2Norm());
+      auto pother_part = ProjectTenIndex(*pslice, 1, other_coors);
+      EXPECT_EQ(pother_part->Get2Norm(), 0.0);
+      delete pother_part;
+    }
+    delete pslice;
+    delete psum;
+  }
+  comm.Finalize();
+  RemoveFolder(kMpsPath);
+  RemoveFolder(sweep_params.temp_path);
+  RemoveFolder(ref_params.temp_path);
+}
@@ -0,0 +1,139 @@
+// SPDX-License-Identifier: LGPL-3.0-only
+/*
+* Author: Rongyang Sun <sun-rongyang@outlook.com>
+* Creation Date: 2020-10-16 14:05
+*
+* Description: GraceQ/mps2 project. Unittest for two sites infinite vMPS (iDMRG).
+*/
+#include "gqmps2/gqmps2.h"
+#include "gtest/gtest.h"
+#include "gqten/gqten.h"
+
+#include <vector>
+#include <cmath>      // log
+
+
+using namespace gqmps2;
+using namespace gqten;
+
+using U1QN = QN<U1QNVal>;
+using IndexT = Index<U1QN>;
+using QNSctT = QNSector<U1QN>;
+using DGQTensor = GQTensor<GQTEN_Double, U1QN>;
+using ZGQTensor = GQTensor<GQTEN_Complex, U1QN>;
+using DSiteVec = SiteVec<GQTEN_Double, U1QN>;
+using ZSiteVec = SiteVec<GQTEN_Complex, U1QN>;
+using DIMPS = InfiniteMPS<GQTEN_Double, U1QN>;
+using ZIMPS = InfiniteMPS<GQTEN_Complex, U1QN>;
+
+
+template <typename TenElemT, typename QNT>
+void RunTestTwoSiteInfiniteAlgorithmCase(
+    InfiniteMPS<TenElemT, QNT> &imps,
+    const MPO<GQTensor<TenElemT, QNT>> &mpo,
+    const size_t bulk_site,
+    const QNT &cell_div,
+    const InfiniteSweepParams &sweep_params,
+    const double benmrk_e0, const double precision
+) {
+  auto e0 = TwoSiteInfiniteVMPS(imps, mpo, bulk_site, cell_div, sweep_params);
+  EXPECT_NEAR(e0, benmrk_e0, precision);
+  EXPECT_EQ(imps.GetUnitCellSize(), 2);
+  EXPECT_EQ(imps[0].Rank(), 3);
+  EXPECT_EQ(imps[1].Rank(), 3);
+}
+
+
+struct TestTwoSiteInfiniteAlgorithmSpinSystem : public testing::Test {
+  size_t N = 8;
+  size_t bulk_site = N / 2 - 1;
+
+  U1QN qn0 = U1QN({QNCard("Sz", U1QNVal(0))});
+  IndexT pb_out = IndexT({
+                      QNSctT(U1QN({QNCard("Sz", U1QNVal( 1))}), 1),
+                      QNSctT(U1QN({QNCard("Sz", U1QNVal(-1))}), 1)},
+                      GQTenIndexDirType::OUT
+                  );
+  IndexT pb_in = InverseIndex(pb_out);
+  DSiteVec dsite_vec = DSiteVec(N, pb_out);
+  DSiteVec dcell_site_vec = DSiteVec(2, pb_out);
+  ZSiteVec zsite_vec = ZSiteVec(N, pb_out);
+  ZSiteVec zcell_site_vec = ZSiteVec(2, pb_out);
+
+  DGQTensor  dsz  = DGQTensor({pb_in, pb_out});
+  DGQTensor  dsp  = DGQTensor({pb_in, pb_out});
+  DGQTensor  dsm  = DGQTensor({pb_in, pb_out});
+
+  ZGQTensor  zsz  = ZGQTensor({pb_in, pb_out});
+  ZGQTensor  zsp  = ZGQTensor({pb_in, pb_out});
+  ZGQTensor  zsm  = ZGQTensor({pb_in, pb_out});
+
+  void SetUp(void) {
+    dsz({0, 0}) = 0.5;
+    dsz({1, 1}) = -0.5;
+    dsp({0, 1}) = 1;
+    dsm({1, 0}) = 1;
+
+    zsz({0, 0}) = 0.5;
+    zsz({1, 1}) = -0.5;
+    zsp({0, 1}) = 1;
+    zsm({1, 0}) = 1;
+  }
+};
+
+
+TEST_F(TestTwoSiteInfiniteAlgorithmSpinSystem, 1DIsing) {
+  auto dmpo_gen = MPOGenerator<GQTEN_Double, U1QN>(dsite_vec, qn0);
+  for (size_t i = 0; i < N-1; ++i) {
+    dmpo_gen.AddTerm(1, {dsz, dsz}, {i, i+1});
+  }
+  auto dmpo = dmpo_gen.Gen();
+  auto sweep_params = InfiniteSweepParams(
+                          20,
+                          1, 8, 1.0E-9,
+                          LanczosParams(1.0E-10)
+                      );
+  auto imps = DIMPS(dcell_site_vec);
+  RunTestTwoSiteInfiniteAlgorithmCase(
+      imps, dmpo, bulk_site, qn0, sweep_params,
+      -0.25, 1.0E-10
+  );
+}
+
+
+TEST_F(TestTwoSiteInfiniteAlgorithmSpinSystem, 1DHeisenberg) {
+  // The exact energy per site of the infinite spin-1/2 Heisenberg chain.
+  auto benmrk_e0 = 0.25 - std::log(2.0);
+
+  auto dmpo_gen = MPOGenerator<GQTEN_Double, U1QN>(dsite_vec, qn0);
+  for (size_t i = 0; i < N-1; ++i) {
+    dmpo_gen.AddTerm(1,   {dsz, dsz}, {i, i+1});
+    dmpo_gen.AddTerm(0.5, {dsp, dsm}, {i, i+1});
+    dmpo_gen.AddTerm(0.5, {dsm, dsp}, {i, i+1});
+  }
+  auto dmpo = dmpo_gen.Gen();
+  auto sweep_params = InfiniteSweepParams(
+                          300,
+                          8, 32, 1.0E-10,
+                          LanczosParams(1.0E-10),
+                          1.0E-7
+                      );
+  auto dimps = DIMPS(dcell_site_vec);
+  RunTestTwoSiteInfiniteAlgorithmCase(
+      dimps, dmpo, bulk_site, qn0, sweep_params,
+      benmrk_e0, 1.0E-3
+  );
+
+  auto zmpo_gen = MPOGenerator<GQTEN_Complex, U1QN>(zsite_vec, qn0);
+  for (size_t i = 0; i < N-1; ++i) {
+    zmpo_gen.AddTerm(1,   {zsz, zsz}, {i, i+1});
+    zmpo_gen.AddTerm(0.5, {zsp, zsm}, {i, i+1});
+    zmpo_gen.AddTerm(0.5, {zsm, zsp}, {i, i+1});
+  }
+  auto zmpo = zmpo_gen.Gen();
+  auto zimps = ZIMPS(zcell_site_vec);
+  RunTestTwoSiteInfiniteAlgorithmCase(
+      zimps, zmpo, bulk_site, qn0, sweep_params,
+      benmrk_e0, 1.0E-3
+  );
+}
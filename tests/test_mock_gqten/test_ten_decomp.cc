@@ -0,0 +1,351 @@
+// SPDX-License-Identifier: LGPL-3.0-only
+/*
+* Author: Rongyang Sun <sun-rongyang@outlook.com>
+* Creation Date: 2020-10-20 16:05
+*
+* Description: GraceQ/mps2 project. Unittests for quantum number block parallel
+*              tensor decomposition.
+*/
+#include "gqmps2/mock_gqten/ten_decomp.h"
+#include "gqten/gqten.h"
+
+#include "gtest/gtest.h"
+
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <cmath>
+
+
+using namespace gqmps2;
+using namespace gqten;
+
+using U1QN = QN<U1QNVal>;
+using QNT = U1QN;
+using IndexT = Index<U1QN>;
+using QNSctT = QNSector<U1QN>;
+
+using DGQTensor = GQTensor<GQTEN_Double, U1QN>;
+using ZGQTensor = GQTensor<GQTEN_Complex, U1QN>;
+
+
+struct TestBlockParallelSVD : public testing::Test {
+  QNT qn0 = QNT({QNCard("Sz", U1QNVal(0))});
+  QNT qnp1 = QNT({QNCard("Sz", U1QNVal(1))});
+  QNT qnm1 = QNT({QNCard("Sz", U1QNVal(-1))});
+  IndexT idx_pin = IndexT({QNSctT(qnm1, 1), QNSctT(qnp1, 1)}, GQTenIndexDirType::IN);
+  IndexT idx_pout = InverseIndex(idx_pin);
+  IndexT idx_vin = IndexT(
+                       {QNSctT(qnm1, 3), QNSctT(qn0, 4), QNSctT(qnp1, 3)},
+                       GQTenIndexDirType::IN
+                   );
+  IndexT idx_vout = InverseIndex(idx_vin);
+};
+
+
+std::vector<GQTEN_Double> SortedDiagElems(
+    const GQTensor<GQTEN_Double, QNT> &s, const size_t D
+) {
+  std::vector<GQTEN_Double> svs;
+  for (size_t i = 0; i < D; ++i) { svs.push_back(s.GetElem({i, i})); }
+  std::sort(svs.begin(), svs.end());
+  return svs;
+}
+
+
+template <typename TenElemT>
+void RunTestBlockParallelSVDCase(
+    const GQTensor<TenElemT, QNT> &t,
+    const size_t ldims,
+    const QNT &lqndiv,
+    const GQTEN_Double trunc_err, const size_t Dmin, const size_t Dmax,
+    const size_t thread_num,
+    const TruncDecompType decomp_type = FULL_SVD,
+    const double tol = 1.0E-12
+) {
+  using TenT = GQTensor<TenElemT, QNT>;
+  using DTenT = GQTensor<GQTEN_Double, QNT>;
+  TenT u, vt, bu, bvt;
+  DTenT s, bs;
+  GQTEN_Double trunc_err_res, btrunc_err_res;
+  size_t D, bD;
+  SVD(
+      &t, ldims, lqndiv, trunc_err, Dmin, Dmax,
+      &u, &s, &vt, &trunc_err_res, &D
+  );
+  mock_gqten::TruncatedDecomp(
+      &t, ldims, lqndiv, trunc_err, Dmin, Dmax,
+      &bu, &bs, &bvt, &btrunc_err_res, &bD,
+      decomp_type, thread_num
+  );
+
+  EXPECT_EQ(bD, D);
+  EXPECT_NEAR(btrunc_err_res, trunc_err_res, tol);
+  EXPECT_EQ(Div(bu), lqndiv);
+  EXPECT_EQ(Div(bvt), Div(t) - lqndiv);
+  auto svs = SortedDiagElems(s, D);
+  auto bsvs = SortedDiagElems(bs, bD);
+  for (size_t i = 0; i < D; ++i) { EXPECT_NEAR(bsvs[i], svs[i], tol); }
+
+  // The truncated tensors give the same low rank approximation.
+  TenT us, usvt, bus, busvt;
+  Contract(&u, &s, {{ldims}, {0}}, &us);
+  Contract(&us, &vt, {{ldims}, {0}}, &usvt);
+  Contract(&bu, &bs, {{ldims}, {0}}, &bus);
+  Contract(&bus, &bvt, {{ldims}, {0}}, &busvt);
+  for (auto &coors : GenAllCoors(usvt.GetShape())) {
+    EXPECT_NEAR(std::abs(busvt.GetElem(coors) - usvt.GetElem(coors)), 0.0, 100 * tol);
+  }
+}
+
+
+TEST_F(TestBlockParallelSVD, TwoSiteWaveFunction) {
+  DGQTensor dt({idx_vin, idx_pout, idx_pout, idx_vout});
+  srand(0);
+  dt.Random(qn0);
+  RunTestBlockParallelSVDCase(dt, 2, qn0, 0, 20, 20, 1);
+  RunTestBlockParallelSVDCase(dt, 2, qn0, 0, 20, 20, 4);
+  RunTestBlockParallelSVDCase(dt, 2, qnp1, 0, 20, 20, 4);
+  RunTestBlockParallelSVDCase(dt, 1, qn0, 0, 20, 20, 4);
+  RunTestBlockParallelSVDCase(dt, 3, qn0, 0, 20, 20, 4);
+  RunTestBlockParallelSVDCase(dt, 2, qn0, 1.0E-2, 1, 20, 4);
+  RunTestBlockParallelSVDCase(dt, 2, qn0, 1.0E-2, 8, 20, 4);
+  RunTestBlockParallelSVDCase(dt, 2, qn0, 1.0E-8, 1, 5, 4);
+
+  dt.Random(qnp1);
+  RunTestBlockParallelSVDCase(dt, 2, qn0, 0, 20, 20, 4);
+  RunTestBlockParallelSVDCase(dt, 2, qnp1, 1.0E-2, 1, 8, 4);
+
+  ZGQTensor zt({idx_vin, idx_pout, idx_pout, idx_vout});
+  zt.Random(qn0);
+  RunTestBlockParallelSVDCase(zt, 2, qn0, 0, 20, 20, 4);
+  RunTestBlockParallelSVDCase(zt, 2, qn0, 1.0E-2, 1, 20, 4);
+  RunTestBlockParallelSVDCase(zt, 2, qn0, 1.0E-8, 1, 5, 4);
+}
+
+
+// Random two-site wave function whose singular values decay exponentially,
+// so that the leading triplets are well separated from the others.
+template <typename TenElemT>
+GQTensor<TenElemT, QNT> DecayingTwoSiteWaveFunction(
+    const IndexT &idx_vin, const IndexT &idx_pout, const QNT &div
+) {
+  using TenT = GQTensor<TenElemT, QNT>;
+  auto idx_vout = InverseIndex(idx_vin);
+  TenT t({idx_vin, idx_pout, idx_pout, idx_vout});
+  t.Random(div);
+  TenT decay({idx_vin, idx_vout});
+  for (size_t i = 0; i < idx_vin.dim(); ++i) { decay({i, i}) = std::exp(-0.5 * i); }
+  TenT res;
+  Contract(&t, &decay, {{3}, {0}}, &res);
+  return res;
+}
+
+
+TEST_F(TestBlockParallelSVD, TruncatedBackends) {
+  IndexT idx_big_vin = IndexT(
+                           {QNSctT(qnm1, 12), QNSctT(qn0, 16), QNSctT(qnp1, 12)},
+                           GQTenIndexDirType::IN
+                       );
+  srand(0);
+  auto dt = DecayingTwoSiteWaveFunction<GQTEN_Double>(idx_big_vin, idx_pout, qn0);
+  auto zt = DecayingTwoSiteWaveFunction<GQTEN_Complex>(idx_big_vin, idx_pout, qn0);
+  for (auto decomp_type : {RANDOMIZED_SVD, DENSITY_MATRIX_EIG}) {
+    RunTestBlockParallelSVDCase(dt, 2, qn0, 0, 4, 4, 1, decomp_type, 1.0E-10);
+    RunTestBlockParallelSVDCase(dt, 2, qn0, 1.0E-2, 1, 6, 4, decomp_type, 1.0E-10);
+    RunTestBlockParallelSVDCase(dt, 1, qn0, 1.0E-8, 1, 3, 4, decomp_type, 1.0E-10);
+    RunTestBlockParallelSVDCase(dt, 2, qn0, 0, 80, 80, 4, decomp_type, 1.0E-10);
+    RunTestBlockParallelSVDCase(zt, 2, qn0, 0, 4, 4, 4, decomp_type, 1.0E-10);
+    RunTestBlockParallelSVDCase(zt, 2, qnp1, 1.0E-2, 1, 6, 4, decomp_type, 1.0E-10);
+  }
+}
+
+
+// The truncated backends only compute a part of the singular triplets of each
+// block and keep the same states as the full SVD.
+TEST_F(TestBlockParallelSVD, RankBudgets) {
+  IndexT idx_big_vin = IndexT(
+                           {QNSctT(qnm1, 30), QNSctT(qn0, 40), QNSctT(qnp1, 30)},
+                           GQTenIndexDirType::IN
+                       );
+  srand(0);
+  auto dt = DecayingTwoSiteWaveFunction<GQTEN_Double>(idx_big_vin, idx_pout, qn0);
+  std::vector<size_t> lshape, rshape;
+  auto blocks = mock_gqten::ExtractQNBlockMats(dt, 2, lshape, rshape);
+  ASSERT_GT(blocks.size(), 1);
+  auto full_blocks = blocks;
+  std::vector<mock_gqten::DenseSVDRes<GQTEN_Double>> full_res;
+  GQTEN_Double full_trunc_err;
+  size_t full_D;
+  auto full_kept_dims = mock_gqten::TruncatedDecompQNBlocks(
+                            full_blocks, 1.0E-10, 1, 16,
+                            full_res, &full_trunc_err, &full_D,
+                            FULL_SVD, 4
+                        );
+
+  for (auto decomp_type : {RANDOMIZED_SVD, DENSITY_MATRIX_EIG}) {
+    auto budget_blocks = blocks;
+    std::vector<mock_gqten::DenseSVDRes<GQTEN_Double>> res;
+    GQTEN_Double trunc_err;
+    size_t D;
+    auto kept_dims = mock_gqten::TruncatedDecompQNBlocks(
+                         budget_blocks, 1.0E-10, 1, 16,
+                         res, &trunc_err, &D,
+                         decomp_type, 4
+                     );
+    EXPECT_EQ(D, full_D);
+    EXPECT_NEAR(trunc_err, full_trunc_err, 1.0E-10);
+    EXPECT_EQ(kept_dims, full_kept_dims);
+    size_t computed = 0, full_rank = 0;
+    for (size_t b = 0; b < blocks.size(); ++b) {
+      auto block_full_rank = std::min(blocks[b].rows.size(), blocks[b].cols.size());
+      EXPECT_LT(res[b].s.size(), block_full_rank);
+      computed += res[b].s.size();
+      full_rank += block_full_rank;
+    }
+    EXPECT_LT(computed, full_rank);
+  }
+}
+
+
+TEST_F(TestBlockParallelSVD, DensityMatrixEigZeroRank) {
+  mock_gqten::QNBlockMat<GQTEN_Double, QNT> block;
+  block.rows = {0, 1, 2};
+  block.cols = {0, 1};
+  block.data = {1.0, 2.0, 3.0, 4.0, 5.0, 6.0};
+  auto res = mock_gqten::BlockDensityMatrixEig(block, 0);
+  EXPECT_TRUE(res.s.empty());
+  EXPECT_TRUE(res.u.empty());
+  EXPECT_TRUE(res.vt.empty());
+  EXPECT_NEAR(res.residual_weight, 91.0, 1.0E-12);
+}
+
+
+// Agreement with the native SVD of GraceQ/tensor on a two-site wave function
+// with D = 240.
+TEST_F(TestBlockParallelSVD, AgreeWithNativeSVD) {
+  IndexT idx_big_vin = IndexT(
+                           {QNSctT(qnm1, 70), QNSctT(qn0, 100), QNSctT(qnp1, 70)},
+                           GQTenIndexDirType::IN
+                       );
+  IndexT idx_big_vout = InverseIndex(idx_big_vin);
+  DGQTensor dt({idx_big_vin, idx_pout, idx_pout, idx_big_vout});
+  srand(0);
+  dt.Random(qn0);
+
+  DGQTensor u, vt, bu, bvt;
+  GQTensor<GQTEN_Double, QNT> s, bs;
+  GQTEN_Double trunc_err_res, btrunc_err_res;
+  size_t D, bD;
+  SVD(&dt, 2, qn0, 1.0E-10, 1, 240, &u, &s, &vt, &trunc_err_res, &D);
+  for (size_t thread_num : {1, 4}) {
+    mock_gqten::SVD(
+        &dt, 2, qn0, 1.0E-10, 1, 240,
+        &bu, &bs, &bvt, &btrunc_err_res, &bD,
+        thread_num
+    );
+    EXPECT_EQ(bD, D);
+    EXPECT_NEAR(btrunc_err_res, trunc_err_res, 1.0E-12);
+  }
+}
+
+
+template <typename TenElemT>
+void RunTestBlockQRLQCase(
+    const GQTensor<TenElemT, QNT> &t,
+    const size_t ldims,
+    const QNT &lqndiv,
+    const size_t thread_num,
+    const double tol = 1.0E-12
+) {
+  using TenT = GQTensor<TenElemT, QNT>;
+  std::vector<size_t> lctrct_axes;
+  for (size_t i = 0; i < ldims; ++i) { lctrct_axes.push_back(i); }
+
+  // T = Q R and Q has orthonormal columns.
+  TenT q, r, qr, qdagq;
+  mock_gqten::QR(&t, ldims, lqndiv, &q, &r, thread_num);
+  EXPECT_EQ(Div(q), lqndiv);
+  EXPECT_EQ(Div(r), Div(t) - lqndiv);
+  Contract(&q, &r, {{ldims}, {0}}, &qr);
+  for (auto &coors : GenAllCoors(t.GetShape())) {
+    EXPECT_NEAR(std::abs(qr.GetElem(coors) - t.GetElem(coors)), 0.0, 100 * tol);
+  }
+  auto q_dag = Dag(q);
+  Contract(&q_dag, &q, {lctrct_axes, lctrct_axes}, &qdagq);
+  auto qdim = qdagq.GetShape()[0];
+  for (size_t i = 0; i < qdim; ++i) {
+    for (size_t j = 0; j < qdim; ++j) {
+      EXPECT_NEAR(std::abs(qdagq.GetElem({i, j}) - TenElemT(i == j)), 0.0, tol);
+    }
+  }
+
+  // T = L Q and Q has orthonormal rows.
+  TenT l, lq, lqqdag;
+  mock_gqten::LQ(&t, ldims, lqndiv, &l, &q, thread_num);
+  EXPECT_EQ(Div(l), lqndiv);
+  EXPECT_EQ(Div(q), Div(t) - lqndiv);
+  Contract(&l, &q, {{ldims}, {0}}, &lq);
+  for (auto &coors : GenAllCoors(t.GetShape())) {
+    EXPECT_NEAR(std::abs(lq.GetElem(coors) - t.GetElem(coors)), 0.0, 100 * tol);
+  }
+  q_dag = Dag(q);
+  std::vector<size_t> q_rctrct_axes;
+  for (size_t i = 1; i < q.Rank(); ++i) { q_rctrct_axes.push_back(i); }
+  Contract(&q, &q_dag, {q_rctrct_axes, q_rctrct_axes}, &lqqdag);
+  qdim = lqqdag.GetShape()[0];
+  for (size_t i = 0; i < qdim; ++i) {
+    for (size_t j = 0; j < qdim; ++j) {
+      EXPECT_NEAR(std::abs(lqqdag.GetElem({i, j}) - TenElemT(i == j)), 0.0, tol);
+    }
+  }
+}
+
+
+TEST_F(TestBlockParallelSVD, QRAndLQ) {
+  DGQTensor dt({idx_vin, idx_pout, idx_vout});
+  srand(0);
+  dt.Random(qn0);
+  RunTestBlockQRLQCase(dt, 2, qn0, 1);
+  RunTestBlockQRLQCase(dt, 2, qn0, 4);
+  RunTestBlockQRLQCase(dt, 1, qnm1, 4);
+  RunTestBlockQRLQCase(dt, 1, qnp1, 4);
+
+  DGQTensor dt4({idx_vin, idx_pout, idx_pout, idx_vout});
+  dt4.Random(qnp1);
+  RunTestBlockQRLQCase(dt4, 2, qnp1, 4);
+  RunTestBlockQRLQCase(dt4, 1, qn0, 4);
+  RunTestBlockQRLQCase(dt4, 3, qnp1, 4);
+
+  ZGQTensor zt({idx_vin, idx_pout, idx_vout});
+  zt.Random(qn0);
+  RunTestBlockQRLQCase(zt, 2, qn0, 4);
+  RunTestBlockQRLQCase(zt, 1, qn0, 4);
+}
+
+
+TEST_F(TestBlockParallelSVD, QRAndLQLargeBond) {
+  IndexT idx_big_vin = IndexT(
+                           {QNSctT(qnm1, 70), QNSctT(qn0, 100), QNSctT(qnp1, 70)},
+                           GQTenIndexDirType::IN
+                       );
+  IndexT idx_big_vout = InverseIndex(idx_big_vin);
+  DGQTensor dt({idx_big_vin, idx_pout, idx_big_vout});
+  srand(0);
+  dt.Random(qn0);
+  auto norm = dt.Get2Norm();
+
+  for (size_t ldims : {2, 1}) {
+    for (size_t thread_num : {1, 4}) {
+      DGQTensor a, b, ab;
+      if (ldims == 2) {
+        mock_gqten::QR(&dt, ldims, qn0, &a, &b, thread_num);
+      } else {
+        mock_gqten::LQ(&dt, ldims, qn0, &a, &b, thread_num);
+      }
+      Contract(&a, &b, {{ldims}, {0}}, &ab);
+      auto diff = ab + (-dt);
+      EXPECT_NEAR(diff.Get2Norm(), 0.0, 1.0E-10 * norm);
+    }
+  }
+}
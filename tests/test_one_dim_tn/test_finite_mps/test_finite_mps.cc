@@ -7,10 +7,12 @@
 * Description: GraceQ/MPS2 project. Unittests for MPS .
 */
 #include "gqmps2/one_dim_tn/mps/finite_mps/finite_mps.h"
+#include "gqmps2/one_dim_tn/mps/finite_mps/finite_mps_overlap.h"
 #include "gqten/gqten.h"
 #include "gtest/gtest.h"
 
 #include <utility>    // move
+#include <cmath>      // abs
 
 using namespace gqmps2;
 using namespace gqten;
@@ -238,12 +240,58 @@ TEST_F(TestMPS, TestIO) {
   for (size_t i = 0; i < 5; ++i) {
     EXPECT_EQ(mps2[i], mps[i]);
   }
+  EXPECT_EQ(mps2.GetCenter(), mps.GetCenter());
+
+  mps.Centralize(2);
+  mps.Dump("mps4");
+  MPST mps4(SiteVecT(5, pb_out));
+  mps4.Load("mps4");
+  EXPECT_EQ(mps4.GetCenter(), 2);
+  EXPECT_EQ(mps4.GetTensCanoType(), mps.GetTensCanoType());
 
   mps.Dump("mps3", true);
   EXPECT_TRUE(mps.empty());
 }
 
 
+TEST_F(TestMPS, TestOverlap) {
+  auto norm2 = MPSOverlap(mps, mps);
+  EXPECT_GT(norm2, 0.0);
+  EXPECT_NEAR(MPSFidelity(mps, mps), 1.0, 1.0E-12);
+
+  // The overlap is invariant under the gauge transformations.
+  MPST mps2(mps);
+  mps2.Centralize(2);
+  EXPECT_NEAR(MPSOverlap(mps, mps2), norm2, 1.0E-12 * norm2);
+  EXPECT_NEAR(MPSOverlap(mps2, mps2), norm2, 1.0E-12 * norm2);
+
+  MPST mps3(mps);
+  mps3[2].Random(qn0);
+  auto overlap = MPSOverlap(mps, mps3);
+  EXPECT_NEAR(MPSOverlap(mps3, mps), overlap, 1.0E-12 * std::abs(overlap));
+  auto fidelity = MPSFidelity(mps, mps3);
+  EXPECT_LE(fidelity, 1.0 + 1.0E-12);
+
+  // Streamed from the disk.
+  mps.Dump("overlap_bra", true);
+  mps3.Dump("overlap_ket", true);
+  EXPECT_NEAR(
+      MPSOverlapOnDisk(mps, "overlap_bra", mps3, "overlap_ket"),
+      overlap,
+      1.0E-12 * std::abs(overlap)
+  );
+  EXPECT_TRUE(mps.empty());
+  EXPECT_TRUE(mps3.empty());
+  EXPECT_NEAR(
+      MPSFidelityOnDisk(mps, "overlap_bra", mps3, "overlap_ket"),
+      fidelity,
+      1.0E-12
+  );
+
+  mkl_free_buffers();
+}
+
+
 TEST_F(TestMPS, TestTruncate) {
   TruncateMPS(mps, 0, 1, 3);
 
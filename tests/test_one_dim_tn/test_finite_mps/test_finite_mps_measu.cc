@@ -6,10 +6,13 @@
 * Description: GraceQ/MPS2 project. Unittest for finite MPS measurements.
 */
 #include "gqmps2/one_dim_tn/mps_all.h"
+#include "gqmps2/one_dim_tn/mpo/mpogen/mpogen.h"
 #include "gqten/gqten.h"
+#include "gqmps2/third_party/nlohmann/json.hpp"
 
 #include "gtest/gtest.h"
 #include <stdlib.h>
+#include <fstream>
 
 using namespace gqmps2;
 using namespace gqten;
@@ -170,6 +173,706 @@ TEST_F(TestMpsMeasurement, TestMeasureTwoSiteOp) {
 }
 
 
+TEST_F(TestMpsMeasurement, TestMeasureAllPairsTwoSiteOp) {
+  // All pairs in a shuffled order, which share the head site transfer tensors.
+  std::vector<std::vector<size_t>> sites_set;
+  for (long j = N - 1; j > 0; --j) {
+    for (long i = 0; i < j; ++i) {
+      sites_set.push_back({size_t(i), size_t(j)});
+    }
+  }
+  std::vector<GQTEN_Double> dres;
+  std::vector<GQTEN_Complex> zres;
+  for (auto &sites : sites_set) {
+    dres.push_back(stat_labs2[sites[0]] * stat_labs2[sites[1]]);
+    zres.push_back(dres.back());
+  }
+
+  DirectStateInitMps(dmps, stat_labs2, qn0);
+  RunTestMeasureTwoSiteOpCase(dmps, {dntot, dntot}, did, sites_set, dres);
+  DirectStateInitMps(zmps, stat_labs2, qn0);
+  RunTestMeasureTwoSiteOpCase(zmps, {zntot, zntot}, zid, sites_set, zres);
+}
+
+
+TEST_F(TestMpsMeasurement, TestMeasureIdentityTails) {
+  // Operator strings with identity physical operators and identity tails.
+  std::vector<std::vector<size_t>> sites_set = {{0, 2, 3}, {0, 2, 3}, {1, 4, 5}};
+  TenVV<GQTEN_Double, U1QN> dphys_ops_set = {
+      {dntot, dntot, did}, {dntot, did, dntot}, {did, dntot, did}
+  };
+  TenVVV<GQTEN_Double, U1QN> dinst_ops_set_set(3, {{did}, {}, {did, did}});
+  dinst_ops_set_set[2] = {{did, did}, {}};
+  TenVV<GQTEN_Complex, U1QN> zphys_ops_set = {
+      {zntot, zntot, zid}, {zntot, zid, zntot}, {zid, zntot, zid}
+  };
+  TenVVV<GQTEN_Complex, U1QN> zinst_ops_set_set(3, {{zid}, {}, {zid, zid}});
+  zinst_ops_set_set[2] = {{zid, zid}, {}};
+  std::vector<size_t> stat_labs3 = {1, 0, 1, 1, 0, 1};
+  std::vector<GQTEN_Double> res = {1, 1, 0};
+
+  DirectStateInitMps(dmps, stat_labs3, qn0);
+  auto dmeasu_res = MeasureMultiSiteOp(
+                        dmps, dphys_ops_set, dinst_ops_set_set, sites_set,
+                        "id_tails"
+                    );
+  DirectStateInitMps(zmps, stat_labs3, qn0);
+  auto zmeasu_res = MeasureMultiSiteOp(
+                        zmps, zphys_ops_set, zinst_ops_set_set, sites_set,
+                        "id_tails"
+                    );
+  for (size_t i = 0; i < sites_set.size(); ++i) {
+    EXPECT_EQ(dmeasu_res[i].sites, sites_set[i]);
+    ExpectDoubleEq(dmeasu_res[i].avg, res[i]);
+    ExpectDoubleEq(zmeasu_res[i].avg, GQTEN_Complex(res[i]));
+  }
+}
+
+
+// Random canonicalized MPS with bond dimension 4.
+template <typename TenElemT, typename QNT>
+void RandomInitMps(
+    FiniteMPS<TenElemT, QNT> &mps,
+    const std::vector<size_t> &stat_labs,
+    const QNT &qn0
+) {
+  std::vector<size_t> flipped_stat_labs;
+  for (auto stat_lab : stat_labs) { flipped_stat_labs.push_back(1 - stat_lab); }
+  srand(0);
+  ExtendDirectRandomInitMps(mps, {stat_labs, flipped_stat_labs}, qn0, 2);
+}
+
+
+template <typename TenElemT, typename QNT>
+void RunTestMeasureSharedTransferCase(
+    FiniteMPS<TenElemT, QNT> &mps,
+    const GQTensor<TenElemT, QNT> &ntot,
+    const GQTensor<TenElemT, QNT> &id
+) {
+  auto N = mps.size();
+  // All pairs in a shuffled order share the head site transfer tensors, the
+  // baseline measures each pair alone.
+  std::vector<std::vector<size_t>> sites_set;
+  for (size_t j = N - 1; j > 0; --j) {
+    for (size_t i = 0; i < j; ++i) { sites_set.push_back({i, j}); }
+  }
+  auto measu_res = MeasureTwoSiteOp(mps, {ntot, ntot}, id, sites_set, "op1op2");
+  for (size_t i = 0; i < sites_set.size(); ++i) {
+    auto benchmark = MeasureTwoSiteOp(
+                         mps, {ntot, ntot}, id, {sites_set[i]}, "op1op2"
+                     );
+    EXPECT_EQ(measu_res[i].sites, sites_set[i]);
+    EXPECT_NEAR(std::abs(measu_res[i].avg - benchmark[0].avg), 0.0, 1.0E-12);
+  }
+
+  // Identity operators and identity tails are skipped.
+  auto one_site_res = MeasureOneSiteOp(mps, ntot, "op1");
+  auto two_site_res = MeasureTwoSiteOp(
+                          mps, {ntot, ntot}, id, {{0, 2}, {0, 3}}, "op1op2"
+                      );
+  auto multi_site_res = MeasureMultiSiteOp(
+                            mps,
+                            TenVV<TenElemT, QNT>({
+                                {ntot, ntot, id}, {ntot, id, ntot}, {id, ntot, id}
+                            }),
+                            TenVVV<TenElemT, QNT>({
+                                {{id}, {}, {id, id}},
+                                {{id}, {}, {id, id}},
+                                {{id, id}, {}}
+                            }),
+                            {{0, 2, 3}, {0, 2, 3}, {1, 4, 5}},
+                            "id_tails"
+                        );
+  EXPECT_NEAR(std::abs(multi_site_res[0].avg - two_site_res[0].avg), 0.0, 1.0E-12);
+  EXPECT_NEAR(std::abs(multi_site_res[1].avg - two_site_res[1].avg), 0.0, 1.0E-12);
+  EXPECT_NEAR(std::abs(multi_site_res[2].avg - one_site_res[4].avg), 0.0, 1.0E-12);
+  // The MPS is entangled, so the correlation is not a product of densities.
+  EXPECT_GT(
+      std::abs(two_site_res[0].avg - one_site_res[0].avg * one_site_res[2].avg),
+      1.0E-8
+  );
+
+  mkl_free_buffers();
+}
+
+
+TEST_F(TestMpsMeasurement, TestMeasureSharedTransferRandomMps) {
+  RandomInitMps(dmps, stat_labs2, qn0);
+  RunTestMeasureSharedTransferCase(dmps, dntot, did);
+  RandomInitMps(zmps, stat_labs2, qn0);
+  RunTestMeasureSharedTransferCase(zmps, zntot, zid);
+}
+
+
+template <typename TenElemT, typename QNT>
+void RunTestMeasuPlannerCase(
+    FiniteMPS<TenElemT, QNT> &mps,
+    const GQTensor<TenElemT, QNT> &ntot,
+    const GQTensor<TenElemT, QNT> &id,
+    const std::vector<size_t> &stat_labs
+) {
+  using TenT = GQTensor<TenElemT, QNT>;
+  auto N = mps.size();
+  std::vector<std::vector<size_t>> two_site_sites_set = {{3, 5}, {0, 4}, {1, 2}, {0, 1}};
+  std::vector<std::vector<size_t>> multi_site_sites_set = {{2, 3, 5}, {0, 2, 3}};
+  MeasuPlanner<TenElemT, QNT> planner;
+  auto one_site_req = planner.AddOneSiteOp(ntot, N, "op1");
+  auto two_site_req = planner.AddTwoSiteOp(
+                          {ntot, ntot}, id, two_site_sites_set, "op1op2"
+                      );
+  auto multi_site_req = planner.AddMultiSiteOp(
+                            TenVV<TenElemT, QNT>(2, {ntot, ntot, ntot}),
+                            TenVV<TenElemT, QNT>(2, std::vector<TenT>{id, id}),
+                            multi_site_sites_set,
+                            "op1op2op3"
+                        );
+  EXPECT_EQ(planner.size(), size_t(3));
+  auto measu_res_set = planner.Measure(mps);
+  EXPECT_EQ(measu_res_set.size(), size_t(3));
+
+  for (size_t i = 0; i < N; ++i) {
+    EXPECT_EQ(measu_res_set[one_site_req][i].sites, std::vector<size_t>({i}));
+    ExpectDoubleEq(measu_res_set[one_site_req][i].avg, TenElemT(stat_labs[i]));
+  }
+  for (size_t i = 0; i < two_site_sites_set.size(); ++i) {
+    auto &sites = two_site_sites_set[i];
+    EXPECT_EQ(measu_res_set[two_site_req][i].sites, sites);
+    ExpectDoubleEq(
+        measu_res_set[two_site_req][i].avg,
+        TenElemT(stat_labs[sites[0]] * stat_labs[sites[1]])
+    );
+  }
+  for (size_t i = 0; i < multi_site_sites_set.size(); ++i) {
+    auto &sites = multi_site_sites_set[i];
+    ExpectDoubleEq(
+        measu_res_set[multi_site_req][i].avg,
+        TenElemT(stat_labs[sites[0]] * stat_labs[sites[1]] * stat_labs[sites[2]])
+    );
+  }
+
+  mkl_free_buffers();
+}
+
+
+TEST_F(TestMpsMeasurement, TestMeasuPlanner) {
+  std::vector<size_t> stat_labs3 = {1, 0, 1, 1, 0, 1};
+  DirectStateInitMps(dmps, stat_labs1, qn0);
+  RunTestMeasuPlannerCase(dmps, dntot, did, stat_labs1);
+  DirectStateInitMps(dmps, stat_labs3, qn0);
+  RunTestMeasuPlannerCase(dmps, dntot, did, stat_labs3);
+  DirectStateInitMps(zmps, stat_labs3, qn0);
+  RunTestMeasuPlannerCase(zmps, zntot, zid, stat_labs3);
+}
+
+
+template <typename TenElemT, typename QNT>
+void RunTestMeasureOnDiskCase(
+    FiniteMPS<TenElemT, QNT> &mps,
+    const GQTensor<TenElemT, QNT> &ntot,
+    const GQTensor<TenElemT, QNT> &id,
+    const std::vector<size_t> &stat_labs
+) {
+  auto N = mps.size();
+  std::string mps_path = "disk_mps";
+  if (!IsPathExist(mps_path)) { CreatPath(mps_path); }
+  mps.Dump(mps_path, true);
+
+  auto one_site_res = MeasureOneSiteOpOnDisk(mps, ntot, mps_path, "op1");
+  EXPECT_TRUE(mps.empty());
+  for (size_t i = 0; i < N; ++i) {
+    ExpectDoubleEq(one_site_res[i].avg, TenElemT(stat_labs[i]));
+  }
+
+  std::vector<std::vector<size_t>> sites_set = {{3, 5}, {0, 4}, {1, 2}, {0, 1}, {0, 5}};
+  auto two_site_res = MeasureTwoSiteOpOnDisk(
+                          mps, {ntot, ntot}, id, sites_set, mps_path, "op1op2"
+                      );
+  EXPECT_TRUE(mps.empty());
+  for (size_t i = 0; i < sites_set.size(); ++i) {
+    auto &sites = sites_set[i];
+    EXPECT_EQ(two_site_res[i].sites, sites);
+    ExpectDoubleEq(
+        two_site_res[i].avg,
+        TenElemT(stat_labs[sites[0]] * stat_labs[sites[1]])
+    );
+  }
+
+  auto multi_site_res = MeasureMultiSiteOpOnDisk(
+                            mps,
+                            TenVV<TenElemT, QNT>(1, {ntot, ntot, ntot}),
+                            TenVVV<TenElemT, QNT>(1, {{id}, {}, {id, id}}),
+                            {{0, 2, 3}},
+                            mps_path,
+                            "op1op2op3"
+                        );
+  EXPECT_TRUE(mps.empty());
+  ExpectDoubleEq(
+      multi_site_res[0].avg,
+      TenElemT(stat_labs[0] * stat_labs[2] * stat_labs[3])
+  );
+
+  mkl_free_buffers();
+}
+
+
+TEST_F(TestMpsMeasurement, TestMeasureOnDisk) {
+  std::vector<size_t> stat_labs3 = {1, 1, 0, 1, 0, 1};
+  std::vector<size_t> stat_labs4 = {1, 0, 1, 1, 0, 1};
+  for (auto &stat_labs : {stat_labs3, stat_labs4}) {
+    DirectStateInitMps(dmps, stat_labs, qn0);
+    RunTestMeasureOnDiskCase(dmps, dntot, did, stat_labs);
+    DirectStateInitMps(zmps, stat_labs, qn0);
+    RunTestMeasureOnDiskCase(zmps, zntot, zid, stat_labs);
+  }
+}
+
+
+template <typename TenElemT, typename QNT>
+void RunTestMeasureParallelCase(
+    FiniteMPS<TenElemT, QNT> &mps,
+    const GQTensor<TenElemT, QNT> &ntot,
+    const GQTensor<TenElemT, QNT> &id,
+    const std::vector<size_t> &stat_labs,
+    const size_t thread_num
+) {
+  auto N = mps.size();
+  auto one_site_res_set = MeasureOneSiteOp(
+                              mps, {ntot, id}, {"op1", "id"}, thread_num
+                          );
+  EXPECT_EQ(one_site_res_set.size(), size_t(2));
+  for (size_t i = 0; i < N; ++i) {
+    EXPECT_EQ(one_site_res_set[0][i].sites, std::vector<size_t>({i}));
+    ExpectDoubleEq(one_site_res_set[0][i].avg, TenElemT(stat_labs[i]));
+    ExpectDoubleEq(one_site_res_set[1][i].avg, TenElemT(1.0));
+  }
+
+  std::vector<std::vector<size_t>> sites_set;
+  for (long j = N - 1; j > 0; --j) {
+    for (long i = 0; i < j; ++i) {
+      sites_set.push_back({size_t(i), size_t(j)});
+    }
+  }
+  auto two_site_res = MeasureTwoSiteOp(
+                          mps, {ntot, ntot}, id, sites_set, "op1op2", thread_num
+                      );
+  for (size_t i = 0; i < sites_set.size(); ++i) {
+    auto &sites = sites_set[i];
+    EXPECT_EQ(two_site_res[i].sites, sites);
+    ExpectDoubleEq(
+        two_site_res[i].avg,
+        TenElemT(stat_labs[sites[0]] * stat_labs[sites[1]])
+    );
+  }
+
+  std::vector<std::vector<size_t>> multi_site_sites_set = {{2, 3, 5}, {0, 2, 3}};
+  auto multi_site_res = MeasureMultiSiteOp(
+                            mps,
+                            TenVV<TenElemT, QNT>(2, {ntot, ntot, ntot}),
+                            TenVVV<TenElemT, QNT>(2, {{id}, {}, {id}}),
+                            multi_site_sites_set,
+                            "op1op2op3",
+                            thread_num
+                        );
+  for (size_t i = 0; i < multi_site_sites_set.size(); ++i) {
+    auto &sites = multi_site_sites_set[i];
+    ExpectDoubleEq(
+        multi_site_res[i].avg,
+        TenElemT(stat_labs[sites[0]] * stat_labs[sites[1]] * stat_labs[sites[2]])
+    );
+  }
+
+  mkl_free_buffers();
+}
+
+
+TEST_F(TestMpsMeasurement, TestMeasureParallel) {
+  std::vector<size_t> stat_labs3 = {1, 0, 1, 1, 0, 1};
+  for (size_t thread_num : {1, 4}) {
+    DirectStateInitMps(dmps, stat_labs3, qn0);
+    RunTestMeasureParallelCase(dmps, dntot, did, stat_labs3, thread_num);
+    DirectStateInitMps(zmps, stat_labs3, qn0);
+    RunTestMeasureParallelCase(zmps, zntot, zid, stat_labs3, thread_num);
+  }
+}
+
+
+template <typename TenElemT, typename QNT>
+void RunTestMeasureParallelRandomMpsCase(
+    FiniteMPS<TenElemT, QNT> &mps,
+    const GQTensor<TenElemT, QNT> &ntot,
+    const GQTensor<TenElemT, QNT> &id
+) {
+  auto N = mps.size();
+  std::vector<std::vector<size_t>> sites_set;
+  for (size_t j = N - 1; j > 0; --j) {
+    for (size_t i = 0; i < j; ++i) { sites_set.push_back({i, j}); }
+  }
+  auto serial_res = MeasureTwoSiteOp(mps, {ntot, ntot}, id, sites_set, "op1op2");
+  std::vector<std::vector<size_t>> multi_site_sites_set = {
+      {2, 3, 5}, {0, 2, 3}, {1, 4, 5}, {0, 1, 2}
+  };
+  auto multi_site_serial_res = MeasureMultiSiteOp(
+                                   mps,
+                                   TenVV<TenElemT, QNT>(4, {ntot, ntot, ntot}),
+                                   TenVVV<TenElemT, QNT>(4, {{id}, {}, {id}}),
+                                   multi_site_sites_set,
+                                   "op1op2op3"
+                               );
+  for (size_t thread_num : {2, 3, 4, 8}) {
+    auto parallel_res = MeasureTwoSiteOp(
+                            mps, {ntot, ntot}, id, sites_set, "op1op2", thread_num
+                        );
+    for (size_t i = 0; i < sites_set.size(); ++i) {
+      EXPECT_EQ(parallel_res[i].sites, sites_set[i]);
+      EXPECT_NEAR(
+          std::abs(parallel_res[i].avg - serial_res[i].avg), 0.0, 1.0E-12
+      );
+    }
+    auto multi_site_parallel_res = MeasureMultiSiteOp(
+                                       mps,
+                                       TenVV<TenElemT, QNT>(4, {ntot, ntot, ntot}),
+                                       TenVVV<TenElemT, QNT>(4, {{id}, {}, {id}}),
+                                       multi_site_sites_set,
+                                       "op1op2op3",
+                                       thread_num
+                                   );
+    for (size_t i = 0; i < multi_site_sites_set.size(); ++i) {
+      EXPECT_NEAR(
+          std::abs(multi_site_parallel_res[i].avg - multi_site_serial_res[i].avg),
+          0.0, 1.0E-12
+      );
+    }
+  }
+
+  mkl_free_buffers();
+}
+
+
+TEST_F(TestMpsMeasurement, TestMeasureParallelRandomMps) {
+  RandomInitMps(dmps, stat_labs2, qn0);
+  RunTestMeasureParallelRandomMpsCase(dmps, dntot, did);
+  RandomInitMps(zmps, stat_labs2, qn0);
+  RunTestMeasureParallelRandomMpsCase(zmps, zntot, zid);
+}
+
+
+template <typename TenElemT, typename QNT>
+void RunTestMeasureEntanglementProfileCase(FiniteMPS<TenElemT, QNT> &mps) {
+  auto N = mps.size();
+  auto ent_profile = MeasureEntanglementProfile(mps, {0.5, 2.0}, "ee");
+  EXPECT_EQ(ent_profile.size(), N - 1);
+  EXPECT_EQ(mps.GetCenter(), int(N - 1));
+  for (size_t i = 0; i < N - 1; ++i) {
+    auto &bond_ent = ent_profile[i];
+    EXPECT_EQ(bond_ent.bond, i);
+    EXPECT_NEAR(bond_ent.ee, 0.0, 1.0E-12);
+    EXPECT_EQ(bond_ent.renyi_ees.size(), size_t(2));
+    for (auto renyi_ee : bond_ent.renyi_ees) {
+      EXPECT_NEAR(renyi_ee, 0.0, 1.0E-12);
+    }
+    EXPECT_EQ(bond_ent.spec.size(), size_t(1));
+    EXPECT_EQ(bond_ent.spec[0].svs.size(), size_t(1));
+    EXPECT_NEAR(bond_ent.spec[0].svs[0], 1.0, 1.0E-12);
+  }
+
+  mkl_free_buffers();
+}
+
+
+TEST_F(TestMpsMeasurement, TestMeasureEntanglementProfile) {
+  // Product states have no entanglement on every bond.
+  DirectStateInitMps(dmps, stat_labs1, qn0);
+  RunTestMeasureEntanglementProfileCase(dmps);
+  DirectStateInitMps(dmps, stat_labs2, qn0);
+  RunTestMeasureEntanglementProfileCase(dmps);
+  DirectStateInitMps(zmps, stat_labs2, qn0);
+  RunTestMeasureEntanglementProfileCase(zmps);
+}
+
+
+// Product of the dimers a_k|10> + b_k|01> on the sites (2k, 2k+1), one particle
+// per dimer. The right virtual bond carries the particle number on its right.
+template <typename TenElemT, typename QNT>
+void DimerInitMps(
+    FiniteMPS<TenElemT, QNT> &mps,
+    const std::vector<std::pair<double, double>> &amps
+) {
+  using TenT = GQTensor<TenElemT, QNT>;
+  using IndexT = Index<QNT>;
+  using QNSctT = QNSector<QNT>;
+  auto N = mps.size();
+  assert(N == 2 * amps.size());
+  for (size_t i = 0; i < N; ++i) { mps.dealloc(i); }
+  auto pb_out_set = mps.GetSitesInfo().sites;
+  auto NQN = [](const long n) { return QNT({QNCard("N", U1QNVal(n))}); };
+  long n_right = amps.size();
+  IndexT lvb;
+  for (size_t k = 0; k < amps.size(); ++k) {
+    auto a = amps[k].first, b = amps[k].second;
+    // Site 2k, coordinate 0 of the right bond is the occupied site.
+    auto rvb = IndexT(
+                   {QNSctT(NQN(n_right - 1), 1), QNSctT(NQN(n_right), 1)},
+                   GQTenIndexDirType::OUT
+               );
+    if (k == 0) {
+      mps(0) = new TenT({pb_out_set[0], rvb});
+      mps[0]({1, 0}) = a;
+      mps[0]({0, 1}) = b;
+    } else {
+      mps(2*k) = new TenT({lvb, pb_out_set[2*k], rvb});
+      mps[2*k]({0, 1, 0}) = a;
+      mps[2*k]({0, 0, 1}) = b;
+    }
+    n_right--;
+    // Site 2k+1 takes the particle if the site 2k is empty.
+    lvb = InverseIndex(rvb);
+    if (k == amps.size() - 1) {
+      mps(2*k + 1) = new TenT({lvb, pb_out_set[2*k + 1]});
+      mps[2*k + 1]({0, 0}) = 1;
+      mps[2*k + 1]({1, 1}) = 1;
+    } else {
+      rvb = IndexT({QNSctT(NQN(n_right), 1)}, GQTenIndexDirType::OUT);
+      mps(2*k + 1) = new TenT({lvb, pb_out_set[2*k + 1], rvb});
+      mps[2*k + 1]({0, 0, 0}) = 1;
+      mps[2*k + 1]({1, 1, 0}) = 1;
+      lvb = InverseIndex(rvb);
+    }
+  }
+  mps.Centralize(0);
+}
+
+
+template <typename TenElemT, typename QNT>
+void RunTestMeasureDimerEntanglementProfileCase(FiniteMPS<TenElemT, QNT> &mps) {
+  // Dimers (0.8, 0.6), (0.6, -0.8) and (1, 1)/sqrt(2) on the sites (0, 1),
+  // (2, 3) and (4, 5).
+  auto r = 1.0 / std::sqrt(2.0);
+  DimerInitMps(mps, {{0.8, 0.6}, {0.6, -0.8}, {r, r}});
+  auto ent_profile = MeasureEntanglementProfile(mps, {0.5, 2.0}, "dimer_ee");
+  EXPECT_EQ(ent_profile.size(), size_t(5));
+
+  // Inside a dimer the Schmidt values are |a| and |b|, in the sectors with
+  // N - 1 and N particles on the right, where N is the number of the dimers on
+  // the right of the bond, including the cut one. S = -sum p ln p,
+  // S_1/2 = 2 ln sum sqrt(p), S_2 = -ln sum p^2.
+  struct DimerBond {
+    size_t bond;
+    double sv_occ, sv_emp;    // Site on the left of the bond is occupied/empty.
+    long n_right;
+  };
+  std::vector<DimerBond> dimer_bonds = {{0, 0.8, 0.6, 3}, {2, 0.6, 0.8, 2}, {4, r, r, 1}};
+  for (auto &dimer_bond : dimer_bonds) {
+    auto &bond_ent = ent_profile[dimer_bond.bond];
+    EXPECT_EQ(bond_ent.bond, dimer_bond.bond);
+    auto p1 = dimer_bond.sv_occ * dimer_bond.sv_occ;
+    auto p2 = dimer_bond.sv_emp * dimer_bond.sv_emp;
+    EXPECT_NEAR(bond_ent.ee, -p1 * std::log(p1) - p2 * std::log(p2), 1.0E-12);
+    EXPECT_NEAR(
+        bond_ent.renyi_ees[0],
+        2 * std::log(dimer_bond.sv_occ + dimer_bond.sv_emp),
+        1.0E-12
+    );
+    EXPECT_NEAR(bond_ent.renyi_ees[1], -std::log(p1 * p1 + p2 * p2), 1.0E-12);
+    ASSERT_EQ(bond_ent.spec.size(), size_t(2));
+    for (auto &sct : bond_ent.spec) {
+      ASSERT_EQ(sct.svs.size(), size_t(1));
+      if (sct.qn == QNT({QNCard("N", U1QNVal(dimer_bond.n_right - 1))})) {
+        EXPECT_NEAR(sct.svs[0], dimer_bond.sv_occ, 1.0E-12);
+      } else {
+        EXPECT_EQ(sct.qn, QNT({QNCard("N", U1QNVal(dimer_bond.n_right))}));
+        EXPECT_NEAR(sct.svs[0], dimer_bond.sv_emp, 1.0E-12);
+      }
+    }
+  }
+  // The maximally entangled dimer has S = S_n = ln 2.
+  for (auto renyi_ee : ent_profile[4].renyi_ees) {
+    EXPECT_NEAR(renyi_ee, std::log(2.0), 1.0E-12);
+  }
+
+  // Between the dimers the state is a product one.
+  for (size_t bond : {1, 3}) {
+    auto &bond_ent = ent_profile[bond];
+    EXPECT_NEAR(bond_ent.ee, 0.0, 1.0E-12);
+    ASSERT_EQ(bond_ent.spec.size(), size_t(1));
+    EXPECT_EQ(bond_ent.spec[0].qn, QNT({QNCard("N", U1QNVal(bond == 1 ? 2 : 1))}));
+    EXPECT_NEAR(bond_ent.spec[0].svs[0], 1.0, 1.0E-12);
+  }
+
+  // The dumped spectrum of each bond is resolved by the quantum numbers.
+  std::ifstream ifs("dimer_ee.json");
+  nlohmann::json dumped;
+  ifs >> dumped;
+  ASSERT_EQ(dumped.size(), ent_profile.size());
+  for (size_t i = 0; i < ent_profile.size(); ++i) {
+    auto &spec = ent_profile[i].spec;
+    auto &dumped_spec = dumped[i][3];
+    EXPECT_EQ(dumped[i][0].get<size_t>(), i);
+    ASSERT_EQ(dumped_spec.size(), spec.size());
+    for (size_t q = 0; q < spec.size(); ++q) {
+      ASSERT_EQ(dumped_spec[q].size(), size_t(2));
+      EXPECT_TRUE(dumped_spec[q][0].is_array());
+      ASSERT_EQ(dumped_spec[q][1].size(), spec[q].svs.size());
+      for (size_t k = 0; k < spec[q].svs.size(); ++k) {
+        EXPECT_NEAR(dumped_spec[q][1][k].get<double>(), spec[q].svs[k], 1.0E-10);
+      }
+    }
+  }
+
+  mkl_free_buffers();
+}
+
+
+TEST_F(TestMpsMeasurement, TestMeasureDimerEntanglementProfile) {
+  RunTestMeasureDimerEntanglementProfileCase(dmps);
+  RunTestMeasureDimerEntanglementProfileCase(zmps);
+}
+
+
+template <typename TenElemT, typename QNT>
+void RunTestMeasureMPOExpectationCase(
+    FiniteMPS<TenElemT, QNT> &mps,
+    const GQTensor<TenElemT, QNT> &ntot,
+    const QNT &qn0,
+    const std::vector<size_t> &stat_labs
+) {
+  auto N = mps.size();
+  // H = \sum_{i} n_{i} + \sum_{i} n_{i} n_{i+1}
+  MPOGenerator<TenElemT, QNT> mpo_gen(mps.GetSitesInfo(), qn0);
+  TenElemT bchmk_avg = 0;
+  for (size_t i = 0; i < N; ++i) {
+    mpo_gen.AddTerm(1.0, ntot, i);
+    bchmk_avg += TenElemT(stat_labs[i]);
+    if (i < N - 1) {
+      mpo_gen.AddTerm(1.0, ntot, i, ntot, i + 1);
+      bchmk_avg += TenElemT(stat_labs[i] * stat_labs[i + 1]);
+    }
+  }
+  auto mpo = mpo_gen.Gen();
+
+  // Eigenstate of H, the variance vanishes.
+  auto res = MeasureMPOExpectation(mps, mpo);
+  ExpectDoubleEq(res.avg, bchmk_avg);
+  ExpectDoubleEq(res.avg2, bchmk_avg * bchmk_avg);
+  EXPECT_NEAR(res.var, 0.0, 1.0E-12);
+
+  std::string mps_path = "mpo_measu_mps";
+  if (!IsPathExist(mps_path)) { CreatPath(mps_path); }
+  mps.Dump(mps_path, true);
+  auto disk_res = MeasureMPOExpectationOnDisk(mps, mpo, mps_path);
+  EXPECT_TRUE(mps.empty());
+  ExpectDoubleEq(disk_res.avg, bchmk_avg);
+  ExpectDoubleEq(disk_res.avg2, bchmk_avg * bchmk_avg);
+  EXPECT_NEAR(disk_res.var, 0.0, 1.0E-12);
+
+  mkl_free_buffers();
+}
+
+
+TEST_F(TestMpsMeasurement, TestMeasureMPOExpectation) {
+  std::vector<size_t> stat_labs3 = {1, 1, 0, 1, 0, 1};
+  for (auto &stat_labs : {stat_labs1, stat_labs2, stat_labs3}) {
+    DirectStateInitMps(dmps, stat_labs, qn0);
+    RunTestMeasureMPOExpectationCase(dmps, dntot, qn0, stat_labs);
+    DirectStateInitMps(zmps, stat_labs, qn0);
+    RunTestMeasureMPOExpectationCase(zmps, zntot, qn0, stat_labs);
+  }
+}
+
+
+template <typename TenElemT, typename QNT>
+void RunTestMeasureDimerMPOExpectationCase(
+    FiniteMPS<TenElemT, QNT> &mps,
+    const GQTensor<TenElemT, QNT> &ntot,
+    const QNT &qn0
+) {
+  // H = \sum_{i} (i + 1) n_{i} on the dimers a_k|10> + b_k|01>. In a dimer
+  // n_{2k+1} = 1 - n_{2k}, the dimers are independent, so
+  // <H> = \sum_{k} (2k + 1) a_k^2 + (2k + 2) b_k^2 and Var(H) = \sum_{k} a_k^2 b_k^2.
+  auto r = 1.0 / std::sqrt(2.0);
+  std::vector<std::pair<double, double>> amps = {{0.8, 0.6}, {0.6, -0.8}, {r, r}};
+  DimerInitMps(mps, amps);
+  auto N = mps.size();
+  MPOGenerator<TenElemT, QNT> mpo_gen(mps.GetSitesInfo(), qn0);
+  for (size_t i = 0; i < N; ++i) { mpo_gen.AddTerm(i + 1.0, ntot, i); }
+  auto mpo = mpo_gen.Gen();
+  double bchmk_avg = 0, bchmk_var = 0;
+  for (size_t k = 0; k < amps.size(); ++k) {
+    auto p_occ = amps[k].first * amps[k].first;
+    auto p_emp = amps[k].second * amps[k].second;
+    bchmk_avg += (2 * k + 1) * p_occ + (2 * k + 2) * p_emp;
+    bchmk_var += p_occ * p_emp;
+  }
+
+  auto res = MeasureMPOExpectation(mps, mpo);
+  EXPECT_NEAR(std::abs(res.avg - TenElemT(bchmk_avg)), 0.0, 1.0E-12);
+  EXPECT_NEAR(
+      std::abs(res.avg2 - TenElemT(bchmk_var + bchmk_avg * bchmk_avg)),
+      0.0, 1.0E-12
+  );
+  EXPECT_NEAR(res.var, bchmk_var, 1.0E-12);
+
+  std::string mps_path = "mpo_measu_mps";
+  if (!IsPathExist(mps_path)) { CreatPath(mps_path); }
+  mps.Dump(mps_path, true);
+  auto disk_res = MeasureMPOExpectationOnDisk(mps, mpo, mps_path);
+  EXPECT_NEAR(std::abs(disk_res.avg - TenElemT(bchmk_avg)), 0.0, 1.0E-12);
+  EXPECT_NEAR(disk_res.var, bchmk_var, 1.0E-12);
+
+  mkl_free_buffers();
+}
+
+
+TEST_F(TestMpsMeasurement, TestMeasureDimerMPOExpectation) {
+  // Not an eigenstate of H, the variance does not vanish.
+  RunTestMeasureDimerMPOExpectationCase(dmps, dntot, qn0);
+  RunTestMeasureDimerMPOExpectationCase(zmps, zntot, qn0);
+}
+
+
+template <typename AvgT>
+void RunTestMeasuResBinaryIOCase(const MeasuRes<AvgT> &res) {
+  DumpMeasuRes(res, "measu_res_bin", MEASU_RES_BINARY);
+  auto loaded_res = LoadMeasuResBinary<AvgT>("measu_res_bin");
+  EXPECT_EQ(loaded_res.size(), res.size());
+  for (size_t i = 0; i < res.size(); ++i) {
+    EXPECT_EQ(loaded_res[i].sites, res[i].sites);
+    EXPECT_EQ(loaded_res[i].avg, res[i].avg);
+  }
+}
+
+
+TEST_F(TestMpsMeasurement, TestMeasuResBinaryIO) {
+  std::vector<std::vector<size_t>> sites_set = {
+      {3, 5}, {0, 4}, {1, 2, 7}, {1000}, {200, 201, 100000}, {0, 1}
+  };
+  MeasuRes<GQTEN_Double> dres;
+  MeasuRes<GQTEN_Complex> zres;
+  for (size_t i = 0; i < sites_set.size(); ++i) {
+    dres.push_back(MeasuResElem<GQTEN_Double>(sites_set[i], 0.1 * i - 0.25));
+    zres.push_back(
+        MeasuResElem<GQTEN_Complex>(sites_set[i], GQTEN_Complex(0.3 * i, -1.0 / (i + 1)))
+    );
+  }
+  RunTestMeasuResBinaryIOCase(dres);
+  RunTestMeasuResBinaryIOCase(zres);
+  RunTestMeasuResBinaryIOCase(MeasuRes<GQTEN_Double>());
+
+  // The binary output of the measurements.
+  DirectStateInitMps(dmps, stat_labs2, qn0);
+  std::vector<std::vector<size_t>> two_site_sites_set = {{3, 5}, {0, 4}, {1, 2}};
+  auto measu_res = MeasureTwoSiteOp(
+                       dmps, {dntot, dntot}, did, two_site_sites_set, "op1op2",
+                       2, MEASU_RES_BINARY
+                   );
+  RunTestMeasuResBinaryIOCase(measu_res);
+  auto loaded_measu_res = LoadMeasuResBinary<GQTEN_Double>("op1op2");
+  for (size_t i = 0; i < measu_res.size(); ++i) {
+    EXPECT_EQ(loaded_measu_res[i].sites, measu_res[i].sites);
+    EXPECT_EQ(loaded_measu_res[i].avg, measu_res[i].avg);
+  }
+}
+
+
 //struct TestNonUniformMpsMeasurement : public testing::Test {
   //long N = 4; //unit cell number, A-B-A-B-A-B-A-B
 
@@ -244,3 +244,271 @@ TEST_F(TestMpoGenerator, TestAddTermCase6) {
   EXPECT_EQ(fsm_comp_mat_repr[1], bchmk_m1);
   EXPECT_EQ(fsm_comp_mat_repr[2], bchmk_m2);
 }
+
+
+// Contract all the MPO tensors to the operator on the whole chain.
+template <typename TenT>
+TenT CtrctMPOToFullOp(const MPO<TenT> &mpo) {
+  auto N = mpo.size();
+  auto full_op = mpo[0];
+  for (size_t i = 1; i < N; ++i) {
+    TenT temp;
+    size_t rvb_axe = full_op.Rank() - 1;
+    if (i == 1) { rvb_axe = 1; }
+    if (i == N - 1) {
+      Contract(&full_op, &mpo[i], {{rvb_axe}, {1}}, &temp);
+    } else {
+      Contract(&full_op, &mpo[i], {{rvb_axe}, {0}}, &temp);
+    }
+    full_op = temp;
+  }
+  return full_op;
+}
+
+
+TEST_F(TestMpoGenerator, TestCompressMPO) {
+  // Exponentially decaying Ising couplings, the exact MPO bond dimensions are
+  // 2 on the boundary bonds and 3 on the others.
+  size_t N = 5;
+  DMPOGenerator mpo_generator(dsite_vec_5, qn0);
+  for (size_t i = 0; i < N; ++i) {
+    for (size_t j = i + 1; j < N; ++j) {
+      mpo_generator.AddTerm(std::pow(0.5, j - i), {dsz, dsz}, {i, j});
+    }
+  }
+  auto mpo = mpo_generator.Gen();
+  auto comp_mpo = mpo;
+  auto discarded_weight = CompressMPO(comp_mpo, 1.0E-14, 1, 100);
+  EXPECT_LT(discarded_weight, 1.0E-12);
+  EXPECT_EQ(comp_mpo[0].GetIndexes()[1].dim(), 2);
+  for (size_t i = 1; i < N - 2; ++i) {
+    EXPECT_EQ(comp_mpo[i].GetIndexes()[3].dim(), 3);
+    EXPECT_LE(comp_mpo[i].GetIndexes()[3].dim(), mpo[i].GetIndexes()[3].dim());
+  }
+  EXPECT_EQ(comp_mpo[N-1].GetIndexes()[1].dim(), 2);
+
+  auto full_op = CtrctMPOToFullOp(mpo);
+  auto comp_full_op = CtrctMPOToFullOp(comp_mpo);
+  EXPECT_EQ(comp_full_op.GetShape(), full_op.GetShape());
+  for (auto &coors : GenAllCoors(full_op.GetShape())) {
+    EXPECT_NEAR(comp_full_op.GetElem(coors), full_op.GetElem(coors), 1.0E-12);
+  }
+}
+
+
+// <up ... up|H|up ... up> of a real MPO, the matrices of the up-up elements are
+// multiplied from the left end, so it works for long chains.
+inline GQTEN_Double CtrctMPOAllUpElem(const MPO<DGQTensor> &mpo) {
+  auto N = mpo.size();
+  std::vector<GQTEN_Double> lvec;
+  for (size_t j = 0; j < mpo[0].GetShape()[1]; ++j) {
+    lvec.push_back(mpo[0].GetElem({1, j, 1}));
+  }
+  for (size_t i = 1; i < N - 1; ++i) {
+    auto shape = mpo[i].GetShape();
+    std::vector<GQTEN_Double> next_lvec(shape[3], 0);
+    for (size_t l = 0; l < shape[0]; ++l) {
+      for (size_t r = 0; r < shape[3]; ++r) {
+        next_lvec[r] += lvec[l] * mpo[i].GetElem({l, 1, 1, r});
+      }
+    }
+    lvec = next_lvec;
+  }
+  GQTEN_Double avg = 0;
+  for (size_t l = 0; l < lvec.size(); ++l) {
+    avg += lvec[l] * mpo[N-1].GetElem({1, l, 1});
+  }
+  return avg;
+}
+
+
+TEST_F(TestMpoGenerator, TestCompressLongMPO) {
+  // The Frobenius norm of the Ising chain MPO is about 2^(N/2), which overflows
+  // the double precision if it is piled up in one tensor.
+  size_t N = 2200;
+  DSiteVec site_vec(N, phys_idx_out);
+  DMPOGenerator mpo_generator(site_vec, qn0);
+  for (size_t i = 0; i < N - 1; ++i) {
+    mpo_generator.AddTerm(1.0, {dsz, dsz}, {i, i + 1});
+  }
+  auto mpo = mpo_generator.Gen();
+  auto discarded_weight = CompressMPO(mpo, 1.0E-14, 1, 100);
+  EXPECT_LT(discarded_weight, 1.0E-12);
+  for (size_t i = 0; i < N; ++i) {
+    EXPECT_TRUE(std::isfinite(mpo[i].Get2Norm()));
+  }
+
+  // <up ... up|H|up ... up> = (N - 1) / 4.
+  auto avg = CtrctMPOAllUpElem(mpo);
+  EXPECT_NEAR(avg, (N - 1) / 4.0, 1.0E-8 * N);
+}
+
+
+TEST_F(TestMpoGenerator, TestAddLongRangeTerm) {
+  // A sum of two exponentials is fitted exactly by two middle states per bond.
+  size_t N = 5;
+  auto coupling = [](const size_t r) {
+    return std::pow(0.5, r) - 0.3 * std::pow(-0.8, r);
+  };
+  DMPOGenerator mpo_generator(dsite_vec_5, qn0);
+  auto fit_err = mpo_generator.AddLongRangeTerm(coupling, dsz, dsz);
+  EXPECT_LT(fit_err, 1.0E-12);
+  auto mpo = mpo_generator.Gen();
+  for (size_t i = 1; i < N - 1; ++i) {
+    EXPECT_LE(mpo[i].GetIndexes()[3].dim(), 4);
+  }
+
+  DMPOGenerator bchmk_mpo_generator(dsite_vec_5, qn0);
+  for (size_t i = 0; i < N; ++i) {
+    for (size_t j = i + 1; j < N; ++j) {
+      bchmk_mpo_generator.AddTerm(coupling(j - i), {dsz, dsz}, {i, j});
+    }
+  }
+  auto bchmk_mpo = bchmk_mpo_generator.Gen();
+
+  auto full_op = CtrctMPOToFullOp(mpo);
+  auto bchmk_full_op = CtrctMPOToFullOp(bchmk_mpo);
+  EXPECT_EQ(full_op.GetShape(), bchmk_full_op.GetShape());
+  for (auto &coors : GenAllCoors(full_op.GetShape())) {
+    EXPECT_NEAR(full_op.GetElem(coors), bchmk_full_op.GetElem(coors), 1.0E-12);
+  }
+}
+
+
+TEST_F(TestMpoGenerator, TestAddLongRangeTermLongChain) {
+  // The bond dimension is K + 2 at most: the ready state, the final state and
+  // K middle states.
+  size_t N = 50;
+  DSiteVec site_vec(N, phys_idx_out);
+  auto coupling = [](const size_t r) {
+    return std::pow(0.5, r) - 0.3 * std::pow(-0.8, r);
+  };
+  DMPOGenerator mpo_generator(site_vec, qn0);
+  auto fit_err = mpo_generator.AddLongRangeTerm(coupling, dsz, dsz);
+  EXPECT_LT(fit_err, 1.0E-10);
+  auto mpo = mpo_generator.Gen();
+  for (size_t i = 1; i < N - 1; ++i) {
+    EXPECT_LE(mpo[i].GetIndexes()[3].dim(), 2 + 2);
+  }
+  GQTEN_Double bchmk_avg = 0;
+  for (size_t r = 1; r < N; ++r) { bchmk_avg += (N - r) * coupling(r) / 4; }
+  EXPECT_NEAR(CtrctMPOAllUpElem(mpo), bchmk_avg, 1.0E-10);
+
+  // A power law can not be fitted by 4 exponentials to the tolerance, the fit
+  // keeps K = 4 and warns.
+  auto power_law = [](const size_t r) { return 1.0 / (r * r); };
+  size_t max_K = 4;
+  DMPOGenerator power_law_mpo_generator(site_vec, qn0);
+  testing::internal::CaptureStdout();
+  auto power_law_fit_err = power_law_mpo_generator.AddLongRangeTerm(
+                               power_law, dsz, dsz, DGQTensor(), 1.0E-10, max_K
+                           );
+  auto output = testing::internal::GetCapturedStdout();
+  EXPECT_GT(power_law_fit_err, 1.0E-10);
+  EXPECT_NE(output.find("warning"), std::string::npos);
+  auto power_law_mpo = power_law_mpo_generator.Gen();
+  for (size_t i = 1; i < N - 1; ++i) {
+    EXPECT_LE(power_law_mpo[i].GetIndexes()[3].dim(), max_K + 2);
+  }
+  bchmk_avg = 0;
+  for (size_t r = 1; r < N; ++r) { bchmk_avg += (N - r) * power_law(r) / 4; }
+  EXPECT_NEAR(CtrctMPOAllUpElem(power_law_mpo), bchmk_avg, N * N * power_law_fit_err);
+}
+
+
+TEST_F(TestMpoGenerator, TestParallelGen) {
+  ZMPOGenerator mpo_generator(zsite_vec_5, qn0);
+  for (size_t i = 0; i < 4; ++i) {
+    mpo_generator.AddTerm(0.5, zsx, i, zsx, i + 1);
+    mpo_generator.AddTerm(0.5, zsy, i, zsy, i + 1);
+    mpo_generator.AddTerm(1.0, zsz, i, zsz, i + 1);
+  }
+  mpo_generator.AddTerm(0.2, zsz, 0, zsz, 4);
+  auto mpo = mpo_generator.Gen();
+  auto parallel_mpo = mpo_generator.Gen(4);
+  for (size_t i = 0; i < 5; ++i) {
+    EXPECT_EQ(parallel_mpo[i], mpo[i]);
+  }
+}
+
+
+TEST(TestFNV1aHasher, TestHexDigest) {
+  FNV1aHasher hasher;
+  EXPECT_EQ(hasher.HexDigest(), "cbf29ce484222325");
+  hasher.Update(std::string("a"));
+  EXPECT_EQ(hasher.HexDigest(), "af63dc4c8601ec8c");
+}
+
+
+inline void RemoveFolder(const std::string &folder_path) {
+  std::string command = "rm -rf " + folder_path;
+  system(command.c_str());
+}
+
+
+TEST_F(TestMpoGenerator, TestGenWithCache) {
+  auto add_terms = [this](DMPOGenerator &mpo_generator, const double j2) {
+    for (size_t i = 0; i < 3; ++i) {
+      mpo_generator.AddTerm(1.0, dsz, i, dsz, i + 1);
+    }
+    mpo_generator.AddTerm(j2, dsz, 0, dsz, 2);
+  };
+  DMPOGenerator mpo_generator(dsite_vec_4, qn0);
+  add_terms(mpo_generator, 0.5);
+  DMPOGenerator same_mpo_generator(dsite_vec_4, qn0);
+  add_terms(same_mpo_generator, 0.5);
+  DMPOGenerator other_mpo_generator(dsite_vec_4, qn0);
+  add_terms(other_mpo_generator, 0.6);
+  EXPECT_EQ(mpo_generator.Fingerprint(), same_mpo_generator.Fingerprint());
+  EXPECT_NE(mpo_generator.Fingerprint(), other_mpo_generator.Fingerprint());
+
+  // Start from an empty cache, so the first call really generates the MPO.
+  std::string cache_path = "mpo_cache";
+  RemoveFolder(cache_path);
+  auto mpo = mpo_generator.GenWithCache(cache_path);
+  EXPECT_TRUE(IsPathExist(cache_path + "/" + mpo_generator.Fingerprint()));
+  auto loaded_mpo = same_mpo_generator.GenWithCache(cache_path);
+  for (size_t i = 0; i < 4; ++i) {
+    EXPECT_EQ(loaded_mpo[i], mpo[i]);
+  }
+  RemoveFolder(cache_path);
+}
+
+
+TEST_F(TestMpoGenerator, TestAnalyzeMPO) {
+  size_t N = 5;
+  DMPOGenerator mpo_generator(dsite_vec_5, qn0);
+  for (size_t i = 0; i < N - 1; ++i) {
+    mpo_generator.AddTerm(1.0, dsz, i, dsz, i + 1);
+  }
+  auto mpo = mpo_generator.Gen();
+  auto report = AnalyzeMPO(mpo, 16);
+  PrintMPOReport(report);
+  EXPECT_EQ(report.size(), N);
+  EXPECT_EQ(report[0].lvb_dim, 1);
+  EXPECT_EQ(report[N-1].rvb_dim, 1);
+  for (size_t i = 0; i < N; ++i) {
+    EXPECT_EQ(report[i].phys_dim, 2);
+    if (i != 0) { EXPECT_EQ(report[i].lvb_dim, report[i-1].rvb_dim); }
+    EXPECT_LE(report[i].nonzero_elem_num, report[i].qnblk_elem_num);
+    EXPECT_LE(report[i].qnblk_elem_num, report[i].elem_num);
+    EXPECT_GT(report[i].ElemDensity(), 0.0);
+    if (i != N - 1) { EXPECT_GT(report[i].matvec_flops, 0.0); }
+  }
+  EXPECT_EQ(report[N-1].matvec_flops, 0.0);
+  // Two-site cost on the sites 1 and 2, the MPS bonds are Dl = 2 and Dr = 4,
+  // d = 2 and w = 3, 2 (Dl^2 Dr d^2 w + Dl Dr d^3 w^2 (rho_1 + rho_2) +
+  // Dl Dr^2 d^2 w).
+  EXPECT_EQ(report[1].lvb_dim, 3);
+  EXPECT_EQ(report[1].rvb_dim, 3);
+  EXPECT_EQ(report[2].rvb_dim, 3);
+  EXPECT_DOUBLE_EQ(
+      report[1].matvec_flops,
+      2 * (4.0 * 4 * 4 * 3 +
+           8.0 * 8 * 9 * (report[1].BlkDensity() + report[2].BlkDensity()) +
+           2.0 * 16 * 4 * 3)
+  );
+
+  // Ising MPO, the bulk tensor holds id, sz, sz and id.
+  EXPECT_EQ(report[2].nonzero_elem_num, 8);
+}
@@ -8,6 +8,8 @@
 #include "gqmps2/one_dim_tn/mpo/mpogen/symb_alg/coef_op_alg.h"
 
 #include <vector>
+#include <algorithm>
+#include <functional>
 
 #include "gtest/gtest.h"
 
@@ -113,6 +115,7 @@ TEST(TestCoefRepr, Initialization) {
 
   auto rand_coef_labels = RandVec(5);
   CoefRepr rand_coef_repr(rand_coef_labels);
+  std::sort(rand_coef_labels.begin(), rand_coef_labels.end());
   EXPECT_EQ(rand_coef_repr.GetCoefLabelList(), rand_coef_labels);
 }
 
@@ -123,6 +126,8 @@ void RunTestCoefReprEquivalentCase(size_t size) {
   CoefRepr coef_repr1a(rand_coef_labels1);
   CoefRepr coef_repr1b(rand_coef_labels1_inv);
   EXPECT_EQ(coef_repr1a, coef_repr1b);
+  EXPECT_EQ(coef_repr1a.GetCoefLabelList(), coef_repr1b.GetCoefLabelList());
+  EXPECT_EQ(std::hash<CoefRepr>()(coef_repr1a), std::hash<CoefRepr>()(coef_repr1b));
   if (size != 0) {
     auto rand_coef_labels2 = RandVec(size);
     CoefRepr coef_repr2(rand_coef_labels2);
@@ -200,8 +205,21 @@ TEST(TestOpRepr, Initialization){
     rand_op_labels.push_back(rand());
   }
   OpRepr op_repr(rand_coef_reprs, rand_op_labels);
-  EXPECT_EQ(op_repr.GetCoefReprList(), rand_coef_reprs);
-  EXPECT_EQ(op_repr.GetOpLabelList(), rand_op_labels);
+  // The terms are sorted by the operator labels.
+  std::vector<size_t> term_idxs = {0, 1, 2, 3, 4};
+  std::sort(
+      term_idxs.begin(), term_idxs.end(),
+      [&rand_op_labels](const size_t i, const size_t j) {
+        return rand_op_labels[i] < rand_op_labels[j];
+      });
+  std::vector<CoefRepr> sorted_coef_reprs;
+  std::vector<OpLabel> sorted_op_labels;
+  for (auto i : term_idxs) {
+    sorted_coef_reprs.push_back(rand_coef_reprs[i]);
+    sorted_op_labels.push_back(rand_op_labels[i]);
+  }
+  EXPECT_EQ(op_repr.GetCoefReprList(), sorted_coef_reprs);
+  EXPECT_EQ(op_repr.GetOpLabelList(), sorted_op_labels);
 
   auto coef1 = RandCoefRepr();
   auto coef2 = RandCoefRepr();
@@ -210,11 +228,11 @@ TEST(TestOpRepr, Initialization){
   EXPECT_EQ(op1.GetCoefReprList(), CoefReprVec({coef1+coef2}));
   EXPECT_EQ(op1.GetOpLabelList(), std::vector<OpLabel>({op_label1}));
 
-  OpLabel op_label2 = rand() + 1;
-  OpRepr op2(std::vector<OpLabel>({op_label1, op_label1, op_label2}));
+  OpLabel op_label2 = op_label1 + 1;
+  OpRepr op2(std::vector<OpLabel>({op_label2, op_label1, op_label2}));
   EXPECT_EQ(
       op2.GetCoefReprList(),
-      CoefReprVec({kIdCoefRepr+kIdCoefRepr, kIdCoefRepr}));
+      CoefReprVec({kIdCoefRepr, kIdCoefRepr+kIdCoefRepr}));
   EXPECT_EQ(op2.GetOpLabelList(), std::vector<OpLabel>({op_label1, op_label2}));
 }
 
@@ -230,6 +248,7 @@ void RunTestOpReprEquivalentCase(size_t size) {
   OpRepr op_repr1b(coef_list1_inv, rand_vec1b_inv);
   EXPECT_EQ(op_repr1a, op_repr1a);
   EXPECT_EQ(op_repr1a, op_repr1b);
+  EXPECT_EQ(std::hash<OpRepr>()(op_repr1a), std::hash<OpRepr>()(op_repr1b));
   if (size != 0) {
     auto rand_vec2a = RandVec(size);
     auto rand_vec2b = RandVec(size);
@@ -274,6 +293,9 @@ void RunTestOpReprAddCase1(size_t lhs_size, size_t rhs_size) {
   OpRepr added_op_repr(added_rand_coef_reprs, added_rand_op_labels);
   EXPECT_EQ(lhs_op_repr + rhs_op_repr, added_op_repr);
   EXPECT_EQ(rhs_op_repr + lhs_op_repr, added_op_repr);
+  EXPECT_EQ(
+      (lhs_op_repr + rhs_op_repr).GetOpLabelList(),
+      (rhs_op_repr + lhs_op_repr).GetOpLabelList());
 }
 
 
@@ -314,10 +336,11 @@ void RunTestSparCoefReprMatInitializationCase(size_t row_num, size_t col_num) {
   EXPECT_EQ(spar_mat.rows, row_num);
   EXPECT_EQ(spar_mat.cols, col_num);
   EXPECT_TRUE(spar_mat.data.empty());
-  auto size = row_num * col_num;
-  auto indexes = spar_mat.indexes;
-  EXPECT_EQ(indexes.size(), size);
-  for (size_t i = 0; i < size; ++i) { EXPECT_EQ(indexes[i], -1); }
+  EXPECT_EQ(spar_mat.nnz(), 0);
+  EXPECT_EQ(spar_mat.row_adjs.size(), row_num);
+  EXPECT_EQ(spar_mat.col_adjs.size(), col_num);
+  for (size_t x = 0; x < row_num; ++x) { EXPECT_TRUE(spar_mat.GetRowAdj(x).empty()); }
+  for (size_t y = 0; y < col_num; ++y) { EXPECT_TRUE(spar_mat.GetColAdj(y).empty()); }
 }
 
 
@@ -326,7 +349,7 @@ TEST(TestSparCoefReprMat, Initialization) {
   EXPECT_EQ(null_coef_repr_mat.rows, 0);
   EXPECT_EQ(null_coef_repr_mat.cols, 0);
   EXPECT_TRUE(null_coef_repr_mat.data.empty());
-  EXPECT_TRUE(null_coef_repr_mat.indexes.empty());
+  EXPECT_EQ(null_coef_repr_mat.nnz(), 0);
 
   RunTestSparCoefReprMatInitializationCase(1, 1);
   RunTestSparCoefReprMatInitializationCase(5, 1);
@@ -449,12 +472,11 @@ void RunTestSparCoefReprMatRemoveRowAndColCase(
     auto new_rows = row_num - 1;
     EXPECT_EQ(spar_mat_to_rmv_row.rows, new_rows);
     EXPECT_EQ(spar_mat_to_rmv_row.cols, col_num);
-    auto new_size = new_rows * col_num;
-    EXPECT_EQ(spar_mat_to_rmv_row.indexes, std::vector<long>(new_size, -1));
+    EXPECT_EQ(spar_mat_to_rmv_row.nnz(), 0);
   } else {
     EXPECT_EQ(spar_mat_to_rmv_row.rows, 0);
     EXPECT_EQ(spar_mat_to_rmv_row.cols, 0);
-    EXPECT_TRUE(spar_mat_to_rmv_row.indexes.empty());
+    EXPECT_EQ(spar_mat_to_rmv_row.nnz(), 0);
   }
 
   auto spar_mat_to_rmv_col = spar_mat;
@@ -463,12 +485,11 @@ void RunTestSparCoefReprMatRemoveRowAndColCase(
     auto new_cols = col_num - 1;
     EXPECT_EQ(spar_mat_to_rmv_col.rows, row_num);
     EXPECT_EQ(spar_mat_to_rmv_col.cols, new_cols);
-    auto new_size = row_num * new_cols;
-    EXPECT_EQ(spar_mat_to_rmv_col.indexes, std::vector<long>(new_size, -1));
+    EXPECT_EQ(spar_mat_to_rmv_col.nnz(), 0);
   } else {
     EXPECT_EQ(spar_mat_to_rmv_col.rows, 0);
     EXPECT_EQ(spar_mat_to_rmv_col.cols, 0);
-    EXPECT_TRUE(spar_mat_to_rmv_col.indexes.empty());
+    EXPECT_EQ(spar_mat_to_rmv_col.nnz(), 0);
   }
 }
 
@@ -484,6 +505,39 @@ TEST(TestSparCoefReprMat, RemoveRowAndCol) {
 }
 
 
+TEST(TestSparCoefReprMat, RemoveRowsAndCols) {
+  SparCoefReprMat spar_mat(4, 3);
+  auto coef1 = RandCoefRepr();
+  auto coef2 = RandCoefRepr();
+  auto coef3 = RandCoefRepr();
+  spar_mat.SetElem(0, 0, coef1);
+  spar_mat.SetElem(1, 1, coef2);
+  spar_mat.SetElem(3, 2, coef3);
+
+  auto spar_mat_to_rmv_rows = spar_mat;
+  spar_mat_to_rmv_rows.RemoveRows({1, 2});
+  SparCoefReprMat bchmk_mat1(2, 3);
+  bchmk_mat1.SetElem(0, 0, coef1);
+  bchmk_mat1.SetElem(1, 2, coef3);
+  EXPECT_EQ(spar_mat_to_rmv_rows, bchmk_mat1);
+  EXPECT_EQ(spar_mat_to_rmv_rows.nnz(), 2);
+  EXPECT_EQ(spar_mat_to_rmv_rows.GetColAdj(1).size(), 0);
+  EXPECT_EQ(spar_mat_to_rmv_rows.GetColAdj(2)[0].idx, 1);
+
+  auto spar_mat_to_rmv_cols = spar_mat;
+  spar_mat_to_rmv_cols.RemoveCols({0, 1});
+  SparCoefReprMat bchmk_mat2(4, 1);
+  bchmk_mat2.SetElem(3, 0, coef3);
+  EXPECT_EQ(spar_mat_to_rmv_cols, bchmk_mat2);
+  EXPECT_EQ(spar_mat_to_rmv_cols.GetRowAdj(3)[0].idx, 0);
+
+  auto spar_mat_to_rmv_all = spar_mat;
+  spar_mat_to_rmv_all.RemoveCols({0, 1, 2});
+  EXPECT_EQ(spar_mat_to_rmv_all.rows, 0);
+  EXPECT_EQ(spar_mat_to_rmv_all.cols, 0);
+}
+
+
 void RunTestSparCoefReprMatSwapTwoRowsAndColsCase(
     const size_t row_num, const size_t col_num) {
   SparCoefReprMat spar_mat(row_num, col_num);
@@ -561,10 +615,11 @@ void RunTestSparOpReprMatInitializationCase(size_t row_num, size_t col_num) {
   EXPECT_EQ(spar_mat.rows, row_num);
   EXPECT_EQ(spar_mat.cols, col_num);
   EXPECT_TRUE(spar_mat.data.empty());
-  auto size = row_num * col_num;
-  auto indexes = spar_mat.indexes;
-  EXPECT_EQ(indexes.size(), size);
-  for (size_t i = 0; i < size; ++i) { EXPECT_EQ(indexes[i], -1); }
+  EXPECT_EQ(spar_mat.nnz(), 0);
+  EXPECT_EQ(spar_mat.row_adjs.size(), row_num);
+  EXPECT_EQ(spar_mat.col_adjs.size(), col_num);
+  for (size_t x = 0; x < row_num; ++x) { EXPECT_TRUE(spar_mat.GetRowAdj(x).empty()); }
+  for (size_t y = 0; y < col_num; ++y) { EXPECT_TRUE(spar_mat.GetColAdj(y).empty()); }
 }
 
 
@@ -573,7 +628,7 @@ TEST(TestSparOpReprMat, Initialization) {
   EXPECT_EQ(null_op_repr_mat.rows, 0);
   EXPECT_EQ(null_op_repr_mat.cols, 0);
   EXPECT_TRUE(null_op_repr_mat.data.empty());
-  EXPECT_TRUE(null_op_repr_mat.indexes.empty());
+  EXPECT_EQ(null_op_repr_mat.nnz(), 0);
 
   RunTestSparOpReprMatInitializationCase(1, 1);
   RunTestSparOpReprMatInitializationCase(5, 1);
@@ -196,12 +196,35 @@ void RunTestAddPathCase5(void) {
 }
 
 
+void RunTestAddPathCase6(void) {
+  // Only the nontrivial span is stored.
+  auto s = OpRepr(1);
+  FSM fsm(6);
+  fsm.AddPath(2, 4, {s, kIdOpRepr, s});
+  auto compact_paths = fsm.GetFSMCompactPaths();
+  EXPECT_EQ(compact_paths.size(), 1);
+  EXPECT_EQ(compact_paths[0].head_site_idx, 2);
+  EXPECT_EQ(compact_paths[0].ntrvl_ops, OpReprVec({s, kIdOpRepr, s}));
+  EXPECT_EQ(compact_paths[0].mid_stat_idxs, std::vector<long>({1, 1}));
+
+  auto paths = fsm.GetFSMPaths();
+  EXPECT_EQ(paths.size(), 1);
+  EXPECT_EQ(
+      paths[0].op_reprs,
+      OpReprVec({kIdOpRepr, kIdOpRepr, s, kIdOpRepr, s, kIdOpRepr}));
+  EXPECT_EQ(paths[0].fsm_nodes[2].fsm_stat_idx, kFSMReadyStatIdx);
+  EXPECT_EQ(paths[0].fsm_nodes[3].fsm_stat_idx, 1);
+  EXPECT_EQ(paths[0].fsm_nodes[5].fsm_stat_idx, kFSMFinalStatIdx);
+}
+
+
 TEST(TestFSM, TestAddPath) {
   RunTestAddPathCase1();
   RunTestAddPathCase2();
   RunTestAddPathCase3();
   RunTestAddPathCase4();
   RunTestAddPathCase5();
+  RunTestAddPathCase6();
 }
 
 
@@ -334,12 +357,47 @@ void RunTestGenMatReprCase5(void) {
 }
 
 
+void RunTestGenMatReprCase6(void) {
+  // s_i s_j on all the site pairs described by the shared middle states.
+  auto s = OpRepr(1);
+  FSM fsm(3);
+  auto mid1 = fsm.AddMidStat(1);
+  auto mid2 = fsm.AddMidStat(2);
+  EXPECT_EQ(mid1, 1);
+  EXPECT_EQ(mid2, 1);
+  fsm.AddEdge(0, kFSMReadyStatIdx, kFSMReadyStatIdx, kIdOpRepr);
+  fsm.AddEdge(0, kFSMReadyStatIdx, mid1, s);
+  fsm.AddEdge(1, kFSMReadyStatIdx, mid2, s);
+  fsm.AddEdge(1, mid1, mid2, kIdOpRepr);
+  fsm.AddEdge(1, mid1, kFSMFinalStatIdx, s);
+  fsm.AddEdge(2, mid2, kFSMFinalStatIdx, s);
+  fsm.AddEdge(2, kFSMFinalStatIdx, kFSMFinalStatIdx, kIdOpRepr);
+  EXPECT_EQ(fsm.GetFSMEdges().size(), 7);
+  SparOpReprMat bchmk_mat0(1, 2);
+  bchmk_mat0.SetElem(0, 0, kIdOpRepr);
+  bchmk_mat0.SetElem(0, 1, s);
+  SparOpReprMat bchmk_mat1(2, 2);
+  bchmk_mat1.SetElem(0, 1, s);
+  bchmk_mat1.SetElem(1, 0, s);
+  bchmk_mat1.SetElem(1, 1, kIdOpRepr);
+  SparOpReprMat bchmk_mat2(2, 1);
+  bchmk_mat2.SetElem(0, 0, kIdOpRepr);
+  bchmk_mat2.SetElem(1, 0, s);
+
+  auto fsm_mat_repr = fsm.GenMatRepr();
+  EXPECT_EQ(fsm_mat_repr[0], bchmk_mat0);
+  EXPECT_EQ(fsm_mat_repr[1], bchmk_mat1);
+  EXPECT_EQ(fsm_mat_repr[2], bchmk_mat2);
+}
+
+
 TEST(TestFSM, TestGenMatRepr) {
   RunTestGenMatReprCase1();
   RunTestGenMatReprCase2();
   RunTestGenMatReprCase3();
   RunTestGenMatReprCase4();
   RunTestGenMatReprCase5();
+  RunTestGenMatReprCase6();
 }
 
 
@@ -436,7 +494,7 @@ void RunTestGenCompressedMatReprCase5(void) {
   bchmk_m3.SetElem(1, 0, s);
   bchmk_m3.SetElem(1, 1, kIdOpRepr);
   bchmk_m4.SetElem(0, 0, kIdOpRepr);
-  bchmk_m4.SetElem(0, 1, s);
+  bchmk_m4.SetElem(1, 0, s);
   auto fsm_comp_mat_repr = fsm.GenCompressedMatRepr();
   EXPECT_EQ(fsm_comp_mat_repr[0], bchmk_m0);
   EXPECT_EQ(fsm_comp_mat_repr[1], bchmk_m1);
@@ -537,3 +595,29 @@ TEST(TestLabelConvertor, TestConversion) {
 
   EXPECT_EQ(real_coef_label_convertor.Convert(1.), 0);
 }
+
+
+// All the objects fall into the same hash bucket.
+struct CollidingHash {
+  size_t operator()(const double) const { return 0; }
+};
+
+
+TEST(TestLabelConvertor, TestHashedConversion) {
+  auto complex_coef_label_convertor = LabelConvertor<std::complex<double>>(1.0);
+  EXPECT_EQ(complex_coef_label_convertor.Convert({1.0, 0.0}), 0);
+  EXPECT_EQ(complex_coef_label_convertor.Convert({0.0, 1.0}), 1);
+  EXPECT_EQ(complex_coef_label_convertor.Convert({1.0, 1.0}), 2);
+  EXPECT_EQ(complex_coef_label_convertor.Convert({0.0, 1.0}), 1);
+  EXPECT_EQ(complex_coef_label_convertor.GetLabelObjMapping().size(), 3);
+
+  // Objects with the same hash are still distinguished by their values.
+  auto colliding_label_convertor = LabelConvertor<double, CollidingHash>(1.0);
+  for (size_t i = 0; i < 10; ++i) {
+    EXPECT_EQ(colliding_label_convertor.Convert(double(i + 1)), i);
+  }
+  for (size_t i = 10; i > 0; --i) {
+    EXPECT_EQ(colliding_label_convertor.Convert(double(i)), i - 1);
+  }
+  EXPECT_EQ(colliding_label_convertor.GetLabelObjMapping().size(), 10);
+}